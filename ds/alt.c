@@ -0,0 +1,691 @@
+#include "alt.h"
+#include "heap_define.h"
+#include "parallel.h"
+#include <stdatomic.h>
+
+typedef struct alt_entry alt_entry_t;
+
+/**
+ * Heap entries are stored by value and never updated in place: entries
+ * whose distance is no longer the one of their vertex are skipped.
+ */
+struct alt_entry {
+    long key;
+    long distance;
+    int vertex;
+};
+
+#define alt_entry_less(e1, e2) ((e1).key < (e2).key)
+
+HEAP_DEFINE(alt_heap, alt_entry_t, alt_entry_less)
+
+/**
+ * Lower bound of d(u, v) given the first n landmarks of distance arrays
+ * holding k entries per vertex.
+ */
+static inline long
+alt_bound_n(const long *from, const long *to, int k, int n, int u, int v)
+{
+    const long *from_u = from + (size_t)u * k;
+    const long *from_v = from + (size_t)v * k;
+    const long *to_u = to + (size_t)u * k;
+    const long *to_v = to + (size_t)v * k;
+    long bound = 0;
+
+    for (int i = 0; i < n; ++i) {
+        /**
+         * l reaches u but not v, or v reaches l but u doesn't: u cannot
+         * reach v.
+         */
+        if (LONG_MAX != from_u[i]) {
+            if (LONG_MAX == from_v[i]) {
+                return LONG_MAX;
+            }
+            if (from_v[i] - from_u[i] > bound) {
+                bound = from_v[i] - from_u[i];
+            }
+        }
+        if (LONG_MAX != to_v[i]) {
+            if (LONG_MAX == to_u[i]) {
+                return LONG_MAX;
+            }
+            if (to_u[i] - to_v[i] > bound) {
+                bound = to_u[i] - to_v[i];
+            }
+        }
+    }
+    return bound;
+}
+
+long
+alt_bound(const alt_t *alt, int u, int v)
+{
+    return alt_bound_n(alt->from, alt->to, alt->nlandmarks, alt->nlandmarks, u, v);
+}
+
+typedef struct alt_job alt_job_t;
+
+/**
+ * Full Dijkstra from source: distance of v is stored at distance[v * stride],
+ * parent and settle order are optional.
+ */
+struct alt_job {
+    graph_t *graph;
+    int source;
+    long *distance;
+    int stride;
+    int *parent;
+    int *order;
+    int nsettled;
+};
+
+static int
+alt_job_run(alt_job_t *job)
+{
+    graph_t *graph = job->graph;
+    alt_heap_t *h = alt_heap_new(0);
+    alt_entry_t entry = { 0, 0, job->source };
+    size_t stride = job->stride;
+    long *distance = job->distance;
+
+    if (NULL == h) {
+        return -1;
+    }
+
+    for (int v = 0; v < graph->size; ++v) {
+        distance[v * stride] = LONG_MAX;
+        if (NULL != job->parent) {
+            job->parent[v] = -1;
+        }
+    }
+
+    job->nsettled = 0;
+    distance[job->source * stride] = 0;
+    if (0 != alt_heap_insert(h, &entry)) {
+        alt_heap_free(h);
+        return -1;
+    }
+
+    while (NULL != alt_heap_pop_front(h, &entry)) {
+        vertex_t *u = &graph->vertices[entry.vertex];
+        node_t *node = NULL;
+
+        if (entry.distance != distance[entry.vertex * stride]) {
+            continue;
+        }
+        if (NULL != job->order) {
+            job->order[job->nsettled] = entry.vertex;
+        }
+        job->nsettled++;
+
+        list_foreach(u->edges, node) {
+            edge_t *edge = node_data(node);
+            int v = edge_pair_get(edge, u) - graph->vertices;
+            long d = entry.distance + edge->weight;
+
+            if (d < distance[v * stride]) {
+                alt_entry_t next = { d, d, v };
+
+                distance[v * stride] = d;
+                if (NULL != job->parent) {
+                    job->parent[v] = entry.vertex;
+                }
+                if (0 != alt_heap_insert(h, &next)) {
+                    alt_heap_free(h);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    alt_heap_free(h);
+    return 0;
+}
+
+typedef struct alt_jobs alt_jobs_t;
+
+struct alt_jobs {
+    alt_job_t jobs[3];
+    int njobs;
+    atomic_int next;
+    atomic_bool failed;
+};
+
+static void
+alt_jobs_run(void *arg, int id, int nthreads)
+{
+    alt_jobs_t *jobs = arg;
+    int j;
+
+    (void)id;
+    (void)nthreads;
+
+    while ((j = atomic_fetch_add(&jobs->next, 1)) < jobs->njobs) {
+        if (0 != alt_job_run(&jobs->jobs[j])) {
+            atomic_store(&jobs->failed, true);
+        }
+    }
+}
+
+typedef struct alt_builder alt_builder_t;
+
+struct alt_builder {
+    alt_t *alt;
+    int nthreads;
+    int n;                /**< landmarks whose distances are computed */
+    unsigned long seed;
+    long *root_distance;  /**< shortest path tree from root (avoid) */
+    int *parent;
+    int *order;
+    long *weight;
+    char *covered;        /**< subtree holds a landmark */
+    int *best;            /**< heaviest uncovered child */
+    int *candidate;       /**< per thread best vertex (farthest) */
+    long *candidate_distance;
+};
+
+/**
+ * Runs forward and reverse searches of landmark i (if i >= 0) and the
+ * search from root (if root >= 0), in parallel.
+ */
+static int
+alt_builder_search(alt_builder_t *b, int i, int root, int *nsettled)
+{
+    alt_t *alt = b->alt;
+    alt_jobs_t jobs;
+
+    memset(&jobs, 0, sizeof(alt_jobs_t));
+    atomic_init(&jobs.next, 0);
+    atomic_init(&jobs.failed, false);
+
+    if (root >= 0) {
+        alt_job_t *job = &jobs.jobs[jobs.njobs++];
+        job->graph = alt->graph;
+        job->source = root;
+        job->distance = b->root_distance;
+        job->stride = 1;
+        job->parent = b->parent;
+        job->order = b->order;
+    }
+    if (i >= 0) {
+        alt_job_t *job = &jobs.jobs[jobs.njobs++];
+        job->graph = alt->graph;
+        job->source = alt->landmarks[i];
+        job->distance = alt->from + i;
+        job->stride = alt->nlandmarks;
+        if (alt->to != alt->from) {
+            job = &jobs.jobs[jobs.njobs++];
+            job->graph = alt->graph_r;
+            job->source = alt->landmarks[i];
+            job->distance = alt->to + i;
+            job->stride = alt->nlandmarks;
+        }
+    }
+
+    parallel_run(jobs.njobs < b->nthreads ? jobs.njobs : b->nthreads, alt_jobs_run, &jobs);
+
+    if (root >= 0) {
+        *nsettled = jobs.jobs[0].nsettled;
+    }
+    return atomic_load(&jobs.failed) ? -1 : 0;
+}
+
+/**
+ * Finds vertex maximizing its minimum distance from landmarks computed.
+ */
+static void
+alt_farthest_run(void *arg, int id, int nthreads)
+{
+    alt_builder_t *b = arg;
+    alt_t *alt = b->alt;
+    int k = alt->nlandmarks;
+    size_t begin, end;
+
+    b->candidate[id] = -1;
+    b->candidate_distance[id] = -1;
+
+    parallel_range(alt->size, id, nthreads, &begin, &end);
+    for (size_t v = begin; v < end; ++v) {
+        const long *from = alt->from + v * k;
+        long distance = LONG_MAX;
+
+        for (int i = 0; i < b->n; ++i) {
+            if (from[i] < distance) {
+                distance = from[i];
+            }
+        }
+        if (distance > b->candidate_distance[id]) {
+            b->candidate_distance[id] = distance;
+            b->candidate[id] = v;
+        }
+    }
+}
+
+static int
+alt_farthest(alt_builder_t *b)
+{
+    int nthreads = parallel_run(b->nthreads, alt_farthest_run, b);
+    int best = 0;
+
+    for (int id = 1; id < nthreads; ++id) {
+        if (b->candidate_distance[id] > b->candidate_distance[best]) {
+            best = id;
+        }
+    }
+    return b->candidate[best];
+}
+
+/**
+ * Weight of every vertex of the tree: distance from root minus its
+ * lower bound given landmarks computed.
+ */
+static void
+alt_weight_run(void *arg, int id, int nthreads)
+{
+    alt_builder_t *b = arg;
+    alt_t *alt = b->alt;
+    int root = b->order[0];
+    size_t begin, end;
+
+    parallel_range(alt->size, id, nthreads, &begin, &end);
+    for (size_t v = begin; v < end; ++v) {
+        long bound;
+
+        if (LONG_MAX == b->root_distance[v]) {
+            continue;
+        }
+        bound = alt_bound_n(alt->from, alt->to, alt->nlandmarks, b->n, root, v);
+        b->weight[v] = b->root_distance[v] - (LONG_MAX == bound ? 0 : bound);
+    }
+}
+
+/**
+ * Leaf reached from the root of the heaviest subtree free of landmarks,
+ * following its heaviest children, -1 if every subtree holds one.
+ */
+static int
+alt_avoid(alt_builder_t *b, int nsettled)
+{
+    alt_t *alt = b->alt;
+    int top = -1;
+    int v;
+
+    parallel_run(b->nthreads, alt_weight_run, b);
+
+    for (int j = 0; j < nsettled; ++j) {
+        v = b->order[j];
+        b->covered[v] = 0;
+        b->best[v] = -1;
+    }
+    for (int i = 0; i < b->n; ++i) {
+        b->covered[alt->landmarks[i]] = 1;
+    }
+
+    /**
+     * Children are settled after their parent: accumulate subtree
+     * weights in reverse settle order, weight and cover of a vertex
+     * being final when it's reached. Subtrees holding a landmark weigh
+     * nothing (they're covered).
+     */
+    for (int j = nsettled - 1; j >= 0; --j) {
+        v = b->order[j];
+        if (!b->covered[v] && (-1 == top || b->weight[v] > b->weight[top])) {
+            top = v;
+        }
+        if (0 == j) {
+            break;
+        }
+        if (b->covered[v]) {
+            b->covered[b->parent[v]] = 1;
+        }
+        else {
+            int p = b->parent[v];
+            b->weight[p] += b->weight[v];
+            if (-1 == b->best[p] || b->weight[v] > b->weight[b->best[p]]) {
+                b->best[p] = v;
+            }
+        }
+    }
+
+    if (-1 == top) {
+        return -1;
+    }
+
+    v = top;
+    while (-1 != b->best[v]) {
+        v = b->best[v];
+    }
+    return v;
+}
+
+static int
+alt_random(alt_builder_t *b)
+{
+    b->seed = b->seed * 6364136223846793005UL + 1442695040888963407UL;
+    return (int)((b->seed >> 33) % (unsigned long)b->alt->size);
+}
+
+static void
+alt_builder_free(alt_builder_t *b)
+{
+    free(b->root_distance);
+    free(b->parent);
+    free(b->order);
+    free(b->weight);
+    free(b->covered);
+    free(b->best);
+    free(b->candidate);
+    free(b->candidate_distance);
+}
+
+alt_t *
+alt_build(graph_t *graph, graph_t *graph_r, int nlandmarks, alt_selection_t selection, int nthreads)
+{
+    alt_t *alt = NULL;
+    alt_builder_t b;
+    size_t entries = (size_t)graph->size * nlandmarks;
+    int root = -1;
+    int nsettled = 0;
+
+    if (nlandmarks <= 0 || nlandmarks > graph->size || graph_r->size != graph->size) {
+        return NULL;
+    }
+
+    memset(&b, 0, sizeof(alt_builder_t));
+    b.nthreads = parallel_threads(nthreads);
+    b.seed = graph->size;
+
+    alt = calloc(1, sizeof(alt_t));
+    if (NULL == alt) {
+        return NULL;
+    }
+
+    alt->graph = graph;
+    alt->graph_r = graph_r;
+    alt->size = graph->size;
+    alt->nlandmarks = nlandmarks;
+    alt->landmarks = malloc(nlandmarks * sizeof(int));
+    alt->from = malloc(entries * sizeof(long));
+    alt->to = graph_r == graph ? alt->from : malloc(entries * sizeof(long));
+    b.alt = alt;
+    b.root_distance = malloc(graph->size * sizeof(long));
+    b.parent = malloc(graph->size * sizeof(int));
+    b.order = malloc(graph->size * sizeof(int));
+    b.weight = malloc(graph->size * sizeof(long));
+    b.covered = malloc(graph->size);
+    b.best = malloc(graph->size * sizeof(int));
+    b.candidate = malloc(b.nthreads * sizeof(int));
+    b.candidate_distance = malloc(b.nthreads * sizeof(long));
+
+    if (NULL == alt->landmarks || NULL == alt->from || NULL == alt->to ||
+        NULL == b.root_distance || NULL == b.parent || NULL == b.order || NULL == b.weight ||
+        NULL == b.covered || NULL == b.best || NULL == b.candidate || NULL == b.candidate_distance) {
+        goto error;
+    }
+
+    /**
+     * First landmark is the vertex farthest from a random root, for
+     * both strategies. Then searches of landmark i - 1 run along with
+     * the tree of the root used to pick landmark i.
+     */
+    root = alt_random(&b);
+    if (0 != alt_builder_search(&b, -1, root, &nsettled)) {
+        goto error;
+    }
+
+    for (int i = 0; i < nlandmarks; ++i) {
+        int landmark = -1;
+
+        if (0 == i || ALT_FARTHEST == selection) {
+            if (0 == i) {
+                landmark = b.order[nsettled - 1];
+            }
+            else {
+                landmark = alt_farthest(&b);
+            }
+        }
+        else {
+            landmark = alt_avoid(&b, nsettled);
+            if (-1 == landmark) {
+                landmark = alt_farthest(&b);
+            }
+        }
+
+        /**
+         * Landmarks collide only if every vertex already is one.
+         */
+        alt->landmarks[i] = landmark;
+
+        root = ALT_AVOID == selection && i + 1 < nlandmarks ? alt_random(&b) : -1;
+        if (0 != alt_builder_search(&b, i, root, &nsettled)) {
+            goto error;
+        }
+        b.n = i + 1;
+    }
+
+    alt_builder_free(&b);
+    return alt;
+
+error:
+    alt_builder_free(&b);
+    alt_free(alt);
+    return NULL;
+}
+
+void
+alt_free(alt_t *alt)
+{
+    if (NULL != alt) {
+        if (alt->to != alt->from) {
+            free(alt->to);
+        }
+        free(alt->from);
+        free(alt->landmarks);
+        free(alt);
+    }
+}
+
+long
+alt_distance(const alt_t *alt, graph_search_t *search, int s, int t)
+{
+    graph_t *graph = alt->graph;
+    alt_heap_t *h = alt_heap_new(0);
+    alt_entry_t entry = { 0, 0, s };
+    long distance = -1;
+
+    if (NULL == h) {
+        return -1;
+    }
+
+    graph_search_reset(search);
+
+    entry.key = alt_bound(alt, s, t);
+    if (LONG_MAX == entry.key || 0 != alt_heap_insert(h, &entry)) {
+        goto out;
+    }
+    graph_search_vertex(search, s)->distance = 0;
+
+    while (NULL != alt_heap_pop_front(h, &entry)) {
+        search_vertex_t *su = graph_search_vertex(search, entry.vertex);
+        vertex_t *u = &graph->vertices[entry.vertex];
+        node_t *node = NULL;
+
+        if (su->visited || entry.distance != su->distance) {
+            continue;
+        }
+        su->visited = 1;
+
+        if (entry.vertex == t) {
+            distance = entry.distance;
+            break;
+        }
+
+        list_foreach(u->edges, node) {
+            edge_t *edge = node_data(node);
+            int v = edge_pair_get(edge, u) - graph->vertices;
+            search_vertex_t *sv = graph_search_vertex(search, v);
+            long d = entry.distance + edge->weight;
+            long bound;
+
+            if (sv->visited || d >= sv->distance) {
+                continue;
+            }
+            bound = alt_bound(alt, v, t);
+            if (LONG_MAX == bound) {
+                continue;
+            }
+
+            sv->distance = d;
+            sv->parent = entry.vertex;
+            alt_entry_t next = { d + bound, d, v };
+            if (0 != alt_heap_insert(h, &next)) {
+                goto out;
+            }
+        }
+    }
+
+out:
+    alt_heap_free(h);
+    return distance;
+}
+
+/**
+ * Doubled average potential of v for the forward search: bound of
+ * d(v, t) minus bound of d(s, v). Reverse search uses its opposite.
+ */
+static inline long
+alt_potential(const alt_t *alt, int s, int t, int v, bool *pruned)
+{
+    long to_t = alt_bound(alt, v, t);
+    long from_s = alt_bound(alt, s, v);
+
+    *pruned = LONG_MAX == to_t || LONG_MAX == from_s;
+    return *pruned ? 0 : to_t - from_s;
+}
+
+/**
+ * Settles top vertex of one direction, updating best distance mu found
+ * through vertices reached by the other direction.
+ */
+static int
+alt_bidirectional_step(const alt_t *alt, graph_t *graph, alt_heap_t *h, graph_search_t *search,
+                       graph_search_t *search_o, int s, int t, long sign, long *mu)
+{
+    alt_entry_t entry = { 0, 0, -1 };
+    search_vertex_t *su = NULL;
+    node_t *node = NULL;
+    vertex_t *u;
+
+    do {
+        if (NULL == alt_heap_pop_front(h, &entry)) {
+            return 0;
+        }
+        su = graph_search_vertex(search, entry.vertex);
+    } while (su->visited || entry.distance != su->distance);
+
+    su->visited = 1;
+    u = &graph->vertices[entry.vertex];
+
+    list_foreach(u->edges, node) {
+        edge_t *edge = node_data(node);
+        int v = edge_pair_get(edge, u) - graph->vertices;
+        search_vertex_t *sv = graph_search_vertex(search, v);
+        long dv_o = graph_search_vertex(search_o, v)->distance;
+        long d = entry.distance + edge->weight;
+        long potential;
+        bool pruned;
+
+        if (LONG_MAX != dv_o && d + dv_o < *mu) {
+            *mu = d + dv_o;
+        }
+        if (sv->visited || d >= sv->distance) {
+            continue;
+        }
+        potential = alt_potential(alt, s, t, v, &pruned);
+        if (pruned) {
+            continue;
+        }
+
+        sv->distance = d;
+        sv->parent = entry.vertex;
+        alt_entry_t next = { 2 * d + sign * potential, d, v };
+        if (0 != alt_heap_insert(h, &next)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+long
+alt_bidirectional_distance(const alt_t *alt, graph_search_t *search, graph_search_t *search_r, int s, int t)
+{
+    alt_heap_t *h = alt_heap_new(0);
+    alt_heap_t *h_r = alt_heap_new(0);
+    alt_entry_t entry = { 0, 0, s };
+    long mu = LONG_MAX;
+    long potential;
+    bool pruned;
+    bool forward = true;
+
+    graph_search_reset(search);
+    graph_search_reset(search_r);
+
+    if (NULL == h || NULL == h_r) {
+        goto out;
+    }
+
+    potential = alt_potential(alt, s, t, s, &pruned);
+    if (pruned) {
+        goto out;
+    }
+    if (s == t) {
+        mu = 0;
+        goto out;
+    }
+
+    entry.key = potential;
+    graph_search_vertex(search, s)->distance = 0;
+    if (0 != alt_heap_insert(h, &entry)) {
+        goto out;
+    }
+
+    entry.vertex = t;
+    entry.key = -alt_potential(alt, s, t, t, &pruned);
+    graph_search_vertex(search_r, t)->distance = 0;
+    if (0 != alt_heap_insert(h_r, &entry)) {
+        goto out;
+    }
+
+    /**
+     * Keys are doubled reduced distances of both directions: searches
+     * stop once the sum of their smallest keys reaches twice the best
+     * distance found.
+     */
+    while (alt_heap_size(h) > 0 && alt_heap_size(h_r) > 0) {
+        if (LONG_MAX != mu && alt_heap_top(h)->key + alt_heap_top(h_r)->key >= 2 * mu) {
+            break;
+        }
+        if (forward) {
+            if (0 != alt_bidirectional_step(alt, alt->graph, h, search, search_r, s, t, 1, &mu)) {
+                mu = LONG_MAX;
+                break;
+            }
+        }
+        else {
+            if (0 != alt_bidirectional_step(alt, alt->graph_r, h_r, search_r, search, s, t, -1, &mu)) {
+                mu = LONG_MAX;
+                break;
+            }
+        }
+        forward = !forward;
+    }
+
+out:
+    if (NULL != h) {
+        alt_heap_free(h);
+    }
+    if (NULL != h_r) {
+        alt_heap_free(h_r);
+    }
+    return LONG_MAX == mu ? -1 : mu;
+}
@@ -0,0 +1,105 @@
+#ifndef _ALT__H_
+#define _ALT__H_
+
+#include "includes.h"
+#include "graph.h"
+
+/**
+ * ALT: A* search, landmarks and triangle inequality.
+ *
+ * Preprocessing picks a few landmark vertices and stores distances from
+ * every landmark to every vertex and back. By the triangle inequality,
+ * d(l, v) - d(l, u) and d(u, l) - d(v, l) are lower bounds of d(u, v) for
+ * every landmark l, the largest of them being the potential A* uses to
+ * drive the search towards the target. Queries settle far fewer vertices
+ * than Dijkstra, mostly on graphs with long shortest paths (road
+ * networks, grids).
+ *
+ * Unlike contraction hierarchies, preprocessing is a few full Dijkstra
+ * searches per landmark, cheap to redo when weights change. Bounds stay
+ * valid as long as weights only increase, so landmark distances only
+ * need to be recomputed after decreases.
+ *
+ * Landmarks are selected either:
+ *
+ *  - farthest: every new landmark is the vertex farthest from the ones
+ *    already picked (unreachable vertices first);
+ *  - avoid: a shortest path tree is grown from a random root, every
+ *    vertex weighing how much the current landmarks underestimate its
+ *    distance from the root; subtrees holding a landmark weigh nothing,
+ *    and the new landmark is the leaf reached from the heaviest subtree
+ *    by following its heaviest children.
+ *
+ * Searches for a landmark (forward and reverse) and the shortest path
+ * tree from the next root run in parallel.
+ */
+
+typedef enum alt_selection alt_selection_t;
+
+enum alt_selection {
+    ALT_FARTHEST = 0,
+    ALT_AVOID    = 1
+};
+
+typedef struct alt alt_t;
+
+struct alt {
+    graph_t *graph;
+    graph_t *graph_r;
+    int size;
+    int nlandmarks;
+    int *landmarks;
+    long *from;  /**< from[v * nlandmarks + i]: d(landmarks[i], v), LONG_MAX if unreachable */
+    long *to;    /**< to[v * nlandmarks + i]: d(v, landmarks[i]), same array as from if graph_r == graph */
+};
+
+/**
+ * Selects landmarks and computes distances to and from them.
+ *
+ * Edges of graph must have non-negative weights.
+ *
+ * @param graph graph to be preprocessed
+ * @param graph_r graph_reverse(graph), or graph itself if undirected
+ * @param nlandmarks number of landmarks (at most graph->size)
+ * @param selection landmark selection strategy
+ * @param nthreads number of threads (<= 0 for number of processors)
+ * @return ALT object or NULL in case of error.
+ */
+alt_t *
+alt_build(graph_t *graph, graph_t *graph_r, int nlandmarks, alt_selection_t selection, int nthreads);
+
+void
+alt_free(alt_t *alt);
+
+/**
+ * Returns lower bound of d(u, v), LONG_MAX if landmarks prove v is not
+ * reachable from u.
+ */
+long
+alt_bound(const alt_t *alt, int u, int v);
+
+/**
+ * Unidirectional A* from s, stops as soon as t is settled.
+ *
+ * Settled vertices are marked visited in search, with their distance
+ * and parent.
+ *
+ * @return weight of a shortest path from s to t, -1 if unreachable.
+ */
+long
+alt_distance(const alt_t *alt, graph_search_t *search, int s, int t);
+
+/**
+ * Bidirectional A*, forward from s on graph and backward from t on
+ * graph_r, both searches using the average of forward and reverse
+ * potentials so that they stay consistent with each other.
+ *
+ * search and search_r are contexts of alt->size vertices, one for each
+ * direction, settled vertices being marked visited.
+ *
+ * @return weight of a shortest path from s to t, -1 if unreachable.
+ */
+long
+alt_bidirectional_distance(const alt_t *alt, graph_search_t *search, graph_search_t *search_r, int s, int t);
+
+#endif /* _ALT__H_ */
@@ -0,0 +1,1462 @@
+#include "ch.h"
+#include "heap_define.h"
+#include "parallel.h"
+#include <stdatomic.h>
+
+#define CH_FILE_MAGIC   0x48435344 /**< "DSCH" */
+#define CH_FILE_VERSION 1
+
+/**
+ * Witness searches give up after settling this many vertices or following
+ * paths of this many arcs: a shortcut might be added even though a witness
+ * exists, which is harmless. Searches that only estimate priorities are
+ * kept much smaller, dense parts of the graph would make them dominate
+ * preprocessing time otherwise.
+ */
+#define CH_WITNESS_SETTLED_MAX   500
+#define CH_WITNESS_HOPS_MAX      5
+#define CH_SIMULATE_SETTLED_MAX  100
+#define CH_SIMULATE_HOPS_MAX     2
+
+typedef enum ch_state ch_state_t;
+
+enum ch_state {
+    CH_ALIVE = 0,
+    CH_CONTRACTING, /**< selected for contraction in current round */
+    CH_CONTRACTED
+};
+
+typedef struct ch_arc ch_arc_t;
+
+struct ch_arc {
+    int target;
+    int middle;
+    long weight;
+};
+
+typedef struct ch_adj ch_adj_t;
+
+struct ch_adj {
+    ch_arc_t *arcs;
+    int size;
+    int capacity;
+};
+
+typedef struct ch_shortcut ch_shortcut_t;
+
+struct ch_shortcut {
+    int source;
+    int target;
+    int middle;
+    long weight;
+};
+
+typedef struct ch_heap_entry ch_heap_entry_t;
+
+struct ch_heap_entry {
+    long key;
+    int vertex;
+    int hops;
+};
+
+#define ch_heap_entry_less(e1, e2) ((e1).key < (e2).key)
+
+HEAP_DEFINE(ch_heap, ch_heap_entry_t, ch_heap_entry_less)
+
+typedef struct ch_worker ch_worker_t;
+
+/**
+ * Per thread state of the preprocessing.
+ */
+struct ch_worker {
+    long *distance;
+    unsigned *stamp;  /**< distance[v] is valid only if stamp[v] == epoch */
+    unsigned *target; /**< vertices witness search looks for have target[v] == epoch */
+    int ntargets;
+    unsigned epoch;
+    ch_heap_t *heap;
+    ch_shortcut_t *shortcuts;
+    size_t nshortcuts;
+    size_t shortcuts_capacity;
+    int *selected;
+    size_t nselected;
+};
+
+typedef struct ch_builder ch_builder_t;
+
+struct ch_builder {
+    int size;
+    ch_adj_t *out;
+    ch_adj_t *in;
+    int *priority;
+    int *deleted;         /**< number of neighbors already contracted */
+    int *level;           /**< 1 + highest level of contracted neighbors */
+    unsigned char *state;
+    int *remaining;       /**< vertices not contracted yet */
+    int nremaining;
+    int *work;            /**< vertices processed by current parallel step */
+    int nwork;
+    int *touched;         /**< round in which vertex last had a neighbor contracted */
+    atomic_size_t next;
+    ch_worker_t *workers;
+    int nworkers;
+};
+
+/**
+ * Adds arc to adjacency, keeping only the lightest one among parallel arcs.
+ */
+static int
+ch_adj_add(ch_adj_t *adj, int target, long weight, int middle)
+{
+    for (int i = 0; i < adj->size; ++i) {
+        if (adj->arcs[i].target == target) {
+            if (weight < adj->arcs[i].weight) {
+                adj->arcs[i].weight = weight;
+                adj->arcs[i].middle = middle;
+            }
+            return 0;
+        }
+    }
+
+    if (adj->size == adj->capacity) {
+        int capacity = adj->capacity ? 2 * adj->capacity : 4;
+        ch_arc_t *arcs = realloc(adj->arcs, capacity * sizeof(ch_arc_t));
+        if (NULL == arcs) {
+            return -1;
+        }
+        adj->arcs = arcs;
+        adj->capacity = capacity;
+    }
+
+    adj->arcs[adj->size].target = target;
+    adj->arcs[adj->size].weight = weight;
+    adj->arcs[adj->size].middle = middle;
+    adj->size++;
+
+    return 0;
+}
+
+static void
+ch_adj_remove(ch_adj_t *adj, int target)
+{
+    for (int i = 0; i < adj->size; ++i) {
+        if (adj->arcs[i].target == target) {
+            adj->arcs[i] = adj->arcs[--adj->size];
+            return;
+        }
+    }
+}
+
+static void
+ch_builder_free(ch_builder_t *b)
+{
+    if (NULL != b) {
+        if (NULL != b->out) {
+            for (int i = 0; i < b->size; ++i) {
+                free(b->out[i].arcs);
+            }
+        }
+        if (NULL != b->in) {
+            for (int i = 0; i < b->size; ++i) {
+                free(b->in[i].arcs);
+            }
+        }
+        if (NULL != b->workers) {
+            for (int i = 0; i < b->nworkers; ++i) {
+                free(b->workers[i].distance);
+                free(b->workers[i].stamp);
+                free(b->workers[i].target);
+                free(b->workers[i].shortcuts);
+                free(b->workers[i].selected);
+                if (NULL != b->workers[i].heap) {
+                    ch_heap_free(b->workers[i].heap);
+                }
+            }
+        }
+        free(b->out);
+        free(b->in);
+        free(b->priority);
+        free(b->deleted);
+        free(b->level);
+        free(b->state);
+        free(b->remaining);
+        free(b->work);
+        free(b->touched);
+        free(b->workers);
+        free(b);
+    }
+}
+
+static ch_builder_t *
+ch_builder_new(graph_t *graph, int nthreads)
+{
+    graph_t *graph_r = NULL;
+    ch_builder_t *b = calloc(1, sizeof(ch_builder_t));
+    int n = graph->size;
+
+    if (NULL == b) {
+        return NULL;
+    }
+
+    b->size = n;
+    b->nworkers = nthreads;
+    b->out = calloc(n, sizeof(ch_adj_t));
+    b->in = calloc(n, sizeof(ch_adj_t));
+    b->priority = calloc(n, sizeof(int));
+    b->deleted = calloc(n, sizeof(int));
+    b->level = calloc(n, sizeof(int));
+    b->state = calloc(n, sizeof(unsigned char));
+    b->remaining = malloc(n * sizeof(int));
+    b->work = malloc(n * sizeof(int));
+    b->touched = malloc(n * sizeof(int));
+    b->workers = calloc(nthreads, sizeof(ch_worker_t));
+
+    if (NULL == b->out || NULL == b->in || NULL == b->priority || NULL == b->deleted || NULL == b->level ||
+        NULL == b->state || NULL == b->remaining || NULL == b->work ||
+        NULL == b->touched || NULL == b->workers) {
+        goto error;
+    }
+
+    for (int i = 0; i < nthreads; ++i) {
+        ch_worker_t *w = &b->workers[i];
+        w->distance = malloc(n * sizeof(long));
+        w->stamp = calloc(n, sizeof(unsigned));
+        w->target = calloc(n, sizeof(unsigned));
+        w->selected = malloc(n * sizeof(int));
+        w->heap = ch_heap_new(0);
+        if (NULL == w->distance || NULL == w->stamp || NULL == w->target || NULL == w->selected || NULL == w->heap) {
+            goto error;
+        }
+    }
+
+    graph_r = graph_reverse(graph);
+    if (NULL == graph_r) {
+        goto error;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        node_t *node = NULL;
+        vertex_t *u = &graph->vertices[i];
+        vertex_t *u_r = &graph_r->vertices[i];
+
+        list_foreach(u->edges, node) {
+            edge_t *edge = node_data(node);
+            int v = edge_pair_get(edge, u)->index;
+            if (v != i && ch_adj_add(&b->out[i], v, edge->weight, -1) < 0) {
+                goto error;
+            }
+        }
+        list_foreach(u_r->edges, node) {
+            edge_t *edge = node_data(node);
+            int v = edge_pair_get(edge, u_r)->index;
+            if (v != i && ch_adj_add(&b->in[i], v, edge->weight, -1) < 0) {
+                goto error;
+            }
+        }
+
+        b->remaining[i] = i;
+        b->touched[i] = -1;
+    }
+    b->nremaining = n;
+
+    graph_free(graph_r);
+
+    return b;
+
+error:
+    graph_free(graph_r);
+    ch_builder_free(b);
+    return NULL;
+}
+
+/**
+ * Strict total order on vertices: priority, ties broken by a hash of
+ * the vertex so that no region of the graph is systematically favored.
+ */
+static inline bool
+ch_less(ch_builder_t *b, int u, int v)
+{
+    unsigned hu = (unsigned)u * 2654435761u;
+    unsigned hv = (unsigned)v * 2654435761u;
+
+    if (b->priority[u] != b->priority[v]) {
+        return b->priority[u] < b->priority[v];
+    }
+    if (hu != hv) {
+        return hu < hv;
+    }
+    return u < v;
+}
+
+static inline long
+ch_worker_distance(ch_worker_t *w, int v)
+{
+    return w->stamp[v] == w->epoch ? w->distance[v] : LONG_MAX;
+}
+
+static inline void
+ch_worker_distance_set(ch_worker_t *w, int v, long distance)
+{
+    w->stamp[v] = w->epoch;
+    w->distance[v] = distance;
+}
+
+static void
+ch_worker_epoch_next(ch_builder_t *b, ch_worker_t *w)
+{
+    if (0 == ++w->epoch) {
+        memset(w->stamp, 0, b->size * sizeof(unsigned));
+        memset(w->target, 0, b->size * sizeof(unsigned));
+        w->epoch = 1;
+    }
+    w->ntargets = 0;
+}
+
+static inline void
+ch_worker_target_add(ch_worker_t *w, int v)
+{
+    if (w->target[v] != w->epoch) {
+        w->target[v] = w->epoch;
+        w->ntargets++;
+    }
+}
+
+/**
+ * Local Dijkstra from source over vertices still in the graph, avoiding
+ * skip (the vertex being contracted).
+ *
+ * Vertices of the current round are contracted at once but, to remain
+ * correct, shortcuts must cover the ones a one by one contraction in
+ * ch_less order would add: witness paths may go through vertices of the
+ * round contracted after skip, never through those contracted before it.
+ * Shortcuts of the latter are not added yet, so witnesses using them are
+ * missed: a round may add a few more shortcuts than a one by one
+ * contraction, never fewer.
+ *
+ * Stops once every target is settled, distances beyond limit are reached
+ * or max_settled vertices are settled. Vertices max_hops arcs away from
+ * source are settled but not expanded.
+ */
+static void
+ch_witness_search(ch_builder_t *b, ch_worker_t *w, int source, int skip, long limit, int max_settled, int max_hops)
+{
+    ch_heap_entry_t entry = { 0, source, 0 };
+    int settled = 0;
+
+    ch_worker_distance_set(w, source, 0);
+    ch_heap_insert(w->heap, &entry);
+
+    while (NULL != ch_heap_pop_front(w->heap, &entry)) {
+        int u = entry.vertex;
+        ch_adj_t *out = &b->out[u];
+
+        if (entry.key > ch_worker_distance(w, u)) {
+            continue;
+        }
+        if (entry.key > limit || ++settled > max_settled) {
+            break;
+        }
+        if (w->target[u] == w->epoch && 0 == --w->ntargets) {
+            break;
+        }
+        if (entry.hops == max_hops) {
+            continue;
+        }
+
+        for (int i = 0; i < out->size; ++i) {
+            int v = out->arcs[i].target;
+            long d = entry.key + out->arcs[i].weight;
+            if (v == skip || CH_CONTRACTED == b->state[v] ||
+                (CH_CONTRACTING == b->state[v] && ch_less(b, v, skip))) {
+                continue;
+            }
+            if (d < ch_worker_distance(w, v)) {
+                ch_worker_distance_set(w, v, d);
+                ch_heap_entry_t next = { d, v, entry.hops + 1 };
+                ch_heap_insert(w->heap, &next);
+            }
+        }
+    }
+
+    ch_heap_clear(w->heap);
+}
+
+static int
+ch_worker_shortcut_add(ch_worker_t *w, int source, int target, int middle, long weight)
+{
+    if (w->nshortcuts == w->shortcuts_capacity) {
+        size_t capacity = w->shortcuts_capacity ? 2 * w->shortcuts_capacity : 64;
+        ch_shortcut_t *shortcuts = realloc(w->shortcuts, capacity * sizeof(ch_shortcut_t));
+        if (NULL == shortcuts) {
+            return -1;
+        }
+        w->shortcuts = shortcuts;
+        w->shortcuts_capacity = capacity;
+    }
+
+    w->shortcuts[w->nshortcuts].source = source;
+    w->shortcuts[w->nshortcuts].target = target;
+    w->shortcuts[w->nshortcuts].middle = middle;
+    w->shortcuts[w->nshortcuts].weight = weight;
+    w->nshortcuts++;
+
+    return 0;
+}
+
+/**
+ * Finds shortcuts needed to contract v.
+ *
+ * When simulating, shortcuts are only counted, otherwise they're stored
+ * in worker's shortcut buffer.
+ *
+ * @return number of shortcuts, -1 on allocation failure.
+ */
+static int
+ch_contract(ch_builder_t *b, ch_worker_t *w, int v, bool simulate)
+{
+    ch_adj_t *in = &b->in[v];
+    ch_adj_t *out = &b->out[v];
+    int max_settled = simulate ? CH_SIMULATE_SETTLED_MAX : CH_WITNESS_SETTLED_MAX;
+    int max_hops = simulate ? CH_SIMULATE_HOPS_MAX : CH_WITNESS_HOPS_MAX;
+    int count = 0;
+
+    for (int i = 0; i < in->size; ++i) {
+        int u = in->arcs[i].target;
+        long limit = -1;
+
+        ch_worker_epoch_next(b, w);
+
+        for (int j = 0; j < out->size; ++j) {
+            if (out->arcs[j].target != u) {
+                ch_worker_target_add(w, out->arcs[j].target);
+                if (in->arcs[i].weight + out->arcs[j].weight > limit) {
+                    limit = in->arcs[i].weight + out->arcs[j].weight;
+                }
+            }
+        }
+        if (limit < 0) {
+            continue;
+        }
+
+        ch_witness_search(b, w, u, v, limit, max_settled, max_hops);
+
+        for (int j = 0; j < out->size; ++j) {
+            int x = out->arcs[j].target;
+            long d = in->arcs[i].weight + out->arcs[j].weight;
+            if (x == u || ch_worker_distance(w, x) <= d) {
+                continue;
+            }
+            ++count;
+            if (!simulate && ch_worker_shortcut_add(w, u, x, v, d) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Priority is twice the edge difference (shortcuts added minus arcs
+ * removed), plus number of neighbors already contracted and level of v in
+ * the hierarchy so far, so that contraction spreads uniformly over the
+ * graph. Lower priority vertices are contracted first.
+ */
+static int
+ch_priority(ch_builder_t *b, ch_worker_t *w, int v)
+{
+    int shortcuts = ch_contract(b, w, v, true);
+    int arcs = b->in[v].size + b->out[v].size;
+
+    return 2 * (shortcuts - arcs) + b->deleted[v] + b->level[v];
+}
+
+static void
+ch_priority_worker(void *arg, int id, int nthreads)
+{
+    ch_builder_t *b = arg;
+    ch_worker_t *w = &b->workers[id];
+    size_t i;
+
+    while ((i = atomic_fetch_add(&b->next, 1)) < (size_t)b->nwork) {
+        int v = b->work[i];
+        b->priority[v] = ch_priority(b, w, v);
+    }
+}
+
+static bool
+ch_adj_less(ch_builder_t *b, int v, ch_adj_t *adj)
+{
+    for (int i = 0; i < adj->size; ++i) {
+        int x = adj->arcs[i].target;
+        if (x != v && !ch_less(b, v, x)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Selects vertices whose priority is lower than that of every vertex
+ * up to two arcs away: no two selected vertices are adjacent, nor share
+ * a neighbor, so short witness paths rarely run into vertices being
+ * contracted in the same round.
+ */
+static void
+ch_select_worker(void *arg, int id, int nthreads)
+{
+    ch_builder_t *b = arg;
+    ch_worker_t *w = &b->workers[id];
+    size_t begin, end;
+
+    w->nselected = 0;
+
+    parallel_range(b->nremaining, id, nthreads, &begin, &end);
+
+    for (size_t i = begin; i < end; ++i) {
+        int v = b->remaining[i];
+        bool selected = ch_adj_less(b, v, &b->out[v]) && ch_adj_less(b, v, &b->in[v]);
+
+        for (int j = 0; j < b->out[v].size && selected; ++j) {
+            int x = b->out[v].arcs[j].target;
+            selected = ch_adj_less(b, v, &b->out[x]) && ch_adj_less(b, v, &b->in[x]);
+        }
+        for (int j = 0; j < b->in[v].size && selected; ++j) {
+            int x = b->in[v].arcs[j].target;
+            selected = ch_adj_less(b, v, &b->out[x]) && ch_adj_less(b, v, &b->in[x]);
+        }
+        if (selected) {
+            w->selected[w->nselected++] = v;
+        }
+    }
+}
+
+static void
+ch_contract_worker(void *arg, int id, int nthreads)
+{
+    ch_builder_t *b = arg;
+    ch_worker_t *w = &b->workers[id];
+    size_t i;
+
+    w->nshortcuts = 0;
+
+    while ((i = atomic_fetch_add(&b->next, 1)) < (size_t)b->nwork) {
+        if (ch_contract(b, w, b->work[i], false) < 0) {
+            w->nshortcuts = (size_t)-1;
+            return;
+        }
+    }
+}
+
+static void
+ch_touch(ch_builder_t *b, int x, int v, int round)
+{
+    b->deleted[x]++;
+    if (b->level[x] < b->level[v] + 1) {
+        b->level[x] = b->level[v] + 1;
+    }
+    if (b->touched[x] != round) {
+        b->touched[x] = round;
+        b->work[b->nwork++] = x;
+    }
+}
+
+/**
+ * Contracts all vertices in work: inserts shortcuts found by workers,
+ * removes contracted vertices from adjacency of their neighbors, and
+ * leaves in work the neighbors whose priority must be recomputed.
+ */
+static int
+ch_round_apply(ch_builder_t *b, int *rank, int *next_rank, int round)
+{
+    int ncontracted = b->nwork;
+    int *contracted = malloc((ncontracted ? ncontracted : 1) * sizeof(int));
+
+    if (NULL == contracted) {
+        return -1;
+    }
+    memcpy(contracted, b->work, ncontracted * sizeof(int));
+
+    for (int i = 0; i < b->nworkers; ++i) {
+        ch_worker_t *w = &b->workers[i];
+        if ((size_t)-1 == w->nshortcuts) {
+            free(contracted);
+            return -1;
+        }
+        for (size_t j = 0; j < w->nshortcuts; ++j) {
+            ch_shortcut_t *sc = &w->shortcuts[j];
+            if (ch_adj_add(&b->out[sc->source], sc->target, sc->weight, sc->middle) < 0 ||
+                ch_adj_add(&b->in[sc->target], sc->source, sc->weight, sc->middle) < 0) {
+                free(contracted);
+                return -1;
+            }
+        }
+    }
+
+    b->nwork = 0;
+
+    for (int i = 0; i < ncontracted; ++i) {
+        int v = contracted[i];
+
+        b->state[v] = CH_CONTRACTED;
+        rank[v] = (*next_rank)++;
+
+        for (int j = 0; j < b->out[v].size; ++j) {
+            int x = b->out[v].arcs[j].target;
+            ch_adj_remove(&b->in[x], v);
+            ch_touch(b, x, v, round);
+        }
+        for (int j = 0; j < b->in[v].size; ++j) {
+            int x = b->in[v].arcs[j].target;
+            ch_adj_remove(&b->out[x], v);
+            ch_touch(b, x, v, round);
+        }
+    }
+
+    free(contracted);
+
+    return 0;
+}
+
+/**
+ * Builds CSR graph out of adjacency of every vertex, as frozen at the
+ * time each vertex was contracted (arcs to higher ranked vertices only).
+ */
+static csr_graph_t *
+ch_csr_build(ch_adj_t *adj, int n, int **middle)
+{
+    csr_graph_t *csr = NULL;
+    size_t nedges = 0;
+    size_t k = 0;
+
+    for (int v = 0; v < n; ++v) {
+        nedges += adj[v].size;
+    }
+
+    csr = csr_graph_new(n, nedges);
+    *middle = malloc((nedges ? nedges : 1) * sizeof(int));
+
+    if (NULL == csr || NULL == *middle) {
+        csr_graph_free(csr);
+        free(*middle);
+        *middle = NULL;
+        return NULL;
+    }
+
+    for (int v = 0; v < n; ++v) {
+        csr->offsets[v] = k;
+        for (int i = 0; i < adj[v].size; ++i, ++k) {
+            csr->targets[k] = adj[v].arcs[i].target;
+            csr->weights[k] = adj[v].arcs[i].weight;
+            (*middle)[k] = adj[v].arcs[i].middle;
+        }
+    }
+    csr->offsets[n] = k;
+
+    return csr;
+}
+
+ch_t *
+ch_build(graph_t *graph, int nthreads)
+{
+    ch_builder_t *b = NULL;
+    ch_t *ch = calloc(1, sizeof(ch_t));
+    int next_rank = 0;
+    int round = 0;
+
+    if (NULL == ch) {
+        return NULL;
+    }
+
+    nthreads = parallel_threads(nthreads);
+
+    ch->size = graph->size;
+    ch->rank = malloc((graph->size ? graph->size : 1) * sizeof(int));
+    b = ch_builder_new(graph, nthreads);
+
+    if (NULL == ch->rank || NULL == b) {
+        goto error;
+    }
+
+    memcpy(b->work, b->remaining, b->nremaining * sizeof(int));
+    b->nwork = b->nremaining;
+
+    while (b->nremaining > 0) {
+        int i, j;
+
+        /** priorities of vertices in work are stale */
+        atomic_store(&b->next, 0);
+        parallel_run(b->nworkers, ch_priority_worker, b);
+
+        parallel_run(b->nworkers, ch_select_worker, b);
+
+        b->nwork = 0;
+        for (i = 0; i < b->nworkers; ++i) {
+            ch_worker_t *w = &b->workers[i];
+            for (size_t k = 0; k < w->nselected; ++k) {
+                b->state[w->selected[k]] = CH_CONTRACTING;
+                b->work[b->nwork++] = w->selected[k];
+            }
+        }
+
+        atomic_store(&b->next, 0);
+        parallel_run(b->nworkers, ch_contract_worker, b);
+
+        if (ch_round_apply(b, ch->rank, &next_rank, round++) < 0) {
+            goto error;
+        }
+
+        for (i = 0, j = 0; i < b->nremaining; ++i) {
+            if (CH_CONTRACTED != b->state[b->remaining[i]]) {
+                b->remaining[j++] = b->remaining[i];
+            }
+        }
+        b->nremaining = j;
+    }
+
+    ch->up = ch_csr_build(b->out, b->size, &ch->up_middle);
+    ch->down = ch_csr_build(b->in, b->size, &ch->down_middle);
+
+    if (NULL == ch->up || NULL == ch->down) {
+        goto error;
+    }
+
+    ch_builder_free(b);
+
+    return ch;
+
+error:
+    ch_builder_free(b);
+    ch_free(ch);
+    return NULL;
+}
+
+void
+ch_free(ch_t *ch)
+{
+    if (NULL != ch) {
+        free(ch->rank);
+        csr_graph_free(ch->up);
+        csr_graph_free(ch->down);
+        free(ch->up_middle);
+        free(ch->down_middle);
+        free(ch);
+    }
+}
+
+/**
+ * Whether u is reached by a shorter path going down from a higher ranked
+ * vertex already labeled (stall on demand): such path can't be part of a
+ * shortest up-down path, so u needs not be expanded.
+ */
+static bool
+ch_stalled(const csr_graph_t *csr_o, graph_search_t *search, int u, long distance)
+{
+    size_t i;
+
+    csr_graph_foreach(csr_o, u, i) {
+        search_vertex_t *sx = graph_search_vertex(search, csr_o->targets[i]);
+        if (LONG_MAX != sx->distance && sx->distance + csr_o->weights[i] < distance) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int
+ch_relax(const csr_graph_t *csr, ch_heap_t *h, graph_search_t *search, int u, long distance)
+{
+    ch_heap_entry_t entry = { 0, -1, 0 };
+    size_t i;
+
+    csr_graph_foreach(csr, u, i) {
+        search_vertex_t *sv = graph_search_vertex(search, csr->targets[i]);
+        long d = distance + csr->weights[i];
+        if (d < sv->distance) {
+            sv->distance = d;
+            sv->parent = u;
+            entry.key = d;
+            entry.vertex = csr->targets[i];
+            if (0 != ch_heap_insert(h, &entry)) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Settles top of the heap of one search direction.
+ *
+ * @return zero on success, -1 on allocation failure.
+ */
+static int
+ch_search_step(const csr_graph_t *csr, const csr_graph_t *csr_o, ch_heap_t *h, graph_search_t *search, graph_search_t *search_o, long *best, int *meet)
+{
+    ch_heap_entry_t entry = { 0, -1, 0 };
+    search_vertex_t *su = NULL;
+    search_vertex_t *su_o = NULL;
+    int u;
+
+    ch_heap_pop_front(h, &entry);
+
+    u = entry.vertex;
+    su = graph_search_vertex(search, u);
+    if (su->visited) {
+        return 0;
+    }
+    su->visited = 1;
+
+    su_o = graph_search_vertex(search_o, u);
+    if (LONG_MAX != su_o->distance && su->distance + su_o->distance < *best) {
+        *best = su->distance + su_o->distance;
+        *meet = u;
+    }
+
+    if (!ch_stalled(csr_o, search, u, su->distance)) {
+        return ch_relax(csr, h, search, u, su->distance);
+    }
+    return 0;
+}
+
+/**
+ * Bidirectional upward search from s and t.
+ *
+ * @return weight of a shortest path, LONG_MAX if t is not reachable
+ *         from s, -1 on allocation failure.
+ */
+static long
+ch_search(ch_t *ch, graph_search_t *search, graph_search_t *search_r, int s, int t, int *meet)
+{
+    long best = LONG_MAX;
+    ch_heap_t *h = ch_heap_new(0);
+    ch_heap_t *h_r = ch_heap_new(0);
+    ch_heap_entry_t entry = { 0, s, 0 };
+
+    *meet = -1;
+
+    if (NULL == h || NULL == h_r) {
+        goto error;
+    }
+
+    graph_search_reset(search);
+    graph_search_reset(search_r);
+
+    graph_search_vertex(search, s)->distance = 0;
+    graph_search_vertex(search_r, t)->distance = 0;
+
+    if (0 != ch_heap_insert(h, &entry)) {
+        goto error;
+    }
+    entry.vertex = t;
+    if (0 != ch_heap_insert(h_r, &entry)) {
+        goto error;
+    }
+
+    /**
+     * Each direction stops on its own once its smallest key can't
+     * improve best path found so far.
+     */
+    while (true) {
+        const ch_heap_entry_t *top = ch_heap_top(h);
+        const ch_heap_entry_t *top_r = ch_heap_top(h_r);
+
+        if (NULL != top && top->key >= best) {
+            top = NULL;
+        }
+        if (NULL != top_r && top_r->key >= best) {
+            top_r = NULL;
+        }
+        if (NULL == top && NULL == top_r) {
+            break;
+        }
+
+        if (0 != (NULL != top && (NULL == top_r || top->key <= top_r->key) ?
+                  ch_search_step(ch->up, ch->down, h, search, search_r, &best, meet) :
+                  ch_search_step(ch->down, ch->up, h_r, search_r, search, &best, meet))) {
+            goto error;
+        }
+    }
+
+out:
+    if (NULL != h) {
+        ch_heap_free(h);
+    }
+    if (NULL != h_r) {
+        ch_heap_free(h_r);
+    }
+
+    return best;
+
+error:
+    best = -1;
+    goto out;
+}
+
+long
+ch_distance(ch_t *ch, graph_search_t *search, graph_search_t *search_r, int s, int t)
+{
+    int meet;
+    long distance = ch_search(ch, search, search_r, s, t, &meet);
+
+    return LONG_MAX == distance ? -1 : distance;
+}
+
+/**
+ * Returns contracted vertex bypassed by arc u -> v (-1 for original arcs).
+ *
+ * Arc is stored in upward graph of u if v has higher rank, otherwise in
+ * downward graph of v.
+ */
+static int
+ch_arc_middle(ch_t *ch, int u, int v)
+{
+    size_t i;
+
+    if (ch->rank[u] < ch->rank[v]) {
+        csr_graph_foreach(ch->up, u, i) {
+            if (ch->up->targets[i] == v) {
+                return ch->up_middle[i];
+            }
+        }
+    }
+    else {
+        csr_graph_foreach(ch->down, v, i) {
+            if (ch->down->targets[i] == u) {
+                return ch->down_middle[i];
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * Appends to path vertices of arc u -> v with shortcuts unpacked,
+ * excluding u itself. Uses an explicit stack of arcs still packed.
+ */
+static int
+ch_arc_unpack(ch_t *ch, int u, int v, array_t *path)
+{
+    int arc[2] = { u, v };
+    array_t *stack = array_new(0, sizeof(arc));
+
+    if (NULL == stack) {
+        return -1;
+    }
+
+    if (0 != array_push_back(stack, arc)) {
+        goto error;
+    }
+
+    while (NULL != array_pop_back(stack, arc)) {
+        int middle = ch_arc_middle(ch, arc[0], arc[1]);
+        if (middle < 0) {
+            if (0 != array_push_back(path, &arc[1])) {
+                goto error;
+            }
+        }
+        else {
+            int second[2] = { middle, arc[1] };
+            int first[2] = { arc[0], middle };
+            if (0 != array_push_back(stack, second) || 0 != array_push_back(stack, first)) {
+                goto error;
+            }
+        }
+    }
+
+    array_free(stack);
+
+    return 0;
+
+error:
+    array_free(stack);
+    return -1;
+}
+
+long
+ch_path(ch_t *ch, graph_search_t *search, graph_search_t *search_r, int s, int t, array_t *path)
+{
+    int meet;
+    int v;
+    array_t *up = NULL;
+    long distance = ch_search(ch, search, search_r, s, t, &meet);
+
+    if (LONG_MAX == distance || distance < 0) {
+        return -1;
+    }
+
+    /** vertices from meet down to s, in the upward search tree */
+    up = array_new(0, sizeof(int));
+    if (NULL == up) {
+        return -1;
+    }
+    for (v = meet; v >= 0; v = graph_search_parent(search, v)) {
+        if (0 != array_push_back(up, &v)) {
+            goto error;
+        }
+    }
+
+    array_pop_back(up, &v);
+    if (0 != array_push_back(path, &v)) {
+        goto error;
+    }
+
+    while (array_size(up) > 0) {
+        int u = v;
+        array_pop_back(up, &v);
+        if (0 != ch_arc_unpack(ch, u, v, path)) {
+            goto error;
+        }
+    }
+
+    array_free(up);
+
+    /** from meet to t, following the downward search tree */
+    for (v = meet; v != t; ) {
+        int u = v;
+        v = graph_search_parent(search_r, u);
+        if (0 != ch_arc_unpack(ch, u, v, path)) {
+            return -1;
+        }
+    }
+
+    return distance;
+
+error:
+    array_free(up);
+    return -1;
+}
+
+typedef struct ch_bucket_entry ch_bucket_entry_t;
+
+/**
+ * Vertex reached by the backward search of a target, with its distance
+ * to the target.
+ */
+struct ch_bucket_entry {
+    int vertex;
+    int target;  /**< index in targets */
+    long distance;
+};
+
+typedef struct ch_table_worker ch_table_worker_t;
+
+/**
+ * Per thread state of a many-to-many query.
+ */
+struct ch_table_worker {
+    graph_search_t *search;
+    ch_heap_t *heap;
+    int *settled;
+    ch_bucket_entry_t *entries;  /**< entries of backward searches of this thread */
+    size_t nentries;
+    size_t capacity;
+};
+
+typedef struct ch_table ch_table_t;
+
+struct ch_table {
+    ch_t *ch;
+    const int *sources;
+    size_t nsources;
+    const int *targets;
+    size_t ntargets;
+    ch_table_worker_t *workers;
+    int nworkers;
+    size_t *offsets;             /**< bucket of v: buckets[offsets[v] .. offsets[v + 1]) */
+    ch_bucket_entry_t *buckets;
+    long *table;
+    atomic_size_t next;
+    atomic_bool error;
+};
+
+/**
+ * Settles every vertex reachable from s going up (all of its search space),
+ * stalled vertices aside.
+ *
+ * @return number of vertices stored in settled, -1 on allocation failure.
+ */
+static int
+ch_upward_search(const csr_graph_t *csr, const csr_graph_t *csr_o, ch_heap_t *h, graph_search_t *search, int s, int *settled)
+{
+    ch_heap_entry_t entry = { 0, s, 0 };
+    int nsettled = 0;
+
+    graph_search_reset(search);
+    graph_search_vertex(search, s)->distance = 0;
+    if (0 != ch_heap_insert(h, &entry)) {
+        return -1;
+    }
+
+    while (NULL != ch_heap_pop_front(h, &entry)) {
+        search_vertex_t *su = graph_search_vertex(search, entry.vertex);
+
+        if (su->visited) {
+            continue;
+        }
+        su->visited = 1;
+
+        if (ch_stalled(csr_o, search, entry.vertex, su->distance)) {
+            continue;
+        }
+        settled[nsettled++] = entry.vertex;
+
+        if (0 != ch_relax(csr, h, search, entry.vertex, su->distance)) {
+            while (NULL != ch_heap_pop_front(h, &entry));
+            return -1;
+        }
+    }
+
+    return nsettled;
+}
+
+static void
+ch_backward_worker(void *arg, int id, int nthreads)
+{
+    ch_table_t *t = arg;
+    ch_table_worker_t *w = &t->workers[id];
+    size_t j;
+
+    while (!atomic_load(&t->error) && (j = atomic_fetch_add(&t->next, 1)) < t->ntargets) {
+        int n = ch_upward_search(t->ch->down, t->ch->up, w->heap, w->search, t->targets[j], w->settled);
+
+        if (n < 0) {
+            atomic_store(&t->error, true);
+            return;
+        }
+        if (w->nentries + n > w->capacity) {
+            size_t capacity = 2 * w->capacity + n;
+            ch_bucket_entry_t *entries = realloc(w->entries, capacity * sizeof(ch_bucket_entry_t));
+
+            if (NULL == entries) {
+                atomic_store(&t->error, true);
+                return;
+            }
+            w->entries = entries;
+            w->capacity = capacity;
+        }
+        for (int k = 0; k < n; ++k) {
+            ch_bucket_entry_t *e = &w->entries[w->nentries++];
+            e->vertex = w->settled[k];
+            e->target = (int)j;
+            e->distance = graph_search_vertex(w->search, e->vertex)->distance;
+        }
+    }
+}
+
+static void
+ch_forward_worker(void *arg, int id, int nthreads)
+{
+    ch_table_t *t = arg;
+    ch_table_worker_t *w = &t->workers[id];
+    size_t i;
+
+    while (!atomic_load(&t->error) && (i = atomic_fetch_add(&t->next, 1)) < t->nsources) {
+        long *row = &t->table[i * t->ntargets];
+        int n = ch_upward_search(t->ch->up, t->ch->down, w->heap, w->search, t->sources[i], w->settled);
+
+        if (n < 0) {
+            atomic_store(&t->error, true);
+            return;
+        }
+
+        for (size_t j = 0; j < t->ntargets; ++j) {
+            row[j] = LONG_MAX;
+        }
+        for (int k = 0; k < n; ++k) {
+            int u = w->settled[k];
+            long du = graph_search_vertex(w->search, u)->distance;
+
+            for (size_t b = t->offsets[u]; b < t->offsets[u + 1]; ++b) {
+                const ch_bucket_entry_t *e = &t->buckets[b];
+                if (du + e->distance < row[e->target]) {
+                    row[e->target] = du + e->distance;
+                }
+            }
+        }
+        for (size_t j = 0; j < t->ntargets; ++j) {
+            if (LONG_MAX == row[j]) {
+                row[j] = -1;
+            }
+        }
+    }
+}
+
+/**
+ * Gathers entries of backward searches of all threads into buckets,
+ * by vertex (counting sort).
+ */
+static int
+ch_buckets_build(ch_table_t *t)
+{
+    int size = t->ch->size;
+    size_t *cursor = NULL;
+    size_t nentries = 0;
+
+    t->offsets = calloc(size + 1, sizeof(size_t));
+    cursor = malloc((size + 1) * sizeof(size_t));
+    for (int i = 0; i < t->nworkers; ++i) {
+        nentries += t->workers[i].nentries;
+    }
+    t->buckets = malloc((nentries ? nentries : 1) * sizeof(ch_bucket_entry_t));
+
+    if (NULL == t->offsets || NULL == cursor || NULL == t->buckets) {
+        free(cursor);
+        return -1;
+    }
+
+    for (int i = 0; i < t->nworkers; ++i) {
+        ch_table_worker_t *w = &t->workers[i];
+        for (size_t k = 0; k < w->nentries; ++k) {
+            t->offsets[w->entries[k].vertex + 1]++;
+        }
+    }
+    for (int v = 0; v < size; ++v) {
+        t->offsets[v + 1] += t->offsets[v];
+    }
+    memcpy(cursor, t->offsets, (size + 1) * sizeof(size_t));
+
+    for (int i = 0; i < t->nworkers; ++i) {
+        ch_table_worker_t *w = &t->workers[i];
+        for (size_t k = 0; k < w->nentries; ++k) {
+            t->buckets[cursor[w->entries[k].vertex]++] = w->entries[k];
+        }
+        free(w->entries);
+        w->entries = NULL;
+    }
+
+    free(cursor);
+    return 0;
+}
+
+static void
+ch_table_free(ch_table_t *t)
+{
+    if (NULL != t->workers) {
+        for (int i = 0; i < t->nworkers; ++i) {
+            ch_table_worker_t *w = &t->workers[i];
+            if (NULL != w->search) {
+                graph_search_free(w->search);
+            }
+            if (NULL != w->heap) {
+                ch_heap_free(w->heap);
+            }
+            free(w->settled);
+            free(w->entries);
+        }
+        free(t->workers);
+    }
+    free(t->offsets);
+    free(t->buckets);
+}
+
+int
+ch_many_to_many(ch_t *ch, const int *sources, size_t nsources, const int *targets, size_t ntargets, int nthreads, long *table)
+{
+    ch_table_t t;
+    int rc = -1;
+
+    if (0 == nsources || 0 == ntargets) {
+        return 0;
+    }
+
+    memset(&t, 0, sizeof(t));
+    t.ch = ch;
+    t.sources = sources;
+    t.nsources = nsources;
+    t.targets = targets;
+    t.ntargets = ntargets;
+    t.table = table;
+    t.nworkers = parallel_threads(nthreads);
+    atomic_init(&t.next, 0);
+    atomic_init(&t.error, false);
+
+    t.workers = calloc(t.nworkers, sizeof(ch_table_worker_t));
+    if (NULL == t.workers) {
+        goto out;
+    }
+    for (int i = 0; i < t.nworkers; ++i) {
+        ch_table_worker_t *w = &t.workers[i];
+        w->search = graph_search_new(ch->size);
+        w->heap = ch_heap_new(0);
+        w->settled = malloc(ch->size * sizeof(int));
+        if (NULL == w->search || NULL == w->heap || NULL == w->settled) {
+            goto out;
+        }
+    }
+
+    parallel_run(t.nworkers, ch_backward_worker, &t);
+    if (atomic_load(&t.error) || 0 != ch_buckets_build(&t)) {
+        goto out;
+    }
+
+    atomic_store(&t.next, 0);
+    parallel_run(t.nworkers, ch_forward_worker, &t);
+    if (!atomic_load(&t.error)) {
+        rc = 0;
+    }
+
+out:
+    ch_table_free(&t);
+    return rc;
+}
+
+static int
+ch_csr_write(FILE *f, csr_graph_t *csr, int *middle)
+{
+    if (1 != fwrite(&csr->nedges, sizeof(csr->nedges), 1, f) ||
+        (size_t)csr->size + 1 != fwrite(csr->offsets, sizeof(size_t), csr->size + 1, f) ||
+        csr->nedges != fwrite(csr->targets, sizeof(int), csr->nedges, f) ||
+        csr->nedges != fwrite(csr->weights, sizeof(long), csr->nedges, f) ||
+        csr->nedges != fwrite(middle, sizeof(int), csr->nedges, f)) {
+        return -1;
+    }
+    return 0;
+}
+
+static csr_graph_t *
+ch_csr_read(FILE *f, int size, int **middle)
+{
+    csr_graph_t *csr = NULL;
+    size_t nedges;
+
+    if (1 != fread(&nedges, sizeof(nedges), 1, f)) {
+        return NULL;
+    }
+
+    csr = csr_graph_new(size, nedges);
+    *middle = malloc((nedges ? nedges : 1) * sizeof(int));
+
+    if (NULL == csr || NULL == *middle ||
+        (size_t)size + 1 != fread(csr->offsets, sizeof(size_t), size + 1, f) ||
+        nedges != fread(csr->targets, sizeof(int), nedges, f) ||
+        nedges != fread(csr->weights, sizeof(long), nedges, f) ||
+        nedges != fread(*middle, sizeof(int), nedges, f)) {
+        csr_graph_free(csr);
+        free(*middle);
+        *middle = NULL;
+        return NULL;
+    }
+
+    return csr;
+}
+
+/**
+ * Checks that offsets of csr read from a file are monotone, and that
+ * every arc leads to a vertex of higher rank, has a non-negative weight
+ * and bypasses a vertex of lower rank than both its ends, so that
+ * queries and path unpacking stay in range and terminate.
+ */
+static bool
+ch_csr_valid(const csr_graph_t *csr, const int *middle, const int *rank)
+{
+    for (int u = 0; u < csr->size; ++u) {
+        if (csr->offsets[u] > csr->offsets[u + 1]) {
+            return false;
+        }
+    }
+    if (0 != csr->offsets[0] || csr->nedges != csr->offsets[csr->size]) {
+        return false;
+    }
+
+    for (int u = 0; u < csr->size; ++u) {
+        size_t i;
+        csr_graph_foreach(csr, u, i) {
+            int v = csr->targets[i];
+            int m = middle[i];
+            if (v < 0 || v >= csr->size || rank[v] <= rank[u] || csr->weights[i] < 0) {
+                return false;
+            }
+            if (-1 != m && (m < 0 || m >= csr->size || rank[m] >= rank[u])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int
+ch_save(ch_t *ch, const char *filename)
+{
+    uint32_t header[2] = { CH_FILE_MAGIC, CH_FILE_VERSION };
+    FILE *f = fopen(filename, "wb");
+    int rc = -1;
+
+    if (NULL == f) {
+        return -1;
+    }
+
+    if (2 == fwrite(header, sizeof(uint32_t), 2, f) &&
+        1 == fwrite(&ch->size, sizeof(ch->size), 1, f) &&
+        (size_t)ch->size == fwrite(ch->rank, sizeof(int), ch->size, f) &&
+        0 == ch_csr_write(f, ch->up, ch->up_middle) &&
+        0 == ch_csr_write(f, ch->down, ch->down_middle)) {
+        rc = 0;
+    }
+
+    if (0 != fclose(f)) {
+        rc = -1;
+    }
+
+    return rc;
+}
+
+ch_t *
+ch_load(const char *filename)
+{
+    uint32_t header[2];
+    ch_t *ch = NULL;
+    bool *seen = NULL;
+    FILE *f = fopen(filename, "rb");
+
+    if (NULL == f) {
+        return NULL;
+    }
+
+    ch = calloc(1, sizeof(ch_t));
+    if (NULL == ch) {
+        goto error;
+    }
+
+    if (2 != fread(header, sizeof(uint32_t), 2, f) ||
+        CH_FILE_MAGIC != header[0] || CH_FILE_VERSION != header[1] ||
+        1 != fread(&ch->size, sizeof(ch->size), 1, f) || ch->size < 0) {
+        goto error;
+    }
+
+    ch->rank = malloc((ch->size ? ch->size : 1) * sizeof(int));
+    seen = calloc(ch->size ? ch->size : 1, sizeof(bool));
+    if (NULL == ch->rank || NULL == seen ||
+        (size_t)ch->size != fread(ch->rank, sizeof(int), ch->size, f)) {
+        goto error;
+    }
+
+    /** ranks must be a permutation of vertices */
+    for (int u = 0; u < ch->size; ++u) {
+        int r = ch->rank[u];
+        if (r < 0 || r >= ch->size || seen[r]) {
+            goto error;
+        }
+        seen[r] = true;
+    }
+
+    ch->up = ch_csr_read(f, ch->size, &ch->up_middle);
+    if (NULL == ch->up || !ch_csr_valid(ch->up, ch->up_middle, ch->rank)) {
+        goto error;
+    }
+    ch->down = ch_csr_read(f, ch->size, &ch->down_middle);
+    if (NULL == ch->down || !ch_csr_valid(ch->down, ch->down_middle, ch->rank)) {
+        goto error;
+    }
+
+    fclose(f);
+    free(seen);
+
+    return ch;
+
+error:
+    fclose(f);
+    free(seen);
+    ch_free(ch);
+    return NULL;
+}
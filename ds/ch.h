@@ -0,0 +1,120 @@
+#ifndef _CH__H_
+#define _CH__H_
+
+#include "includes.h"
+#include "graph.h"
+#include "csr_graph.h"
+#include "array.h"
+
+/**
+ * Contraction hierarchies.
+ *
+ * Preprocessing contracts vertices one by one in order of importance:
+ * contracting v removes it from the graph, adding a shortcut u -> w for
+ * every path u -> v -> w that is the only shortest path between u and w
+ * (no witness path avoiding v is found by a local search). Every vertex
+ * is given a rank equal to its position in the contraction order.
+ *
+ * Queries are bidirectional Dijkstra searches that only move towards
+ * vertices of higher rank: forward from s over upward arcs and backward
+ * from t over downward arcs, both searches settling only a tiny part of
+ * the graph.
+ *
+ * Contraction is parallel: every round picks vertices of minimum priority
+ * within two arcs around them, contracts all of them at once and updates
+ * priorities of their neighbors. Witness searches of a round don't see
+ * shortcuts of vertices of the same round, so it may add a few shortcuts
+ * a one by one contraction would not, distances remaining exact.
+ */
+
+typedef struct ch ch_t;
+
+struct ch {
+    int size;
+    int *rank;         /**< position of each vertex in the contraction order */
+    csr_graph_t *up;   /**< u -> v arcs (original or shortcut) with rank[v] > rank[u] */
+    csr_graph_t *down; /**< v -> u arcs for every u -> v arc with rank[u] > rank[v] */
+    int *up_middle;    /**< contracted vertex a shortcut bypasses, -1 for original arcs */
+    int *down_middle;
+};
+
+/**
+ * Builds contraction hierarchy for graph.
+ *
+ * Edges of graph must have non-negative weights.
+ *
+ * @param graph graph to be preprocessed
+ * @param nthreads number of threads (<= 0 for number of processors)
+ * @return contraction hierarchy or NULL in case of error.
+ */
+ch_t *
+ch_build(graph_t *graph, int nthreads);
+
+void
+ch_free(ch_t *ch);
+
+/**
+ * Returns weight of a shortest path from s to t, -1 if unreachable or
+ * on allocation failure.
+ *
+ * search and search_r are contexts of ch->size vertices, one for each
+ * direction. Concurrent queries need contexts of their own.
+ */
+long
+ch_distance(ch_t *ch, graph_search_t *search, graph_search_t *search_r, int s, int t);
+
+/**
+ * Same as ch_distance, also unpacking shortcuts of the path found.
+ *
+ * @param path array of int to which vertices of the path, from s to t,
+ *        are appended
+ * @return weight of the path, -1 if t is not reachable from s or on
+ *         allocation failure (path may then hold part of the path).
+ */
+long
+ch_path(ch_t *ch, graph_search_t *search, graph_search_t *search_r, int s, int t, array_t *path);
+
+/**
+ * Many-to-many distance table.
+ *
+ * Instead of one query per pair, every target is searched backward once,
+ * over downward arcs, leaving (target, distance) in a bucket of every
+ * vertex settled. Every source is then searched forward once, over upward
+ * arcs, and pairs meet by scanning buckets of vertices settled: the table
+ * costs nsources + ntargets upward searches plus bucket scans, instead of
+ * nsources * ntargets queries.
+ *
+ * Backward searches, then forward searches, are spread over nthreads
+ * threads, each thread filling rows of sources it picks.
+ *
+ * @param sources vertices table rows stand for
+ * @param targets vertices table columns stand for (at most INT_MAX)
+ * @param nthreads number of threads (<= 0 for number of processors)
+ * @param table array of nsources * ntargets entries, table[i * ntargets + j]
+ *        being weight of a shortest path from sources[i] to targets[j],
+ *        -1 if unreachable
+ * @return zero on success, -1 on allocation failure.
+ */
+int
+ch_many_to_many(ch_t *ch, const int *sources, size_t nsources, const int *targets, size_t ntargets, int nthreads, long *table);
+
+/**
+ * Writes contraction hierarchy to file.
+ *
+ * @return zero on success, -1 otherwise.
+ */
+int
+ch_save(ch_t *ch, const char *filename);
+
+/**
+ * Loads contraction hierarchy written by ch_save.
+ *
+ * Ranks must form a permutation, offsets must be monotone and arcs must
+ * lead to higher ranked vertices in range, bypassing lower ranked ones.
+ *
+ * @return contraction hierarchy or NULL in case of error or invalid file.
+ */
+ch_t *
+ch_load(const char *filename);
+
+#endif /* _CH__H_ */
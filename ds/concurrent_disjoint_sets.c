@@ -0,0 +1,118 @@
+#include "concurrent_disjoint_sets.h"
+#include <stdlib.h>
+#include <stdatomic.h>
+
+struct concurrent_disjoint_sets {
+    int n;
+    atomic_int *parent;
+};
+
+concurrent_disjoint_sets_t *
+concurrent_disjoint_sets_new(int n)
+{
+    concurrent_disjoint_sets_t *ds = calloc(1, sizeof(concurrent_disjoint_sets_t));
+    if (NULL != ds) {
+        ds->parent = malloc((n > 0 ? n : 1) * sizeof(atomic_int));
+        if (NULL == ds->parent) {
+            goto error;
+        }
+        ds->n = n;
+    }
+    return ds;
+
+error:
+    concurrent_disjoint_sets_free(ds);
+    return NULL;
+}
+
+void
+concurrent_disjoint_sets_free(concurrent_disjoint_sets_t *ds)
+{
+    if (NULL != ds) {
+        free(ds->parent);
+        ds->parent = NULL;
+        free(ds);
+    }
+}
+
+void
+concurrent_disjoint_sets_make_set(concurrent_disjoint_sets_t *ds)
+{
+    int i;
+    for (i = 0; i < ds->n; ++i) {
+        atomic_init(&ds->parent[i], i);
+    }
+}
+
+/**
+ * Parents only ever move up the tree: a failed compare-and-swap means
+ * some other thread already moved parent of i at least as far up, so it's
+ * not retried. Relaxed ordering is enough since parents are the only
+ * shared data and every change keeps them valid.
+ */
+int
+concurrent_disjoint_sets_find(concurrent_disjoint_sets_t *ds, int i)
+{
+    int p = atomic_load_explicit(&ds->parent[i], memory_order_relaxed);
+
+    while (p != i) {
+        int gp = atomic_load_explicit(&ds->parent[p], memory_order_relaxed);
+        if (gp != p) {
+            atomic_compare_exchange_weak_explicit(&ds->parent[i], &p, gp,
+                                                  memory_order_relaxed, memory_order_relaxed);
+        }
+        i = gp;
+        p = atomic_load_explicit(&ds->parent[i], memory_order_relaxed);
+    }
+    return i;
+}
+
+bool
+concurrent_disjoint_sets_union(concurrent_disjoint_sets_t *ds, int i, int j)
+{
+    for (;;) {
+        int id_i = concurrent_disjoint_sets_find(ds, i);
+        int id_j = concurrent_disjoint_sets_find(ds, j);
+        int child;
+        int parent;
+
+        if (id_i == id_j) {
+            return false;
+        }
+
+        child = id_i > id_j ? id_i : id_j;
+        parent = id_i > id_j ? id_j : id_i;
+
+        /**
+         * Fails if child stopped being a root since it was found.
+         */
+        if (atomic_compare_exchange_strong_explicit(&ds->parent[child], &child, parent,
+                                                    memory_order_relaxed, memory_order_relaxed)) {
+            return true;
+        }
+        i = id_i;
+        j = id_j;
+    }
+}
+
+bool
+concurrent_disjoint_sets_same_set(concurrent_disjoint_sets_t *ds, int i, int j)
+{
+    for (;;) {
+        int id_i = concurrent_disjoint_sets_find(ds, i);
+        int id_j = concurrent_disjoint_sets_find(ds, j);
+
+        if (id_i == id_j) {
+            return true;
+        }
+        /**
+         * id_i still a root means both sets were still distinct once
+         * id_j was found.
+         */
+        if (atomic_load_explicit(&ds->parent[id_i], memory_order_relaxed) == id_i) {
+            return false;
+        }
+        i = id_i;
+        j = id_j;
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef _CONCURRENT_DISJOINT_SETS__H_
+#define _CONCURRENT_DISJOINT_SETS__H_
+
+#include <stdbool.h>
+
+/**
+ * Disjoint sets safe to be used by many threads at once, without locks.
+ *
+ * Every element keeps an atomic parent. Union links one root to another
+ * with a compare-and-swap, retrying from the new roots if some other
+ * thread linked any of them first. Find halves paths with compare-and-swap
+ * as well, never overwriting a parent changed concurrently, so that
+ * compression only ever shortcuts to an ancestor.
+ *
+ * Roots are linked by index (larger one below smaller one) instead of by
+ * rank: linking needs a single compare-and-swap, and the representative
+ * of a set is always its smallest element, whatever the order unions
+ * were made in by whichever threads. Sets built are the same as the ones
+ * disjoint_sets builds out of the same unions.
+ */
+
+typedef struct concurrent_disjoint_sets concurrent_disjoint_sets_t;
+
+concurrent_disjoint_sets_t *
+concurrent_disjoint_sets_new(int n);
+
+void
+concurrent_disjoint_sets_free(concurrent_disjoint_sets_t *ds);
+
+/**
+ * Makes every element a set of its own.
+ *
+ * Not safe to be called concurrently with other operations.
+ */
+void
+concurrent_disjoint_sets_make_set(concurrent_disjoint_sets_t *ds);
+
+/**
+ * Returns representative (smallest element) of the set of i.
+ *
+ * Concurrent unions might make the result outdated as soon as it's
+ * returned, but never before find was called.
+ */
+int
+concurrent_disjoint_sets_find(concurrent_disjoint_sets_t *ds, int i);
+
+/**
+ * Merges sets of i and j.
+ *
+ * @return true if sets were merged by this call, false if i and j were
+ *         already in the same set. Exactly one of many concurrent unions
+ *         of the same two sets returns true.
+ */
+bool
+concurrent_disjoint_sets_union(concurrent_disjoint_sets_t *ds, int i, int j);
+
+/**
+ * Returns true if i and j are in the same set.
+ *
+ * Concurrent unions might merge sets of i and j right after false was
+ * returned, but once true is returned it stays true.
+ */
+bool
+concurrent_disjoint_sets_same_set(concurrent_disjoint_sets_t *ds, int i, int j);
+
+#endif /* _CONCURRENT_DISJOINT_SETS__H_ */
@@ -0,0 +1,2314 @@
+#include "csr_graph.h"
+#include "heap_define.h"
+#include "parallel.h"
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * Number of frontier vertices a delta-stepping thread claims at once.
+ */
+#define CSR_DELTA_STEPPING_CHUNK 64
+
+/**
+ * Maximum number of cyclic buckets of a delta-stepping thread, farther
+ * distances go to an overflow bucket.
+ */
+#define CSR_DELTA_STEPPING_BUCKETS 1024
+
+/**
+ * Direction-optimizing BFS switches to bottom-up steps once arcs out of
+ * the frontier exceed 1/CSR_BFS_ALPHA of arcs still unexplored, and back
+ * to top-down once the frontier holds less than 1/CSR_BFS_BETA of the
+ * vertices and shrinks.
+ */
+#define CSR_BFS_ALPHA 15
+#define CSR_BFS_BETA  18
+#define CSR_BFS_CHUNK 64
+#define CSR_BFS_LOCAL 1024 /**< vertices a thread buffers before publishing */
+
+typedef struct csr_heap_entry csr_heap_entry_t;
+
+/**
+ * Heap entries are stored by value and never updated in place: whenever
+ * a vertex key decreases a new entry is inserted and stale ones are
+ * skipped as they reach the top of the heap.
+ */
+struct csr_heap_entry {
+    long key;
+    int vertex;
+};
+
+#define csr_heap_entry_less(e1, e2) ((e1).key < (e2).key)
+
+HEAP_DEFINE(csr_heap, csr_heap_entry_t, csr_heap_entry_less)
+
+csr_graph_t *
+csr_graph_new(int size, size_t nedges)
+{
+    csr_graph_t *csr = calloc(1, sizeof(csr_graph_t));
+
+    if (NULL != csr) {
+        csr->size = size;
+        csr->nedges = nedges;
+        csr->offsets = calloc(size + 1, sizeof(size_t));
+        csr->targets = malloc((nedges ? nedges : 1) * sizeof(int));
+        csr->weights = malloc((nedges ? nedges : 1) * sizeof(long));
+        if (NULL == csr->offsets || NULL == csr->targets || NULL == csr->weights) {
+            goto error;
+        }
+    }
+    return csr;
+
+error:
+    csr_graph_free(csr);
+    return NULL;
+}
+
+void
+csr_graph_free(csr_graph_t *csr)
+{
+    if (NULL != csr) {
+        free(csr->offsets);
+        free(csr->targets);
+        free(csr->weights);
+        free(csr);
+    }
+}
+
+/**
+ * Turns per vertex counters stored at offsets[u + 1] into offsets and
+ * returns a copy of them to be used as insertion cursors.
+ */
+static size_t *
+csr_graph_prefix_sum(csr_graph_t *csr)
+{
+    size_t *cursor = malloc((csr->size + 1) * sizeof(size_t));
+
+    if (NULL != cursor) {
+        for (int u = 0; u < csr->size; ++u) {
+            csr->offsets[u + 1] += csr->offsets[u];
+        }
+        memcpy(cursor, csr->offsets, (csr->size + 1) * sizeof(size_t));
+    }
+    return cursor;
+}
+
+csr_graph_t *
+csr_graph_build(int size, const csr_edge_t *edges, size_t nedges, edge_flags_t flags)
+{
+    bool directed = !!(flags & EDGE_F_DIRECTED);
+    csr_graph_t *csr = NULL;
+    size_t *cursor = NULL;
+    size_t i;
+
+    for (i = 0; i < nedges; ++i) {
+        if (edges[i].source < 0 || edges[i].source >= size ||
+            edges[i].target < 0 || edges[i].target >= size) {
+            return NULL;
+        }
+    }
+
+    csr = csr_graph_new(size, directed ? nedges : 2 * nedges);
+    if (NULL == csr) {
+        return NULL;
+    }
+
+    for (i = 0; i < nedges; ++i) {
+        csr->offsets[edges[i].source + 1]++;
+        if (!directed) {
+            csr->offsets[edges[i].target + 1]++;
+        }
+    }
+
+    cursor = csr_graph_prefix_sum(csr);
+    if (NULL == cursor) {
+        csr_graph_free(csr);
+        return NULL;
+    }
+
+    for (i = 0; i < nedges; ++i) {
+        size_t j = cursor[edges[i].source]++;
+        csr->targets[j] = edges[i].target;
+        csr->weights[j] = edges[i].weight;
+        if (!directed) {
+            j = cursor[edges[i].target]++;
+            csr->targets[j] = edges[i].source;
+            csr->weights[j] = edges[i].weight;
+        }
+    }
+
+    free(cursor);
+
+    return csr;
+}
+
+csr_graph_t *
+csr_graph_from_graph(graph_t *graph)
+{
+    csr_graph_t *csr = NULL;
+    size_t nedges = 0;
+    size_t j = 0;
+
+    for (int i = 0; i < graph->size; ++i) {
+        node_t *node = NULL;
+        list_foreach(graph->vertices[i].edges, node) {
+            ++nedges;
+        }
+    }
+
+    csr = csr_graph_new(graph->size, nedges);
+    if (NULL == csr) {
+        return NULL;
+    }
+
+    for (int i = 0; i < graph->size; ++i) {
+        node_t *node = NULL;
+        vertex_t *u = &graph->vertices[i];
+        csr->offsets[i] = j;
+        list_foreach(u->edges, node) {
+            edge_t *edge = node_data(node);
+            vertex_t *v = edge_pair_get(edge, u);
+            csr->targets[j] = v - graph->vertices;
+            csr->weights[j] = edge->weight;
+            ++j;
+        }
+    }
+    csr->offsets[graph->size] = j;
+
+    return csr;
+}
+
+csr_graph_t *
+csr_graph_reverse(const csr_graph_t *csr)
+{
+    csr_graph_t *csr_r = csr_graph_new(csr->size, csr->nedges);
+    size_t *cursor = NULL;
+    size_t i;
+
+    if (NULL == csr_r) {
+        return NULL;
+    }
+
+    for (i = 0; i < csr->nedges; ++i) {
+        csr_r->offsets[csr->targets[i] + 1]++;
+    }
+
+    cursor = csr_graph_prefix_sum(csr_r);
+    if (NULL == cursor) {
+        csr_graph_free(csr_r);
+        return NULL;
+    }
+
+    for (int u = 0; u < csr->size; ++u) {
+        csr_graph_foreach(csr, u, i) {
+            size_t j = cursor[csr->targets[i]]++;
+            csr_r->targets[j] = u;
+            csr_r->weights[j] = csr->weights[i];
+        }
+    }
+
+    free(cursor);
+
+    return csr_r;
+}
+
+#define CSR_FILE_F_REVERSE 0x1
+
+typedef struct csr_file_header csr_file_header_t;
+
+/**
+ * On disk header, followed by arrays at CSR_FILE_ALIGN aligned positions.
+ */
+struct csr_file_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint8_t offset_size;
+    uint8_t target_size;
+    uint8_t weight_size;
+    uint8_t reserved;
+    int64_t size;
+    uint64_t nedges;
+};
+
+static size_t
+csr_file_align(size_t pos)
+{
+    return (pos + CSR_FILE_ALIGN - 1) & ~(size_t)(CSR_FILE_ALIGN - 1);
+}
+
+/**
+ * Computes positions of offsets, targets and weights of a graph whose
+ * arrays start at pos, returns position following them.
+ */
+static size_t
+csr_file_layout(int size, size_t nedges, size_t pos, size_t section[3])
+{
+    section[0] = csr_file_align(pos);
+    section[1] = csr_file_align(section[0] + ((size_t)size + 1) * sizeof(size_t));
+    section[2] = csr_file_align(section[1] + nedges * sizeof(int));
+    return section[2] + nedges * sizeof(long);
+}
+
+/**
+ * Writes length bytes of data at position *pos, zero padding the file
+ * up to position at first.
+ */
+static int
+csr_file_write(FILE *f, size_t *pos, size_t at, const void *data, size_t length)
+{
+    static const char zeros[CSR_FILE_ALIGN];
+
+    if (at - *pos != fwrite(zeros, 1, at - *pos, f) ||
+        length != fwrite(data, 1, length, f)) {
+        return -1;
+    }
+    *pos = at + length;
+    return 0;
+}
+
+static int
+csr_file_write_graph(FILE *f, size_t *pos, const csr_graph_t *csr)
+{
+    size_t section[3];
+
+    csr_file_layout(csr->size, csr->nedges, *pos, section);
+
+    if (0 != csr_file_write(f, pos, section[0], csr->offsets, ((size_t)csr->size + 1) * sizeof(size_t)) ||
+        0 != csr_file_write(f, pos, section[1], csr->targets, csr->nedges * sizeof(int)) ||
+        0 != csr_file_write(f, pos, section[2], csr->weights, csr->nedges * sizeof(long))) {
+        return -1;
+    }
+    return 0;
+}
+
+int
+csr_graph_save(const csr_graph_t *csr, const csr_graph_t *csr_r, const char *filename)
+{
+    csr_file_header_t header = {
+        .magic = CSR_FILE_MAGIC,
+        .version = CSR_FILE_VERSION,
+        .flags = NULL != csr_r ? CSR_FILE_F_REVERSE : 0,
+        .offset_size = sizeof(size_t),
+        .target_size = sizeof(int),
+        .weight_size = sizeof(long),
+        .size = csr->size,
+        .nedges = csr->nedges,
+    };
+    size_t pos = 0;
+    FILE *f = NULL;
+    int rc = -1;
+
+    if (NULL != csr_r && (csr_r->size != csr->size || csr_r->nedges != csr->nedges)) {
+        return -1;
+    }
+
+    f = fopen(filename, "wb");
+    if (NULL == f) {
+        return -1;
+    }
+
+    if (0 == csr_file_write(f, &pos, 0, &header, sizeof(header)) &&
+        0 == csr_file_write_graph(f, &pos, csr) &&
+        (NULL == csr_r || 0 == csr_file_write_graph(f, &pos, csr_r))) {
+        rc = 0;
+    }
+
+    if (0 != fclose(f)) {
+        rc = -1;
+    }
+
+    return rc;
+}
+
+int
+csr_graph_save_graph(graph_t *graph, bool reverse, const char *filename)
+{
+    csr_graph_t *csr = csr_graph_from_graph(graph);
+    csr_graph_t *csr_r = NULL;
+    int rc = -1;
+
+    if (NULL == csr) {
+        return -1;
+    }
+
+    if (reverse) {
+        csr_r = csr_graph_reverse(csr);
+        if (NULL == csr_r) {
+            goto out;
+        }
+    }
+
+    rc = csr_graph_save(csr, csr_r, filename);
+
+out:
+    csr_graph_free(csr_r);
+    csr_graph_free(csr);
+    return rc;
+}
+
+/**
+ * Points csr to arrays of the mapping at pos, returns position following
+ * them or 0 if they don't fit in the mapping or offsets are inconsistent.
+ */
+static size_t
+csr_file_map_graph(csr_graph_file_t *file, csr_graph_t *csr, int size, size_t nedges, size_t pos)
+{
+    char *base = file->base;
+    size_t section[3];
+    size_t end;
+
+    if (nedges > file->length / sizeof(long)) {
+        return 0;
+    }
+
+    end = csr_file_layout(size, nedges, pos, section);
+    if (end > file->length) {
+        return 0;
+    }
+
+    csr->size = size;
+    csr->nedges = nedges;
+    csr->offsets = (size_t *)(base + section[0]);
+    csr->targets = (int *)(base + section[1]);
+    csr->weights = (long *)(base + section[2]);
+
+    if (0 != csr->offsets[0] || nedges != csr->offsets[size]) {
+        return 0;
+    }
+
+    return end;
+}
+
+int
+csr_graph_open(csr_graph_file_t *file, const char *filename)
+{
+    const csr_file_header_t *header;
+    struct stat st;
+    size_t pos;
+    int fd = open(filename, O_RDONLY);
+
+    memset(file, 0, sizeof(csr_graph_file_t));
+
+    if (-1 == fd) {
+        return -1;
+    }
+
+    if (0 != fstat(fd, &st) || (size_t)st.st_size < sizeof(csr_file_header_t)) {
+        close(fd);
+        return -1;
+    }
+
+    file->length = st.st_size;
+    file->base = mmap(NULL, file->length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (MAP_FAILED == file->base) {
+        file->base = NULL;
+        return -1;
+    }
+
+    header = file->base;
+    if (CSR_FILE_MAGIC != header->magic || CSR_FILE_VERSION != header->version ||
+        sizeof(size_t) != header->offset_size || sizeof(int) != header->target_size ||
+        sizeof(long) != header->weight_size ||
+        header->size < 0 || header->size > INT_MAX || header->nedges > SIZE_MAX) {
+        goto error;
+    }
+
+    pos = csr_file_map_graph(file, &file->graph, header->size, header->nedges, sizeof(csr_file_header_t));
+    if (0 == pos) {
+        goto error;
+    }
+
+    if (header->flags & CSR_FILE_F_REVERSE) {
+        if (0 == csr_file_map_graph(file, &file->reverse, header->size, header->nedges, pos)) {
+            goto error;
+        }
+        file->has_reverse = true;
+    }
+
+    return 0;
+
+error:
+    csr_graph_close(file);
+    return -1;
+}
+
+void
+csr_graph_close(csr_graph_file_t *file)
+{
+    if (NULL != file->base) {
+        munmap(file->base, file->length);
+    }
+    memset(file, 0, sizeof(csr_graph_file_t));
+}
+
+/**
+ * Breadth-first search from s, stops as soon as t is reached.
+ */
+int
+csr_graph_distance(const csr_graph_t *csr, graph_search_t *search, int s, int t)
+{
+    search_vertex_t *su = NULL;
+    int *queue = graph_search_queue(search);
+    int head = 0;
+    int tail = 0;
+    size_t i;
+
+    if (NULL == queue) {
+        return -1;
+    }
+
+    graph_search_reset(search);
+
+    su = graph_search_vertex(search, s);
+    su->visited = 1;
+    su->distance = 0;
+    queue[tail++] = s;
+
+    while (head < tail) {
+        int u = queue[head++];
+        if (u == t) {
+            break;
+        }
+        su = graph_search_vertex(search, u);
+        csr_graph_foreach(csr, u, i) {
+            search_vertex_t *sv = graph_search_vertex(search, csr->targets[i]);
+            if (!sv->visited) {
+                sv->visited = 1;
+                sv->distance = su->distance + 1;
+                sv->parent = u;
+                queue[tail++] = csr->targets[i];
+            }
+        }
+    }
+
+    su = graph_search_vertex(search, t);
+
+    return su->visited ? su->distance : -1;
+}
+
+bool
+csr_graph_connected(const csr_graph_t *csr, graph_search_t *search, int u, int v)
+{
+    return csr_graph_distance(csr, search, u, v) >= 0;
+}
+
+int
+csr_graph_connected_count(const csr_graph_t *csr)
+{
+    int count = 0;
+    int *distance = malloc(csr->size * sizeof(int));
+    int *queue = malloc(csr->size * sizeof(int));
+
+    if (NULL == distance || NULL == queue) {
+        count = -1;
+        goto out;
+    }
+
+    for (int u = 0; u < csr->size; ++u) {
+        distance[u] = -1;
+    }
+
+    for (int s = 0; s < csr->size; ++s) {
+        int head = 0;
+        int tail = 0;
+
+        if (distance[s] >= 0) {
+            continue;
+        }
+
+        ++count;
+        distance[s] = 0;
+        queue[tail++] = s;
+
+        while (head < tail) {
+            int u = queue[head++];
+            size_t i;
+            csr_graph_foreach(csr, u, i) {
+                int v = csr->targets[i];
+                if (distance[v] < 0) {
+                    distance[v] = distance[u] + 1;
+                    queue[tail++] = v;
+                }
+            }
+        }
+    }
+
+out:
+    free(distance);
+    free(queue);
+    return count;
+}
+
+typedef enum csr_dfs_state csr_dfs_state_t;
+
+enum csr_dfs_state {
+    CSR_DFS_UNVISITED = 0,
+    CSR_DFS_ACTIVE,  /**< on the dfs stack */
+    CSR_DFS_FINISHED
+};
+
+/**
+ * Iterative depth-first search: an arc to a vertex still on the stack
+ * closes a cycle.
+ */
+bool
+csr_graph_contains_cycle(const csr_graph_t *csr)
+{
+    bool cycle = false;
+    unsigned char *state = calloc(csr->size, sizeof(unsigned char));
+    int *stack = malloc(csr->size * sizeof(int));
+    size_t *next = malloc(csr->size * sizeof(size_t));
+
+    if (NULL == state || NULL == stack || NULL == next) {
+        goto out;
+    }
+
+    for (int s = 0; s < csr->size && !cycle; ++s) {
+        int top = 0;
+
+        if (CSR_DFS_UNVISITED != state[s]) {
+            continue;
+        }
+
+        state[s] = CSR_DFS_ACTIVE;
+        next[s] = csr->offsets[s];
+        stack[top++] = s;
+
+        while (top > 0) {
+            int u = stack[top - 1];
+
+            if (next[u] == csr->offsets[u + 1]) {
+                state[u] = CSR_DFS_FINISHED;
+                --top;
+                continue;
+            }
+
+            int v = csr->targets[next[u]++];
+
+            if (CSR_DFS_ACTIVE == state[v]) {
+                cycle = true;
+                break;
+            }
+            if (CSR_DFS_UNVISITED == state[v]) {
+                state[v] = CSR_DFS_ACTIVE;
+                next[v] = csr->offsets[v];
+                stack[top++] = v;
+            }
+        }
+    }
+
+out:
+    free(state);
+    free(stack);
+    free(next);
+    return cycle;
+}
+
+int
+csr_graph_scc(const csr_graph_t *csr, int *component)
+{
+    int *index = calloc(csr->size, sizeof(int));
+    int *stack = malloc(csr->size * sizeof(int));
+    int *members = malloc(csr->size * sizeof(int));
+    size_t *next = malloc(csr->size * sizeof(size_t));
+    int *low = component;
+    int counter = 0;
+    int count = -1;
+
+    if (NULL == index || NULL == stack || NULL == members || NULL == next) {
+        goto out;
+    }
+
+    /**
+     * Tarjan's algorithm: stack holds the dfs path, members the vertices
+     * of components not complete yet. Lowlinks are kept in component
+     * until vertices are assigned their component, and index of assigned
+     * vertices is set to INT_MAX so that arcs to them never lower a
+     * lowlink (no on-stack flag needed).
+     */
+    count = 0;
+    for (int s = 0; s < csr->size; ++s) {
+        int top = 0;
+        int nmembers = 0;
+
+        if (0 != index[s]) {
+            continue;
+        }
+
+        index[s] = low[s] = ++counter;
+        next[s] = csr->offsets[s];
+        stack[top++] = s;
+        members[nmembers++] = s;
+
+        while (top > 0) {
+            int u = stack[top - 1];
+
+            if (next[u] < csr->offsets[u + 1]) {
+                int v = csr->targets[next[u]++];
+
+                if (0 == index[v]) {
+                    index[v] = low[v] = ++counter;
+                    next[v] = csr->offsets[v];
+                    stack[top++] = v;
+                    members[nmembers++] = v;
+                }
+                else if (index[v] < low[u]) {
+                    low[u] = index[v];
+                }
+                continue;
+            }
+
+            --top;
+            if (low[u] == index[u]) {
+                int w;
+                do {
+                    w = members[--nmembers];
+                    index[w] = INT_MAX;
+                    component[w] = count;
+                } while (w != u);
+                ++count;
+            }
+            else if (low[u] < low[stack[top - 1]]) {
+                low[stack[top - 1]] = low[u];
+            }
+        }
+    }
+
+    /**
+     * Tarjan completes components in reverse topological order.
+     */
+    for (int u = 0; u < csr->size; ++u) {
+        component[u] = count - 1 - component[u];
+    }
+
+out:
+    free(index);
+    free(stack);
+    free(members);
+    free(next);
+    return count;
+}
+
+int
+csr_graph_topological_sort(const csr_graph_t *csr, int *order)
+{
+    int *indegree = calloc(csr->size, sizeof(int));
+    int head = 0;
+    int tail = 0;
+
+    if (NULL == indegree) {
+        return -1;
+    }
+
+    /**
+     * Kahn's algorithm, order doubling as the queue of vertices whose
+     * predecessors are all ordered.
+     */
+    for (size_t i = 0; i < csr->nedges; ++i) {
+        indegree[csr->targets[i]]++;
+    }
+    for (int u = 0; u < csr->size; ++u) {
+        if (0 == indegree[u]) {
+            order[tail++] = u;
+        }
+    }
+    while (head < tail) {
+        int u = order[head++];
+        size_t i;
+
+        csr_graph_foreach(csr, u, i) {
+            if (0 == --indegree[csr->targets[i]]) {
+                order[tail++] = csr->targets[i];
+            }
+        }
+    }
+
+    free(indegree);
+    return tail == csr->size ? 0 : -1;
+}
+
+/**
+ * Visits arcs between distinct components, out of component c, once per
+ * target component: first arc to d gets slot[d] (next free arc of the
+ * condensation when dag is not NULL), following ones only lower its
+ * weight. Returns number of distinct target components.
+ */
+static size_t
+csr_graph_condensation_arcs(const csr_graph_t *csr, const int *component, const int *members,
+                            size_t begin, size_t end, int *mark, size_t *slot, csr_graph_t *dag, size_t arc)
+{
+    int c = component[members[begin]];
+    size_t count = 0;
+
+    for (size_t m = begin; m < end; ++m) {
+        int u = members[m];
+        size_t i;
+
+        csr_graph_foreach(csr, u, i) {
+            int d = component[csr->targets[i]];
+
+            if (d == c) {
+                continue;
+            }
+            if (mark[d] != c) {
+                mark[d] = c;
+                slot[d] = arc + count++;
+                if (NULL != dag) {
+                    dag->targets[slot[d]] = d;
+                    dag->weights[slot[d]] = csr->weights[i];
+                }
+            }
+            else if (NULL != dag && csr->weights[i] < dag->weights[slot[d]]) {
+                dag->weights[slot[d]] = csr->weights[i];
+            }
+        }
+    }
+    return count;
+}
+
+csr_graph_t *
+csr_graph_condensation(const csr_graph_t *csr, const int *component, int ncomponents)
+{
+    size_t *start = calloc(ncomponents + 1, sizeof(size_t));
+    size_t *count = malloc((ncomponents + 1) * sizeof(size_t));
+    size_t *slot = malloc((ncomponents ? ncomponents : 1) * sizeof(size_t));
+    int *mark = malloc((ncomponents ? ncomponents : 1) * sizeof(int));
+    int *members = malloc((csr->size ? csr->size : 1) * sizeof(int));
+    csr_graph_t *dag = NULL;
+    size_t nedges = 0;
+    int u, c;
+
+    if (NULL == start || NULL == count || NULL == slot || NULL == mark || NULL == members) {
+        goto out;
+    }
+
+    /**
+     * Groups vertices by component (counting sort).
+     */
+    for (u = 0; u < csr->size; ++u) {
+        start[component[u] + 1]++;
+    }
+    for (c = 0; c < ncomponents; ++c) {
+        start[c + 1] += start[c];
+    }
+    memcpy(count, start, (ncomponents + 1) * sizeof(size_t));
+    for (u = 0; u < csr->size; ++u) {
+        members[count[component[u]]++] = u;
+    }
+
+    /**
+     * First pass counts arcs of every component, second one fills them.
+     */
+    for (c = 0; c < ncomponents; ++c) {
+        mark[c] = -1;
+    }
+    for (c = 0; c < ncomponents; ++c) {
+        count[c] = start[c] == start[c + 1] ? 0 :
+            csr_graph_condensation_arcs(csr, component, members, start[c], start[c + 1], mark, slot, NULL, 0);
+        nedges += count[c];
+    }
+
+    dag = csr_graph_new(ncomponents, nedges);
+    if (NULL == dag) {
+        goto out;
+    }
+
+    for (c = 0; c < ncomponents; ++c) {
+        mark[c] = -1;
+    }
+    for (c = 0; c < ncomponents; ++c) {
+        dag->offsets[c + 1] = dag->offsets[c] + count[c];
+        if (start[c] < start[c + 1]) {
+            csr_graph_condensation_arcs(csr, component, members, start[c], start[c + 1], mark, slot, dag, dag->offsets[c]);
+        }
+    }
+
+out:
+    free(start);
+    free(count);
+    free(slot);
+    free(mark);
+    free(members);
+    return dag;
+}
+
+bool
+csr_graph_is_bipartite(const csr_graph_t *csr)
+{
+    bool bipartite = true;
+    int *color = malloc(csr->size * sizeof(int));
+    int *queue = malloc(csr->size * sizeof(int));
+
+    if (NULL == color || NULL == queue) {
+        bipartite = false;
+        goto out;
+    }
+
+    for (int u = 0; u < csr->size; ++u) {
+        color[u] = -1;
+    }
+
+    for (int s = 0; s < csr->size && bipartite; ++s) {
+        int head = 0;
+        int tail = 0;
+
+        if (color[s] >= 0) {
+            continue;
+        }
+
+        color[s] = WHITE;
+        queue[tail++] = s;
+
+        while (head < tail && bipartite) {
+            int u = queue[head++];
+            size_t i;
+            csr_graph_foreach(csr, u, i) {
+                int v = csr->targets[i];
+                if (color[v] < 0) {
+                    color[v] = color[u] == WHITE ? BLACK : WHITE;
+                    queue[tail++] = v;
+                }
+                else if (color[v] == color[u]) {
+                    bipartite = false;
+                    break;
+                }
+            }
+        }
+    }
+
+out:
+    free(color);
+    free(queue);
+    return bipartite;
+}
+
+long
+csr_graph_dijkstra_distance(const csr_graph_t *csr, graph_search_t *search, int s, int t)
+{
+    csr_heap_entry_t entry = { 0, s };
+    search_vertex_t *su = NULL;
+    csr_heap_t *h = csr_heap_new(0);
+
+    if (NULL == h) {
+        return -1;
+    }
+
+    graph_search_reset(search);
+
+    graph_search_vertex(search, s)->distance = 0;
+    if (0 != csr_heap_insert(h, &entry)) {
+        goto error;
+    }
+
+    while (NULL != csr_heap_pop_front(h, &entry)) {
+        int u = entry.vertex;
+        size_t i;
+
+        su = graph_search_vertex(search, u);
+        if (su->visited) {
+            continue; /**< stale entry */
+        }
+        su->visited = 1;
+        if (u == t) {
+            break;
+        }
+
+        csr_graph_foreach(csr, u, i) {
+            search_vertex_t *sv = graph_search_vertex(search, csr->targets[i]);
+            long d = su->distance + csr->weights[i];
+            if (d < sv->distance) {
+                sv->distance = d;
+                sv->parent = u;
+                entry.key = d;
+                entry.vertex = csr->targets[i];
+                if (0 != csr_heap_insert(h, &entry)) {
+                    goto error;
+                }
+            }
+        }
+    }
+
+    csr_heap_free(h);
+
+    su = graph_search_vertex(search, t);
+
+    return LONG_MAX == su->distance ? -1 : su->distance;
+
+error:
+    csr_heap_free(h);
+    return -1;
+}
+
+/**
+ * Settles top of the heap of one search direction and relaxes its arcs.
+ *
+ * Whenever an arc reaches a vertex already labeled by the other search
+ * direction, best known s-t distance is updated.
+ *
+ * @return zero on success, -1 on allocation failure.
+ */
+static int
+csr_graph_bidirectional_step(const csr_graph_t *csr, csr_heap_t *h, graph_search_t *search, graph_search_t *search_o, long *best)
+{
+    csr_heap_entry_t entry = { 0, -1 };
+    search_vertex_t *su = NULL;
+    size_t i;
+    int u;
+
+    csr_heap_pop_front(h, &entry);
+
+    u = entry.vertex;
+    su = graph_search_vertex(search, u);
+    if (su->visited) {
+        return 0;
+    }
+    su->visited = 1;
+
+    csr_graph_foreach(csr, u, i) {
+        int v = csr->targets[i];
+        search_vertex_t *sv = graph_search_vertex(search, v);
+        search_vertex_t *sv_o = graph_search_vertex(search_o, v);
+        long d = su->distance + csr->weights[i];
+        if (d < sv->distance) {
+            sv->distance = d;
+            sv->parent = u;
+            entry.key = d;
+            entry.vertex = v;
+            if (0 != csr_heap_insert(h, &entry)) {
+                return -1;
+            }
+        }
+        if (LONG_MAX != sv_o->distance && d + sv_o->distance < *best) {
+            *best = d + sv_o->distance;
+        }
+    }
+    return 0;
+}
+
+long
+csr_graph_bidirectional_dijkstra_distance(const csr_graph_t *csr, const csr_graph_t *csr_r, graph_search_t *search, graph_search_t *search_r, int s, int t)
+{
+    long best = LONG_MAX;
+    csr_heap_t *h = csr_heap_new(0);
+    csr_heap_t *h_r = csr_heap_new(0);
+    csr_heap_entry_t entry;
+
+    if (NULL == h || NULL == h_r) {
+        goto out;
+    }
+
+    graph_search_reset(search);
+    graph_search_reset(search_r);
+
+    graph_search_vertex(search, s)->distance = 0;
+    graph_search_vertex(search_r, t)->distance = 0;
+    if (s == t) {
+        best = 0;
+    }
+
+    entry.key = 0;
+    entry.vertex = s;
+    if (0 != csr_heap_insert(h, &entry)) {
+        goto error;
+    }
+    entry.vertex = t;
+    if (0 != csr_heap_insert(h_r, &entry)) {
+        goto error;
+    }
+
+    /**
+     * Stop when no path through vertices not yet settled by any side
+     * can be shorter than the best path found so far.
+     */
+    while (csr_heap_size(h) > 0 && csr_heap_size(h_r) > 0) {
+        const csr_heap_entry_t *top = csr_heap_top(h);
+        const csr_heap_entry_t *top_r = csr_heap_top(h_r);
+
+        if (LONG_MAX != best && top->key + top_r->key >= best) {
+            break;
+        }
+
+        if (0 != (top->key <= top_r->key ?
+                  csr_graph_bidirectional_step(csr, h, search, search_r, &best) :
+                  csr_graph_bidirectional_step(csr_r, h_r, search_r, search, &best))) {
+            goto error;
+        }
+    }
+
+out:
+    if (NULL != h) {
+        csr_heap_free(h);
+    }
+    if (NULL != h_r) {
+        csr_heap_free(h_r);
+    }
+
+    return LONG_MAX == best ? -1 : best;
+
+error:
+    best = LONG_MAX;
+    goto out;
+}
+
+bool
+csr_graph_negative_cycle(const csr_graph_t *csr)
+{
+    bool relaxed = true;
+    long *distance = calloc(csr->size, sizeof(long));
+
+    if (NULL == distance) {
+        return false;
+    }
+
+    /**
+     * All-zero initial distances act as a virtual source connected to
+     * every vertex, so cycles in any component are found.
+     */
+    for (int j = 0; j < csr->size && relaxed; ++j) {
+        relaxed = false;
+        for (int u = 0; u < csr->size; ++u) {
+            size_t i;
+            csr_graph_foreach(csr, u, i) {
+                int v = csr->targets[i];
+                if (distance[v] > distance[u] + csr->weights[i]) {
+                    distance[v] = distance[u] + csr->weights[i];
+                    relaxed = true;
+                }
+            }
+        }
+    }
+
+    free(distance);
+
+    return relaxed;
+}
+
+int
+csr_graph_shortest_paths(const csr_graph_t *csr, int s, long *distance, int *parent)
+{
+    int *cycle = NULL;
+    int ncycle = 0;
+    int rc = 0;
+
+    for (int u = 0; u < csr->size; ++u) {
+        distance[u] = LONG_MAX;
+        if (NULL != parent) {
+            parent[u] = -1;
+        }
+    }
+
+    distance[s] = 0;
+
+    for (int j = 0; j < csr->size; ++j) {
+        bool relaxed = false;
+        for (int u = 0; u < csr->size; ++u) {
+            size_t i;
+            if (LONG_MAX == distance[u]) {
+                continue;
+            }
+            csr_graph_foreach(csr, u, i) {
+                int v = csr->targets[i];
+                if (distance[v] > distance[u] + csr->weights[i]) {
+                    distance[v] = distance[u] + csr->weights[i];
+                    if (NULL != parent) {
+                        parent[v] = u;
+                    }
+                    relaxed = true;
+                    if (j == csr->size - 1) {
+                        if (NULL == cycle) {
+                            cycle = malloc(csr->nedges * sizeof(int));
+                            if (NULL == cycle) {
+                                return -1;
+                            }
+                        }
+                        cycle[ncycle++] = v;
+                    }
+                }
+            }
+        }
+        if (!relaxed) {
+            break;
+        }
+    }
+
+    if (NULL != cycle) {
+        /**
+         * Vertices still relaxed at V-th iteration are reachable from a
+         * negative cycle, as is everything reachable from them.
+         */
+        bool *visited = calloc(csr->size, sizeof(bool));
+        int *stack = malloc((csr->nedges + 1) * sizeof(int));
+        int top = 0;
+
+        if (NULL != visited && NULL != stack) {
+            while (ncycle > 0) {
+                stack[top++] = cycle[--ncycle];
+                while (top > 0) {
+                    int u = stack[--top];
+                    size_t i;
+                    if (visited[u]) {
+                        continue;
+                    }
+                    visited[u] = true;
+                    distance[u] = LONG_MIN;
+                    csr_graph_foreach(csr, u, i) {
+                        if (!visited[csr->targets[i]]) {
+                            stack[top++] = csr->targets[i];
+                        }
+                    }
+                }
+            }
+        }
+        else {
+            rc = -1;
+        }
+
+        free(visited);
+        free(stack);
+        free(cycle);
+    }
+
+    return rc;
+}
+
+static bool
+csr_atomic_min(atomic_long *p, long value)
+{
+    long current = atomic_load_explicit(p, memory_order_relaxed);
+
+    while (value < current) {
+        if (atomic_compare_exchange_weak(p, &current, value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void
+csr_atomic_max(atomic_long *p, long value)
+{
+    long current = atomic_load_explicit(p, memory_order_relaxed);
+
+    while (value > current && !atomic_compare_exchange_weak(p, &current, value)) {
+    }
+}
+
+static void
+csr_atomic_min_int(atomic_int *p, int value)
+{
+    int current = atomic_load_explicit(p, memory_order_relaxed);
+
+    while (value < current && !atomic_compare_exchange_weak(p, &current, value)) {
+    }
+}
+
+typedef struct csr_bucket csr_bucket_t;
+
+struct csr_bucket {
+    int *vertices;
+    size_t size;
+    size_t capacity;
+};
+
+static int
+csr_bucket_push(csr_bucket_t *bucket, int v)
+{
+    if (bucket->size == bucket->capacity) {
+        size_t capacity = bucket->capacity ? 2 * bucket->capacity : 16;
+        int *vertices = realloc(bucket->vertices, capacity * sizeof(int));
+        if (NULL == vertices) {
+            return -1;
+        }
+        bucket->vertices = vertices;
+        bucket->capacity = capacity;
+    }
+    bucket->vertices[bucket->size++] = v;
+    return 0;
+}
+
+typedef struct csr_buckets csr_buckets_t;
+
+/**
+ * Buckets of one delta-stepping thread: a cyclic window starting at the
+ * current bucket and an overflow bucket for distances beyond it.
+ */
+struct csr_buckets {
+    csr_bucket_t *window;
+    csr_bucket_t overflow;
+    long overflow_min; /**< smallest bucket of overflow entries, LONG_MAX if none */
+};
+
+typedef struct csr_delta_stepping csr_delta_stepping_t;
+
+/**
+ * Delta-stepping state shared by all threads.
+ *
+ * Every thread keeps buckets of its own, where vertices whose tentative
+ * distance it lowered are stored, bucket i holding distances in range
+ * [i * delta, (i + 1) * delta). Buckets are cyclic: tentative distances
+ * never exceed those of the current bucket by more than the maximum arc
+ * weight, so only max_weight / delta + 2 buckets are in use at any time.
+ * That window is capped to CSR_DELTA_STEPPING_BUCKETS, vertices beyond
+ * it wait in the overflow bucket until the window reaches them.
+ *
+ * Phases run in lock step: all threads relax light arcs (weight <= delta)
+ * of the shared frontier, agree on the smallest non empty bucket, then
+ * move their entries of that bucket into the next frontier. The same
+ * bucket is processed again as long as light arcs keep feeding it. Once
+ * it stays empty, distances of the vertices it held are final and their
+ * heavy arcs, which can't lead back into it, are relaxed once.
+ */
+struct csr_delta_stepping {
+    const csr_graph_t *csr;
+    int source;
+    long delta;
+    atomic_long *distance;
+    atomic_uint *queued;       /**< last phase in which vertex joined frontier */
+    atomic_int *parent;        /**< INT_MAX while unknown */
+    int *frontier;             /**< each vertex at most once per phase */
+    size_t nfrontier;
+    atomic_size_t next;        /**< next frontier entry to be claimed */
+    int *settled;              /**< vertices of the current bucket */
+    atomic_size_t nsettled;
+    atomic_size_t next_settled; /**< next settled entry to be claimed */
+    bool has_heavy;            /**< some arc is heavier than delta */
+    atomic_size_t tail;        /**< size of frontier of next phase */
+    size_t nbuckets;
+    long bucket;               /**< bucket being processed */
+    atomic_long next_bucket;   /**< smallest non empty bucket, LONG_MAX if none */
+    unsigned phase;
+    unsigned bucket_phase;     /**< first phase of bucket being processed */
+    atomic_long max_weight;
+    atomic_long total_weight;
+    atomic_int error;
+    atomic_size_t unresolved;  /**< reached vertices left without parent */
+    parallel_barrier_t barrier;
+};
+
+/**
+ * Relaxes light arcs of frontier vertices or heavy arcs of settled ones.
+ */
+static void
+csr_delta_stepping_relax(csr_delta_stepping_t *ds, csr_buckets_t *buckets, bool heavy)
+{
+    const csr_graph_t *csr = ds->csr;
+    const int *vertices = heavy ? ds->settled : ds->frontier;
+    size_t n = heavy ? atomic_load(&ds->nsettled) : ds->nfrontier;
+    atomic_size_t *next = heavy ? &ds->next_settled : &ds->next;
+    size_t first;
+
+    while ((first = atomic_fetch_add(next, CSR_DELTA_STEPPING_CHUNK)) < n) {
+        size_t last = first + CSR_DELTA_STEPPING_CHUNK;
+
+        if (last > n) {
+            last = n;
+        }
+
+        for (size_t k = first; k < last; ++k) {
+            int u = vertices[k];
+            long du = atomic_load_explicit(&ds->distance[u], memory_order_relaxed);
+            size_t i;
+
+            csr_graph_foreach(csr, u, i) {
+                int v = csr->targets[i];
+                long d = du + csr->weights[i];
+                long b = d / ds->delta;
+                csr_bucket_t *bucket;
+                if ((csr->weights[i] > ds->delta) != heavy || !csr_atomic_min(&ds->distance[v], d)) {
+                    continue;
+                }
+                if ((size_t)(b - ds->bucket) < ds->nbuckets) {
+                    bucket = &buckets->window[b % ds->nbuckets];
+                }
+                else {
+                    bucket = &buckets->overflow;
+                    if (b < buckets->overflow_min) {
+                        buckets->overflow_min = b;
+                    }
+                }
+                if (csr_bucket_push(bucket, v) < 0) {
+                    atomic_store(&ds->error, 1);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Returns smallest non empty bucket of all threads, LONG_MAX if none.
+ *
+ * Overflow entries count at the smallest bucket they were pushed to,
+ * which might be before the one their vertex is in now.
+ */
+static long
+csr_delta_stepping_next_bucket(csr_delta_stepping_t *ds, csr_buckets_t *buckets, int nthreads)
+{
+    long b = buckets->overflow_min;
+
+    for (size_t k = 0; k < ds->nbuckets && ds->bucket + (long)k < b; ++k) {
+        if (buckets->window[(ds->bucket + k) % ds->nbuckets].size > 0) {
+            b = ds->bucket + k;
+            break;
+        }
+    }
+    csr_atomic_min(&ds->next_bucket, b);
+    parallel_barrier_wait(&ds->barrier, nthreads);
+
+    return atomic_load(&ds->next_bucket);
+}
+
+/**
+ * Moves overflow entries of buckets that fall in the window starting at
+ * b into the window. Entries of vertices that meanwhile moved before b
+ * were already processed from the bucket they moved to and are dropped.
+ */
+static void
+csr_delta_stepping_refill(csr_delta_stepping_t *ds, csr_buckets_t *buckets, long b)
+{
+    csr_bucket_t *overflow = &buckets->overflow;
+    size_t kept = 0;
+
+    if (buckets->overflow_min - b >= (long)ds->nbuckets) {
+        return;
+    }
+
+    buckets->overflow_min = LONG_MAX;
+    for (size_t k = 0; k < overflow->size; ++k) {
+        int v = overflow->vertices[k];
+        long i = atomic_load_explicit(&ds->distance[v], memory_order_relaxed) / ds->delta;
+        if (i < b) {
+            continue;
+        }
+        if (i - b < (long)ds->nbuckets) {
+            if (csr_bucket_push(&buckets->window[i % ds->nbuckets], v) < 0) {
+                atomic_store(&ds->error, 1);
+            }
+            continue;
+        }
+        overflow->vertices[kept++] = v;
+        if (i < buckets->overflow_min) {
+            buckets->overflow_min = i;
+        }
+    }
+    overflow->size = kept;
+}
+
+/**
+ * Moves entries of bucket b into the frontier of next phase, skipping
+ * vertices that meanwhile moved to an earlier bucket or that another
+ * thread already moved. Vertices joining the frontier for the first time
+ * since b became the current bucket are also added to settled.
+ */
+static void
+csr_delta_stepping_gather(csr_delta_stepping_t *ds, csr_bucket_t *bucket, long b)
+{
+    unsigned phase = ds->phase + 1;
+    unsigned first = b == ds->bucket ? ds->bucket_phase : phase;
+
+    for (size_t k = 0; k < bucket->size; ++k) {
+        int v = bucket->vertices[k];
+        unsigned queued;
+        if (atomic_load_explicit(&ds->distance[v], memory_order_relaxed) / ds->delta != b) {
+            continue;
+        }
+        queued = atomic_exchange(&ds->queued[v], phase);
+        if (queued == phase) {
+            continue;
+        }
+        if (ds->has_heavy && queued < first) {
+            ds->settled[atomic_fetch_add(&ds->nsettled, 1)] = v;
+        }
+        ds->frontier[atomic_fetch_add(&ds->tail, 1)] = v;
+    }
+    bucket->size = 0;
+}
+
+/**
+ * Parent of v is the lowest numbered u with an arc u -> v of positive
+ * weight on a shortest path, which keeps parents deterministic whatever
+ * the order arcs were relaxed in. Vertices only reached through zero
+ * weight arcs are left for csr_graph_delta_stepping to resolve.
+ */
+static void
+csr_delta_stepping_parents(csr_delta_stepping_t *ds, int id, int nthreads)
+{
+    const csr_graph_t *csr = ds->csr;
+    size_t begin, end, unresolved = 0;
+
+    parallel_range(csr->size, id, nthreads, &begin, &end);
+
+    for (size_t u = begin; u < end; ++u) {
+        long du = atomic_load_explicit(&ds->distance[u], memory_order_relaxed);
+        size_t i;
+
+        if (LONG_MAX == du) {
+            continue;
+        }
+        csr_graph_foreach(csr, u, i) {
+            int v = csr->targets[i];
+            if (csr->weights[i] > 0 &&
+                du + csr->weights[i] == atomic_load_explicit(&ds->distance[v], memory_order_relaxed)) {
+                csr_atomic_min_int(&ds->parent[v], (int)u);
+            }
+        }
+    }
+
+    parallel_barrier_wait(&ds->barrier, nthreads);
+
+    for (size_t v = begin; v < end; ++v) {
+        if ((int)v != ds->source &&
+            LONG_MAX != atomic_load_explicit(&ds->distance[v], memory_order_relaxed) &&
+            INT_MAX == atomic_load_explicit(&ds->parent[v], memory_order_relaxed)) {
+            ++unresolved;
+        }
+    }
+    atomic_fetch_add(&ds->unresolved, unresolved);
+}
+
+static void
+csr_delta_stepping_worker(void *arg, int id, int nthreads)
+{
+    csr_delta_stepping_t *ds = arg;
+    const csr_graph_t *csr = ds->csr;
+    csr_buckets_t buckets = { NULL, { NULL, 0, 0 }, LONG_MAX };
+    size_t begin, end, i;
+    long max_weight = 0;
+    long total_weight = 0;
+
+    parallel_range(csr->size, id, nthreads, &begin, &end);
+    for (i = begin; i < end; ++i) {
+        atomic_init(&ds->distance[i], LONG_MAX);
+        atomic_init(&ds->queued[i], 0);
+        atomic_init(&ds->parent[i], INT_MAX);
+    }
+
+    parallel_range(csr->nedges, id, nthreads, &begin, &end);
+    for (i = begin; i < end; ++i) {
+        if (csr->weights[i] < 0) {
+            atomic_store(&ds->error, 1);
+        }
+        if (csr->weights[i] > max_weight) {
+            max_weight = csr->weights[i];
+        }
+        total_weight += csr->weights[i];
+    }
+    csr_atomic_max(&ds->max_weight, max_weight);
+    atomic_fetch_add(&ds->total_weight, total_weight);
+
+    if (parallel_barrier_wait(&ds->barrier, nthreads)) {
+        if (ds->delta <= 0) {
+            /** average arc weight */
+            ds->delta = csr->nedges ? atomic_load(&ds->total_weight) / (long)csr->nedges : 1;
+            if (ds->delta <= 0) {
+                ds->delta = 1;
+            }
+        }
+        ds->nbuckets = atomic_load(&ds->max_weight) / ds->delta;
+        ds->nbuckets = ds->nbuckets < CSR_DELTA_STEPPING_BUCKETS - 2 ? ds->nbuckets + 2 : CSR_DELTA_STEPPING_BUCKETS;
+        ds->has_heavy = atomic_load(&ds->max_weight) > ds->delta;
+        atomic_store(&ds->distance[ds->source], 0);
+        ds->frontier[0] = ds->source;
+        ds->nfrontier = 1;
+        ds->settled[0] = ds->source;
+        atomic_store(&ds->nsettled, 1);
+        /** queued starts at 0, before any phase */
+        ds->phase = ds->bucket_phase = 1;
+    }
+    parallel_barrier_wait(&ds->barrier, nthreads);
+
+    buckets.window = calloc(ds->nbuckets, sizeof(csr_bucket_t));
+    if (NULL == buckets.window) {
+        atomic_store(&ds->error, 1);
+    }
+    parallel_barrier_wait(&ds->barrier, nthreads);
+
+    if (atomic_load(&ds->error)) {
+        goto out;
+    }
+
+    for (;;) {
+        long b;
+
+        csr_delta_stepping_relax(ds, &buckets, false);
+        parallel_barrier_wait(&ds->barrier, nthreads);
+
+        b = csr_delta_stepping_next_bucket(ds, &buckets, nthreads);
+        if (b != ds->bucket && ds->has_heavy && !atomic_load(&ds->error)) {
+            csr_delta_stepping_relax(ds, &buckets, true);
+            if (parallel_barrier_wait(&ds->barrier, nthreads)) {
+                atomic_store(&ds->nsettled, 0);
+                atomic_store(&ds->next_settled, 0);
+                atomic_store(&ds->next_bucket, LONG_MAX);
+            }
+            parallel_barrier_wait(&ds->barrier, nthreads);
+
+            b = csr_delta_stepping_next_bucket(ds, &buckets, nthreads);
+        }
+        if (LONG_MAX == b || atomic_load(&ds->error)) {
+            break;
+        }
+
+        csr_delta_stepping_refill(ds, &buckets, b);
+        csr_delta_stepping_gather(ds, &buckets.window[b % ds->nbuckets], b);
+
+        if (parallel_barrier_wait(&ds->barrier, nthreads)) {
+            ds->nfrontier = atomic_load(&ds->tail);
+            atomic_store(&ds->tail, 0);
+            atomic_store(&ds->next, 0);
+            atomic_store(&ds->next_bucket, LONG_MAX);
+            if (b != ds->bucket) {
+                ds->bucket_phase = ds->phase + 1;
+            }
+            ds->bucket = b;
+            ds->phase++;
+        }
+        parallel_barrier_wait(&ds->barrier, nthreads);
+    }
+
+    if (!atomic_load(&ds->error)) {
+        csr_delta_stepping_parents(ds, id, nthreads);
+    }
+
+out:
+    if (NULL != buckets.window) {
+        for (i = 0; i < ds->nbuckets; ++i) {
+            free(buckets.window[i].vertices);
+        }
+        free(buckets.window);
+    }
+    free(buckets.overflow.vertices);
+}
+
+int
+csr_graph_delta_stepping(const csr_graph_t *csr, int s, long delta, int nthreads, long *distance, int *parent)
+{
+    csr_delta_stepping_t ds;
+    int *queue = NULL;
+    int rc = -1;
+
+    memset(&ds, 0, sizeof(ds));
+
+    ds.csr = csr;
+    ds.source = s;
+    ds.delta = delta;
+    ds.distance = malloc(csr->size * sizeof(atomic_long));
+    ds.queued = malloc(csr->size * sizeof(atomic_uint));
+    ds.parent = malloc(csr->size * sizeof(atomic_int));
+    ds.frontier = malloc(csr->size * sizeof(int));
+    ds.settled = malloc(csr->size * sizeof(int));
+    atomic_init(&ds.next, 0);
+    atomic_init(&ds.nsettled, 0);
+    atomic_init(&ds.next_settled, 0);
+    atomic_init(&ds.tail, 0);
+    atomic_init(&ds.next_bucket, LONG_MAX);
+    atomic_init(&ds.max_weight, 0);
+    atomic_init(&ds.total_weight, 0);
+    atomic_init(&ds.error, 0);
+    atomic_init(&ds.unresolved, 0);
+    parallel_barrier_init(&ds.barrier);
+
+    if (NULL == ds.distance || NULL == ds.queued || NULL == ds.parent || NULL == ds.frontier ||
+        NULL == ds.settled) {
+        goto out;
+    }
+
+    parallel_run(parallel_threads(nthreads), csr_delta_stepping_worker, &ds);
+
+    if (atomic_load(&ds.error)) {
+        goto out;
+    }
+
+    for (int u = 0; u < csr->size; ++u) {
+        int p = atomic_load_explicit(&ds.parent[u], memory_order_relaxed);
+        distance[u] = atomic_load_explicit(&ds.distance[u], memory_order_relaxed);
+        if (NULL != parent) {
+            parent[u] = INT_MAX == p ? -1 : p;
+        }
+    }
+
+    if (NULL != parent && atomic_load(&ds.unresolved) > 0) {
+        /**
+         * Vertices only reached through zero weight arcs: parents are
+         * found by a BFS over such arcs from vertices already resolved,
+         * so that zero weight cycles can't turn into parent cycles.
+         */
+        int head = 0;
+        int tail = 0;
+
+        queue = malloc(csr->size * sizeof(int));
+        if (NULL == queue) {
+            goto out;
+        }
+
+        for (int u = 0; u < csr->size; ++u) {
+            if (LONG_MAX != distance[u] && (u == s || -1 != parent[u])) {
+                queue[tail++] = u;
+            }
+        }
+
+        while (head < tail) {
+            int u = queue[head++];
+            size_t i;
+            csr_graph_foreach(csr, u, i) {
+                int v = csr->targets[i];
+                if (0 == csr->weights[i] && distance[u] == distance[v] && v != s && -1 == parent[v]) {
+                    parent[v] = u;
+                    queue[tail++] = v;
+                }
+            }
+        }
+    }
+
+    rc = 0;
+
+out:
+    free(ds.distance);
+    free(ds.queued);
+    free(ds.parent);
+    free(ds.frontier);
+    free(ds.settled);
+    free(queue);
+    return rc;
+}
+
+typedef struct csr_bfs csr_bfs_t;
+
+enum {
+    CSR_BFS_TOP_DOWN,
+    CSR_BFS_BOTTOM_UP
+};
+
+/**
+ * Direction-optimizing BFS state shared by all threads.
+ *
+ * Top-down steps scan arcs out of a frontier kept as a queue, claiming
+ * vertices by compare-and-swap on their parent. Bottom-up steps have
+ * every unvisited vertex look for a parent among its in-neighbors, the
+ * frontier kept as a bitmap: on low diameter graphs the few middle levels
+ * hold most vertices, and most of their arcs lead to vertices already
+ * visited, which bottom-up steps stop scanning at the first parent found.
+ *
+ * Bottom-up steps split vertices in ranges of whole bitmap words, so each
+ * thread writes words of the next frontier nobody else writes.
+ */
+struct csr_bfs {
+    const csr_graph_t *csr;
+    const csr_graph_t *csr_r;
+    int source;
+    int *distance;
+    atomic_int *parent;        /**< -1 while unvisited */
+    int *queue;
+    int *next_queue;
+    size_t nqueue;
+    atomic_size_t next;        /**< next queue entry to be claimed */
+    atomic_size_t tail;        /**< size of next_queue */
+    atomic_ullong *frontier;
+    atomic_ullong *next_frontier;
+    size_t nwords;
+    int *local;                /**< CSR_BFS_LOCAL entries per thread */
+    int mode;
+    int convert;               /**< frontier must change representation */
+    int level;
+    size_t nfrontier;
+    atomic_size_t count;       /**< vertices found by current step */
+    atomic_size_t scout;       /**< arcs out of vertices found by current step */
+    size_t unexplored;         /**< arcs out of vertices not visited yet */
+    parallel_barrier_t barrier;
+};
+
+static inline bool
+csr_bfs_bit(atomic_ullong *bitmap, int v)
+{
+    return (atomic_load_explicit(&bitmap[v >> 6], memory_order_relaxed) >> (v & 63)) & 1;
+}
+
+static void
+csr_bfs_top_down(csr_bfs_t *bfs, int id)
+{
+    const csr_graph_t *csr = bfs->csr;
+    int *local = &bfs->local[(size_t)id * CSR_BFS_LOCAL];
+    size_t nlocal = 0;
+    size_t scout = 0;
+    size_t found = 0;
+    size_t first;
+
+    while ((first = atomic_fetch_add(&bfs->next, CSR_BFS_CHUNK)) < bfs->nqueue) {
+        size_t last = first + CSR_BFS_CHUNK < bfs->nqueue ? first + CSR_BFS_CHUNK : bfs->nqueue;
+
+        for (size_t k = first; k < last; ++k) {
+            int u = bfs->queue[k];
+            size_t i;
+            csr_graph_foreach(csr, u, i) {
+                int v = csr->targets[i];
+                int unvisited = -1;
+                if (-1 != atomic_load_explicit(&bfs->parent[v], memory_order_relaxed) ||
+                    !atomic_compare_exchange_strong(&bfs->parent[v], &unvisited, u)) {
+                    continue;
+                }
+                bfs->distance[v] = bfs->level + 1;
+                scout += csr_graph_degree(csr, v);
+                ++found;
+                if (CSR_BFS_LOCAL == nlocal) {
+                    memcpy(&bfs->next_queue[atomic_fetch_add(&bfs->tail, nlocal)], local, nlocal * sizeof(int));
+                    nlocal = 0;
+                }
+                local[nlocal++] = v;
+            }
+        }
+    }
+
+    memcpy(&bfs->next_queue[atomic_fetch_add(&bfs->tail, nlocal)], local, nlocal * sizeof(int));
+    atomic_fetch_add(&bfs->scout, scout);
+    atomic_fetch_add(&bfs->count, found);
+}
+
+static void
+csr_bfs_bottom_up(csr_bfs_t *bfs, int id, int nthreads)
+{
+    const csr_graph_t *csr = bfs->csr;
+    const csr_graph_t *csr_r = bfs->csr_r;
+    size_t begin, end;
+    size_t scout = 0;
+    size_t found = 0;
+
+    parallel_range(bfs->nwords, id, nthreads, &begin, &end);
+
+    for (size_t w = begin; w < end; ++w) {
+        unsigned long long bits = 0;
+        int last = (w + 1) * 64 < (size_t)csr->size ? (int)((w + 1) * 64) : csr->size;
+
+        for (int v = (int)(w * 64); v < last; ++v) {
+            size_t i;
+            if (-1 != atomic_load_explicit(&bfs->parent[v], memory_order_relaxed)) {
+                continue;
+            }
+            csr_graph_foreach(csr_r, v, i) {
+                int u = csr_r->targets[i];
+                if (csr_bfs_bit(bfs->frontier, u)) {
+                    atomic_store_explicit(&bfs->parent[v], u, memory_order_relaxed);
+                    bfs->distance[v] = bfs->level + 1;
+                    bits |= 1ULL << (v & 63);
+                    scout += csr_graph_degree(csr, v);
+                    ++found;
+                    break;
+                }
+            }
+        }
+        atomic_store_explicit(&bfs->next_frontier[w], bits, memory_order_relaxed);
+    }
+
+    atomic_fetch_add(&bfs->scout, scout);
+    atomic_fetch_add(&bfs->count, found);
+}
+
+static void
+csr_bfs_queue_to_bitmap(csr_bfs_t *bfs, int id, int nthreads)
+{
+    size_t begin, end;
+
+    parallel_range(bfs->nwords, id, nthreads, &begin, &end);
+    for (size_t w = begin; w < end; ++w) {
+        atomic_store_explicit(&bfs->frontier[w], 0, memory_order_relaxed);
+    }
+
+    parallel_barrier_wait(&bfs->barrier, nthreads);
+
+    parallel_range(bfs->nqueue, id, nthreads, &begin, &end);
+    for (size_t k = begin; k < end; ++k) {
+        int v = bfs->queue[k];
+        atomic_fetch_or_explicit(&bfs->frontier[v >> 6], 1ULL << (v & 63), memory_order_relaxed);
+    }
+}
+
+static void
+csr_bfs_bitmap_to_queue(csr_bfs_t *bfs, int id, int nthreads)
+{
+    int *local = &bfs->local[(size_t)id * CSR_BFS_LOCAL];
+    size_t nlocal = 0;
+    size_t begin, end;
+
+    parallel_range(bfs->nwords, id, nthreads, &begin, &end);
+    for (size_t w = begin; w < end; ++w) {
+        unsigned long long bits = atomic_load_explicit(&bfs->frontier[w], memory_order_relaxed);
+        while (bits) {
+            if (CSR_BFS_LOCAL == nlocal) {
+                memcpy(&bfs->queue[atomic_fetch_add(&bfs->tail, nlocal)], local, nlocal * sizeof(int));
+                nlocal = 0;
+            }
+            local[nlocal++] = (int)(w * 64) + ffsll(bits) - 1;
+            bits &= bits - 1;
+        }
+    }
+    memcpy(&bfs->queue[atomic_fetch_add(&bfs->tail, nlocal)], local, nlocal * sizeof(int));
+}
+
+/**
+ * Serial work between two levels: publishes next frontier and picks
+ * direction of next step.
+ */
+static void
+csr_bfs_level_end(csr_bfs_t *bfs)
+{
+    size_t count = atomic_load(&bfs->count);
+    size_t scout = atomic_load(&bfs->scout);
+    size_t previous = bfs->nfrontier;
+
+    bfs->unexplored = scout < bfs->unexplored ? bfs->unexplored - scout : 0;
+    bfs->nfrontier = count;
+    bfs->convert = 0;
+    bfs->level++;
+
+    if (CSR_BFS_TOP_DOWN == bfs->mode) {
+        int *queue = bfs->queue;
+        bfs->queue = bfs->next_queue;
+        bfs->next_queue = queue;
+        bfs->nqueue = count;
+        if (scout > bfs->unexplored / CSR_BFS_ALPHA) {
+            bfs->mode = CSR_BFS_BOTTOM_UP;
+            bfs->convert = 1;
+        }
+    }
+    else {
+        atomic_ullong *frontier = bfs->frontier;
+        bfs->frontier = bfs->next_frontier;
+        bfs->next_frontier = frontier;
+        if (count < (size_t)bfs->csr->size / CSR_BFS_BETA && count < previous) {
+            bfs->mode = CSR_BFS_TOP_DOWN;
+            bfs->convert = 1;
+        }
+    }
+
+    atomic_store(&bfs->count, 0);
+    atomic_store(&bfs->scout, 0);
+    atomic_store(&bfs->next, 0);
+    atomic_store(&bfs->tail, 0);
+}
+
+static void
+csr_bfs_worker(void *arg, int id, int nthreads)
+{
+    csr_bfs_t *bfs = arg;
+    size_t begin, end;
+
+    parallel_range(bfs->csr->size, id, nthreads, &begin, &end);
+    for (size_t v = begin; v < end; ++v) {
+        atomic_init(&bfs->parent[v], -1);
+        bfs->distance[v] = -1;
+    }
+
+    if (parallel_barrier_wait(&bfs->barrier, nthreads)) {
+        atomic_store(&bfs->parent[bfs->source], bfs->source);
+        bfs->distance[bfs->source] = 0;
+        bfs->queue[0] = bfs->source;
+        bfs->nqueue = 1;
+        bfs->nfrontier = 1;
+    }
+    parallel_barrier_wait(&bfs->barrier, nthreads);
+
+    while (bfs->nfrontier > 0) {
+        if (CSR_BFS_TOP_DOWN == bfs->mode) {
+            csr_bfs_top_down(bfs, id);
+        }
+        else {
+            csr_bfs_bottom_up(bfs, id, nthreads);
+        }
+
+        if (parallel_barrier_wait(&bfs->barrier, nthreads)) {
+            csr_bfs_level_end(bfs);
+        }
+        parallel_barrier_wait(&bfs->barrier, nthreads);
+
+        if (bfs->convert && bfs->nfrontier > 0) {
+            if (CSR_BFS_BOTTOM_UP == bfs->mode) {
+                csr_bfs_queue_to_bitmap(bfs, id, nthreads);
+                parallel_barrier_wait(&bfs->barrier, nthreads);
+            }
+            else {
+                csr_bfs_bitmap_to_queue(bfs, id, nthreads);
+                if (parallel_barrier_wait(&bfs->barrier, nthreads)) {
+                    bfs->nqueue = atomic_load(&bfs->tail);
+                    atomic_store(&bfs->tail, 0);
+                }
+                parallel_barrier_wait(&bfs->barrier, nthreads);
+            }
+        }
+    }
+}
+
+int
+csr_graph_bfs(const csr_graph_t *csr, const csr_graph_t *csr_r, int s, int nthreads, int *distance, int *parent)
+{
+    csr_bfs_t bfs;
+    int rc = -1;
+
+    nthreads = parallel_threads(nthreads);
+
+    memset(&bfs, 0, sizeof(bfs));
+
+    bfs.csr = csr;
+    bfs.csr_r = csr_r;
+    bfs.source = s;
+    bfs.distance = distance;
+    bfs.nwords = (csr->size + 63) / 64;
+    bfs.mode = CSR_BFS_TOP_DOWN;
+    bfs.unexplored = csr->nedges;
+    bfs.parent = malloc((csr->size ? csr->size : 1) * sizeof(atomic_int));
+    bfs.queue = malloc((csr->size ? csr->size : 1) * sizeof(int));
+    bfs.next_queue = malloc((csr->size ? csr->size : 1) * sizeof(int));
+    bfs.frontier = malloc((bfs.nwords ? bfs.nwords : 1) * sizeof(atomic_ullong));
+    bfs.next_frontier = malloc((bfs.nwords ? bfs.nwords : 1) * sizeof(atomic_ullong));
+    bfs.local = malloc((size_t)nthreads * CSR_BFS_LOCAL * sizeof(int));
+    atomic_init(&bfs.next, 0);
+    atomic_init(&bfs.tail, 0);
+    atomic_init(&bfs.count, 0);
+    atomic_init(&bfs.scout, 0);
+    parallel_barrier_init(&bfs.barrier);
+
+    if (NULL == bfs.parent || NULL == bfs.queue || NULL == bfs.next_queue ||
+        NULL == bfs.frontier || NULL == bfs.next_frontier || NULL == bfs.local) {
+        goto out;
+    }
+
+    parallel_run(nthreads, csr_bfs_worker, &bfs);
+
+    if (NULL != parent) {
+        for (int v = 0; v < csr->size; ++v) {
+            parent[v] = v == s ? -1 : atomic_load_explicit(&bfs.parent[v], memory_order_relaxed);
+        }
+    }
+
+    rc = 0;
+
+out:
+    free(bfs.parent);
+    free(bfs.queue);
+    free(bfs.next_queue);
+    free(bfs.frontier);
+    free(bfs.next_frontier);
+    free(bfs.local);
+    return rc;
+}
+
+typedef struct csr_msbfs csr_msbfs_t;
+
+/**
+ * Multi-source BFS state shared by all threads.
+ *
+ * Bitsets hold nwords words per vertex, bit j of vertex v standing for
+ * search j of the batch: seen[v] for searches that reached v, visit[v]
+ * for those whose frontier holds v and next[v] for those v joins the
+ * frontier of at next level. Bits of searches beyond the batch are set
+ * in seen from the start, so a vertex reached by every search has all
+ * its seen bits set.
+ */
+struct csr_msbfs {
+    const csr_graph_t *csr;
+    const csr_graph_t *csr_r;
+    const int *sources;
+    size_t nsources;
+    size_t first;                /**< index of first source of batch */
+    size_t count;                /**< sources in batch */
+    int nwords;
+    unsigned long long *seen;
+    unsigned long long *visit;
+    unsigned long long *next;
+    int *distance;
+    long *sum;                   /**< CSR_MSBFS_WIDTH entries per thread */
+    int *reached;                /**< CSR_MSBFS_WIDTH entries per thread */
+    int level;                   /**< level of vertices joining next frontier */
+    bool more;                   /**< frontier isn't empty */
+    atomic_bool active;          /**< some vertex joined next frontier */
+    parallel_barrier_t barrier;
+};
+
+/**
+ * Records vertex v reached at current level by searches of bits of word
+ * k, in distance rows and in sums of thread id.
+ */
+static void
+csr_msbfs_record(csr_msbfs_t *msbfs, int id, int v, int k, unsigned long long bits)
+{
+    long *sum = &msbfs->sum[(size_t)id * CSR_MSBFS_WIDTH];
+    int *reached = &msbfs->reached[(size_t)id * CSR_MSBFS_WIDTH];
+
+    while (bits) {
+        int j = k * 64 + ffsll(bits) - 1;
+        if (NULL != msbfs->distance) {
+            msbfs->distance[(msbfs->first + j) * msbfs->csr->size + v] = msbfs->level;
+        }
+        sum[j] += msbfs->level;
+        reached[j]++;
+        bits &= bits - 1;
+    }
+}
+
+/**
+ * One level: every vertex not reached by all searches ORs frontier bits
+ * of its in-neighbors and keeps those of searches that didn't reach it.
+ */
+static void
+csr_msbfs_step(csr_msbfs_t *msbfs, int id, int nthreads)
+{
+    const csr_graph_t *csr_r = msbfs->csr_r;
+    int nwords = msbfs->nwords;
+    bool active = false;
+    size_t begin, end;
+
+    parallel_range(csr_r->size, id, nthreads, &begin, &end);
+
+    for (size_t v = begin; v < end; ++v) {
+        unsigned long long *seen = &msbfs->seen[v * nwords];
+        unsigned long long *next = &msbfs->next[v * nwords];
+        unsigned long long acc[CSR_MSBFS_WIDTH / 64];
+        unsigned long long unseen = 0;
+        size_t i;
+
+        for (int k = 0; k < nwords; ++k) {
+            unseen |= ~seen[k];
+            acc[k] = 0;
+        }
+        if (0 == unseen) {
+            for (int k = 0; k < nwords; ++k) {
+                next[k] = 0;
+            }
+            continue;
+        }
+
+        csr_graph_foreach(csr_r, v, i) {
+            const unsigned long long *visit = &msbfs->visit[(size_t)csr_r->targets[i] * nwords];
+            for (int k = 0; k < nwords; ++k) {
+                acc[k] |= visit[k];
+            }
+        }
+
+        for (int k = 0; k < nwords; ++k) {
+            next[k] = acc[k] & ~seen[k];
+            seen[k] |= next[k];
+            if (next[k]) {
+                csr_msbfs_record(msbfs, id, (int)v, k, next[k]);
+                active = true;
+            }
+        }
+    }
+
+    if (active) {
+        atomic_store_explicit(&msbfs->active, true, memory_order_relaxed);
+    }
+}
+
+/**
+ * Returns bits of word k standing for searches beyond the batch.
+ */
+static inline unsigned long long
+csr_msbfs_padding(size_t count, int k)
+{
+    if (count >= (size_t)(k + 1) * 64) {
+        return 0;
+    }
+    if (count <= (size_t)k * 64) {
+        return ~0ULL;
+    }
+    return ~0ULL << (count - (size_t)k * 64);
+}
+
+static void
+csr_msbfs_worker(void *arg, int id, int nthreads)
+{
+    csr_msbfs_t *msbfs = arg;
+    int nwords = msbfs->nwords;
+    unsigned long long padding[CSR_MSBFS_WIDTH / 64];
+    size_t begin, end;
+
+    for (int k = 0; k < nwords; ++k) {
+        padding[k] = csr_msbfs_padding(msbfs->count, k);
+    }
+    parallel_range(msbfs->csr->size, id, nthreads, &begin, &end);
+    for (size_t v = begin; v < end; ++v) {
+        for (int k = 0; k < nwords; ++k) {
+            msbfs->seen[v * nwords + k] = padding[k];
+            msbfs->visit[v * nwords + k] = 0;
+        }
+    }
+    if (NULL != msbfs->distance) {
+        parallel_range(msbfs->count * msbfs->csr->size, id, nthreads, &begin, &end);
+        for (size_t k = begin; k < end; ++k) {
+            msbfs->distance[msbfs->first * msbfs->csr->size + k] = -1;
+        }
+    }
+    for (int j = 0; j < CSR_MSBFS_WIDTH; ++j) {
+        msbfs->sum[(size_t)id * CSR_MSBFS_WIDTH + j] = 0;
+        msbfs->reached[(size_t)id * CSR_MSBFS_WIDTH + j] = 0;
+    }
+
+    if (parallel_barrier_wait(&msbfs->barrier, nthreads)) {
+        for (size_t j = 0; j < msbfs->count; ++j) {
+            size_t v = msbfs->sources[msbfs->first + j];
+            msbfs->seen[v * nwords + j / 64] |= 1ULL << (j % 64);
+            msbfs->visit[v * nwords + j / 64] |= 1ULL << (j % 64);
+            msbfs->reached[j]++;
+            if (NULL != msbfs->distance) {
+                msbfs->distance[(msbfs->first + j) * msbfs->csr->size + v] = 0;
+            }
+        }
+        msbfs->level = 1;
+        msbfs->more = msbfs->count > 0;
+    }
+    parallel_barrier_wait(&msbfs->barrier, nthreads);
+
+    while (msbfs->more) {
+        csr_msbfs_step(msbfs, id, nthreads);
+
+        if (parallel_barrier_wait(&msbfs->barrier, nthreads)) {
+            unsigned long long *visit = msbfs->visit;
+            msbfs->visit = msbfs->next;
+            msbfs->next = visit;
+            msbfs->more = atomic_exchange(&msbfs->active, false);
+            msbfs->level++;
+        }
+        parallel_barrier_wait(&msbfs->barrier, nthreads);
+    }
+}
+
+int
+csr_graph_msbfs(const csr_graph_t *csr, const csr_graph_t *csr_r, const int *sources, size_t nsources, int width, int nthreads, int *distance, long *sum, int *reached)
+{
+    csr_msbfs_t msbfs;
+    size_t nbits;
+    int rc = -1;
+
+    if (width <= 0) {
+        width = CSR_MSBFS_WIDTH;
+    }
+    if (width > CSR_MSBFS_WIDTH || 0 != width % 64) {
+        return -1;
+    }
+
+    nthreads = parallel_threads(nthreads);
+
+    memset(&msbfs, 0, sizeof(msbfs));
+
+    msbfs.csr = csr;
+    msbfs.csr_r = csr_r;
+    msbfs.sources = sources;
+    msbfs.nsources = nsources;
+    msbfs.distance = distance;
+    msbfs.nwords = width / 64;
+    nbits = (csr->size ? csr->size : 1) * (size_t)msbfs.nwords;
+    msbfs.seen = malloc(nbits * sizeof(unsigned long long));
+    msbfs.visit = malloc(nbits * sizeof(unsigned long long));
+    msbfs.next = malloc(nbits * sizeof(unsigned long long));
+    msbfs.sum = malloc((size_t)nthreads * CSR_MSBFS_WIDTH * sizeof(long));
+    msbfs.reached = malloc((size_t)nthreads * CSR_MSBFS_WIDTH * sizeof(int));
+    atomic_init(&msbfs.active, false);
+    parallel_barrier_init(&msbfs.barrier);
+
+    if (NULL == msbfs.seen || NULL == msbfs.visit || NULL == msbfs.next ||
+        NULL == msbfs.sum || NULL == msbfs.reached) {
+        goto out;
+    }
+
+    for (msbfs.first = 0; msbfs.first < nsources; msbfs.first += width) {
+        int ran;
+
+        msbfs.count = nsources - msbfs.first < (size_t)width ? nsources - msbfs.first : (size_t)width;
+        ran = parallel_run(nthreads, csr_msbfs_worker, &msbfs);
+
+        for (size_t j = 0; j < msbfs.count; ++j) {
+            long s = 0;
+            int r = 0;
+            for (int id = 0; id < ran; ++id) {
+                s += msbfs.sum[(size_t)id * CSR_MSBFS_WIDTH + j];
+                r += msbfs.reached[(size_t)id * CSR_MSBFS_WIDTH + j];
+            }
+            if (NULL != sum) {
+                sum[msbfs.first + j] = s;
+            }
+            if (NULL != reached) {
+                reached[msbfs.first + j] = r;
+            }
+        }
+    }
+
+    rc = 0;
+
+out:
+    free(msbfs.seen);
+    free(msbfs.visit);
+    free(msbfs.next);
+    free(msbfs.sum);
+    free(msbfs.reached);
+    return rc;
+}
+
+double
+csr_graph_mst_prim_cost(const csr_graph_t *csr)
+{
+    double cost = 0.0;
+    csr_heap_t *h = csr_heap_new(0);
+    long *key = malloc(csr->size * sizeof(long));
+    bool *visited = calloc(csr->size, sizeof(bool));
+    csr_heap_entry_t entry;
+
+    if (NULL == h || NULL == key || NULL == visited) {
+        goto error;
+    }
+
+    for (int u = 0; u < csr->size; ++u) {
+        key[u] = LONG_MAX;
+    }
+
+    for (int s = 0; s < csr->size; ++s) {
+
+        if (visited[s]) {
+            continue;
+        }
+
+        key[s] = 0;
+        entry.key = 0;
+        entry.vertex = s;
+        if (0 != csr_heap_insert(h, &entry)) {
+            goto error;
+        }
+
+        while (NULL != csr_heap_pop_front(h, &entry)) {
+            int u = entry.vertex;
+            size_t i;
+
+            if (visited[u] || entry.key > key[u]) {
+                continue;
+            }
+
+            visited[u] = true;
+            cost += key[u];
+
+            csr_graph_foreach(csr, u, i) {
+                int v = csr->targets[i];
+                if (!visited[v] && csr->weights[i] < key[v]) {
+                    key[v] = csr->weights[i];
+                    entry.key = key[v];
+                    entry.vertex = v;
+                    if (0 != csr_heap_insert(h, &entry)) {
+                        goto error;
+                    }
+                }
+            }
+        }
+    }
+
+out:
+    if (NULL != h) {
+        csr_heap_free(h);
+    }
+    free(key);
+    free(visited);
+    return cost;
+
+error:
+    cost = NAN;
+    goto out;
+}
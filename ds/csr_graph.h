@@ -0,0 +1,338 @@
+#ifndef __CSR_GRAPH__H__
+#define __CSR_GRAPH__H__
+
+#include "includes.h"
+#include "graph.h"
+
+/**
+ * Compressed sparse row (CSR) graph.
+ *
+ * Frozen counterpart of graph_t: once built, adjacency of every vertex
+ * is stored contiguously so that scanning neighbors of u is a linear
+ * walk over targets[offsets[u] .. offsets[u + 1]) (and the respective
+ * weights), instead of chasing list node -> edge -> vertex pointers.
+ *
+ * Undirected edges are stored once in each direction.
+ */
+
+typedef struct csr_edge csr_edge_t;
+
+struct csr_edge {
+    int source;
+    int target;
+    long weight;
+};
+
+typedef struct csr_graph csr_graph_t;
+
+struct csr_graph {
+    size_t *offsets; /**< size + 1 entries */
+    int *targets;    /**< nedges entries */
+    long *weights;   /**< nedges entries */
+    int size;        /**< number of vertices */
+    size_t nedges;   /**< number of stored (directed) arcs */
+};
+
+#define csr_graph_foreach(csr, u, i) \
+    for ((i) = (csr)->offsets[(u)]; (i) < (csr)->offsets[(u) + 1]; ++(i))
+
+static inline size_t
+csr_graph_degree(const csr_graph_t *csr, int u)
+{
+    return csr->offsets[u + 1] - csr->offsets[u];
+}
+
+/**
+ * Allocates CSR graph of size vertices and room for nedges arcs.
+ *
+ * Offsets are zeroed, targets and weights are left to be filled by caller.
+ */
+csr_graph_t *
+csr_graph_new(int size, size_t nedges);
+
+/**
+ * Builds CSR graph from an edge list.
+ *
+ * It's an O(V + E) time operation (counting sort on sources).
+ *
+ * @param size number of vertices
+ * @param edges edge list, endpoints in range [0, size)
+ * @param nedges number of edges in the list
+ * @param flags EDGE_F_DIRECTED to store edges only from source to target,
+ *        otherwise every edge is stored in both directions
+ * @return CSR graph or NULL in case of error (including invalid endpoints).
+ */
+csr_graph_t *
+csr_graph_build(int size, const csr_edge_t *edges, size_t nedges, edge_flags_t flags);
+
+/**
+ * Converts list based graph into CSR graph.
+ *
+ * Vertex i of the CSR graph is graph->vertices[i], so search contexts
+ * are interchangeable between both representations. Every edge found in
+ * the adjacency list of a vertex becomes one arc, so undirected edges
+ * (shared between both endpoints) become two arcs.
+ */
+csr_graph_t *
+csr_graph_from_graph(graph_t *graph);
+
+/**
+ * Returns new CSR graph with all arcs reversed.
+ */
+csr_graph_t *
+csr_graph_reverse(const csr_graph_t *csr);
+
+void
+csr_graph_free(csr_graph_t *csr);
+
+/**
+ * Binary CSR graph file.
+ *
+ * The file is a fixed header followed by offsets, targets and weights
+ * of the graph, then optionally the same three arrays of its reverse,
+ * every array starting at a CSR_FILE_ALIGN aligned position. Arrays are
+ * stored in native byte order and sizes, so the header records sizes of
+ * size_t, int and long and a file written on a different platform is
+ * rejected rather than converted.
+ *
+ * Opening the file maps it in memory: graph (and reverse) point directly
+ * into the mapping, nothing is read, parsed or allocated, and pages are
+ * loaded on demand by the first algorithm touching them.
+ */
+
+#define CSR_FILE_MAGIC   0x47435344 /**< "DSCG" */
+#define CSR_FILE_VERSION 1
+#define CSR_FILE_ALIGN   64
+
+typedef struct csr_graph_file csr_graph_file_t;
+
+struct csr_graph_file {
+    csr_graph_t graph;
+    csr_graph_t reverse;  /**< valid only if has_reverse */
+    bool has_reverse;
+    void *base;           /**< mapping */
+    size_t length;        /**< length of the mapping */
+};
+
+/**
+ * Writes CSR graph, and optionally its reverse, to file.
+ *
+ * @param csr_r csr_graph_reverse(csr) or NULL
+ * @return zero on success, -1 otherwise.
+ */
+int
+csr_graph_save(const csr_graph_t *csr, const csr_graph_t *csr_r, const char *filename);
+
+/**
+ * Writes list based graph to file, converting it with csr_graph_from_graph.
+ *
+ * @param reverse whether reverse adjacency is stored too (needed by
+ *        bottom-up BFS and bidirectional searches of directed graphs)
+ * @return zero on success, -1 otherwise.
+ */
+int
+csr_graph_save_graph(graph_t *graph, bool reverse, const char *filename);
+
+/**
+ * Maps file written by csr_graph_save read only.
+ *
+ * It's an O(1) time operation: only the header and the bounds of the
+ * offsets are checked, not every target. file->graph and file->reverse
+ * must not be modified nor passed to csr_graph_free.
+ *
+ * @param file object filled on success
+ * @return zero on success, -1 otherwise (including bad magic, version
+ *         or platform).
+ */
+int
+csr_graph_open(csr_graph_file_t *file, const char *filename);
+
+/**
+ * Unmaps file opened by csr_graph_open.
+ */
+void
+csr_graph_close(csr_graph_file_t *file);
+
+/**
+ * Parallel direction-optimizing breadth-first search from s.
+ *
+ * Levels are expanded top-down (frontier vertices scan their arcs) while
+ * the frontier is small, and bottom-up (unvisited vertices scan their
+ * reverse arcs for a frontier vertex) while it's large, which saves most
+ * arc scans on low diameter graphs.
+ *
+ * @param csr_r csr_graph_reverse(csr), or csr itself if undirected
+ * @param nthreads number of threads (<= 0 for number of processors)
+ * @param distance array of csr->size entries, number of arcs in a shortest
+ *        path from s, -1 if unreachable
+ * @param parent array of csr->size entries, -1 for s and unreachable
+ *        vertices (optional)
+ * @return zero on success, -1 on allocation failure.
+ */
+int
+csr_graph_bfs(const csr_graph_t *csr, const csr_graph_t *csr_r, int s, int nthreads, int *distance, int *parent);
+
+/**
+ * Maximum number of sources a multi-source BFS searches at once.
+ */
+#define CSR_MSBFS_WIDTH 512
+
+/**
+ * Multi-source bit-parallel breadth-first search (MS-BFS).
+ *
+ * Sources are searched by batches of width: every vertex holds one bit
+ * per search of the batch for searches that reached it, and for those
+ * whose frontier it belongs to. A level ORs frontier bits of in-neighbors
+ * of every vertex not yet reached by all searches, a whole word of
+ * searches at a time, so a vertex and its arcs are scanned once per level
+ * for all searches of the batch instead of once per search. Vertices are
+ * split among nthreads threads, each one writing bits of its own vertices
+ * only.
+ *
+ * @param csr_r csr_graph_reverse(csr), or csr itself if undirected
+ * @param width sources per batch: 64, 128, 256 or 512 (CSR_MSBFS_WIDTH),
+ *        <= 0 for CSR_MSBFS_WIDTH
+ * @param nthreads number of threads (<= 0 for number of processors)
+ * @param distance array of nsources * csr->size entries, row i being
+ *        number of arcs in a shortest path from sources[i] to every
+ *        vertex, -1 if unreachable (optional)
+ * @param sum array of nsources entries, sum of distances from sources[i]
+ *        to vertices reachable from it (optional)
+ * @param reached array of nsources entries, number of vertices reachable
+ *        from sources[i], sources[i] included (optional)
+ * @return zero on success, -1 on allocation failure or invalid width.
+ */
+int
+csr_graph_msbfs(const csr_graph_t *csr, const csr_graph_t *csr_r, const int *sources, size_t nsources, int width, int nthreads, int *distance, long *sum, int *reached);
+
+bool
+csr_graph_connected(const csr_graph_t *csr, graph_search_t *search, int u, int v);
+
+int
+csr_graph_connected_count(const csr_graph_t *csr);
+
+bool
+csr_graph_contains_cycle(const csr_graph_t *csr);
+
+/**
+ * Strongly connected components (Tarjan).
+ *
+ * Depth-first search is iterative, on explicit stacks, so graphs of any
+ * size are handled whatever the depth of the search. Components are
+ * numbered in topological order of the condensation: every arc u -> v
+ * has component[u] <= component[v].
+ *
+ * Components of a graph_t are those of csr_graph_from_graph(graph).
+ *
+ * @param component array of csr->size entries, component of every vertex
+ * @return number of components, -1 on allocation failure.
+ */
+int
+csr_graph_scc(const csr_graph_t *csr, int *component);
+
+/**
+ * Topological sort (Kahn).
+ *
+ * @param order array of csr->size entries, vertices such that every arc
+ *        goes from a vertex to a later one
+ * @return zero on success, -1 if csr contains a cycle or on allocation
+ *         failure.
+ */
+int
+csr_graph_topological_sort(const csr_graph_t *csr, int *order);
+
+/**
+ * Returns condensation of csr: DAG of its strongly connected components.
+ *
+ * There is one arc c -> d for every pair of distinct components linked
+ * by at least one arc of csr, weighing as the lightest of them. Arcs of
+ * c are in order of first appearance among arcs of vertices of c.
+ *
+ * @param component components computed by csr_graph_scc
+ * @param ncomponents number of components returned by csr_graph_scc
+ * @return condensation or NULL on allocation failure.
+ */
+csr_graph_t *
+csr_graph_condensation(const csr_graph_t *csr, const int *component, int ncomponents);
+
+/**
+ * Returns number of edges in a shortest path from s to t (BFS),
+ * or -1 if t is not reachable from s.
+ *
+ * Distances and parents of vertices reached are left in search, the
+ * queue is that of graph_search_queue, so queries don't allocate once
+ * search was used.
+ */
+int
+csr_graph_distance(const csr_graph_t *csr, graph_search_t *search, int s, int t);
+
+/**
+ * Returns weight of a shortest path from s to t (Dijkstra),
+ * or -1 if t is not reachable from s or on allocation failure.
+ *
+ * Distances and parents of vertices reached are left in search.
+ */
+long
+csr_graph_dijkstra_distance(const csr_graph_t *csr, graph_search_t *search, int s, int t);
+
+/**
+ * Bidirectional Dijkstra, csr_r must be csr_graph_reverse(csr).
+ *
+ * Returns -1 if t is not reachable from s or on allocation failure.
+ */
+long
+csr_graph_bidirectional_dijkstra_distance(const csr_graph_t *csr, const csr_graph_t *csr_r, graph_search_t *search, graph_search_t *search_r, int s, int t);
+
+bool
+csr_graph_is_bipartite(const csr_graph_t *csr);
+
+bool
+csr_graph_negative_cycle(const csr_graph_t *csr);
+
+/**
+ * Bellman-Ford single source shortest paths.
+ *
+ * Unreachable vertices get LONG_MAX distance, vertices reachable from
+ * a negative cycle get LONG_MIN.
+ *
+ * @param distance array of csr->size entries
+ * @param parent array of csr->size entries, -1 for no parent (optional)
+ * @return zero on success, -1 on allocation failure (vertices reachable
+ *         from a negative cycle might then be left unmarked).
+ */
+int
+csr_graph_shortest_paths(const csr_graph_t *csr, int s, long *distance, int *parent);
+
+/**
+ * Parallel delta-stepping single source shortest paths, weights of csr
+ * being non-negative.
+ *
+ * Vertices are processed in buckets of tentative distance of width delta,
+ * all vertices of a bucket being relaxed at once by nthreads threads:
+ * light arcs (weight <= delta) as long as they feed the bucket again,
+ * heavy arcs once per vertex, when its bucket is settled.
+ * Small delta approaches Dijkstra (little redundant work, many phases),
+ * large delta approaches Bellman-Ford (few phases, many relaxations).
+ *
+ * Results are the same as csr_graph_shortest_paths': unreachable vertices
+ * get LONG_MAX distance and -1 parent. Among several shortest paths, the
+ * parent of v is the lowest numbered vertex u with an arc u -> v of
+ * positive weight on one of them.
+ *
+ * @param delta bucket width, <= 0 for the average arc weight
+ * @param nthreads number of threads (<= 0 for number of processors)
+ * @param distance array of csr->size entries
+ * @param parent array of csr->size entries (optional)
+ * @return zero on success, -1 on allocation failure or negative weights.
+ */
+int
+csr_graph_delta_stepping(const csr_graph_t *csr, int s, long delta, int nthreads, long *distance, int *parent);
+
+/**
+ * Returns cost of a minimum spanning forest (Prim), csr being undirected,
+ * or NAN on allocation failure.
+ */
+double
+csr_graph_mst_prim_cost(const csr_graph_t *csr);
+
+#endif /* __CSR_GRAPH__H__ */
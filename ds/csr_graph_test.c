@@ -0,0 +1,965 @@
+#include "includes.h"
+#include "csr_graph.h"
+#include "disjoint_sets.h"
+#include "parallel.h"
+
+static double
+now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static csr_graph_t *
+random_graph(int size, size_t nedges, long max_weight, edge_flags_t flags)
+{
+    csr_edge_t *edges = malloc(nedges * sizeof(csr_edge_t));
+    csr_graph_t *csr = NULL;
+
+    for (size_t i = 0; i < nedges; ++i) {
+        edges[i].source = rand() % size;
+        edges[i].target = rand() % size;
+        edges[i].weight = rand() % (max_weight + 1);
+    }
+
+    csr = csr_graph_build(size, edges, nedges, flags);
+
+    free(edges);
+    return csr;
+}
+
+/**
+ * Checks every parent lies on a shortest path and parents lead back to s.
+ */
+static bool
+parents_valid(csr_graph_t *csr, int s, long *distance, int *parent)
+{
+    for (int v = 0; v < csr->size; ++v) {
+        bool tight = false;
+        size_t i;
+        int u = v;
+        int hops = 0;
+
+        if (v == s || LONG_MAX == distance[v]) {
+            if (-1 != parent[v]) {
+                return false;
+            }
+            continue;
+        }
+        if (-1 == parent[v]) {
+            return false;
+        }
+        csr_graph_foreach(csr, parent[v], i) {
+            if (csr->targets[i] == v && distance[parent[v]] + csr->weights[i] == distance[v]) {
+                tight = true;
+            }
+        }
+        if (!tight) {
+            return false;
+        }
+        while (u != s && hops++ < csr->size) {
+            u = parent[u];
+        }
+        if (u != s) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks parent of every vertex with a tight arc of positive weight into
+ * it is the lowest numbered source of such arcs.
+ */
+static bool
+parents_lowest(csr_graph_t *csr, long *distance, int *parent)
+{
+    int *lowest = malloc((csr->size ? csr->size : 1) * sizeof(int));
+    bool ok = true;
+
+    for (int v = 0; v < csr->size; ++v) {
+        lowest[v] = -1;
+    }
+    for (int u = csr->size - 1; u >= 0; --u) {
+        size_t i;
+        if (LONG_MAX == distance[u]) {
+            continue;
+        }
+        csr_graph_foreach(csr, u, i) {
+            if (csr->weights[i] > 0 && distance[u] + csr->weights[i] == distance[csr->targets[i]]) {
+                lowest[csr->targets[i]] = u;
+            }
+        }
+    }
+    for (int v = 0; ok && v < csr->size; ++v) {
+        ok = -1 == lowest[v] || lowest[v] == parent[v];
+    }
+
+    free(lowest);
+    return ok;
+}
+
+static void
+check(int size, size_t nedges, long max_weight)
+{
+    csr_graph_t *csr = random_graph(size, nedges, max_weight, EDGE_F_DIRECTED);
+    long *expected = malloc(size * sizeof(long));
+    long *distance = malloc(size * sizeof(long));
+    int *parent = malloc(size * sizeof(int));
+    long deltas[] = { 0, 1, 7, 1000 };
+    bool computed = 0 == csr_graph_shortest_paths(csr, 0, expected, NULL);
+
+    for (int nthreads = 1; nthreads <= 4; ++nthreads) {
+        for (int j = 0; j < countof(deltas); ++j) {
+            int rc = csr_graph_delta_stepping(csr, 0, deltas[j], nthreads, distance, parent);
+            bool ok = computed && 0 == rc &&
+                0 == memcmp(expected, distance, size * sizeof(long)) &&
+                parents_valid(csr, 0, distance, parent) && parents_lowest(csr, distance, parent);
+            printf("size %d edges %zu max weight %ld threads %d delta %ld: %s\n",
+                   size, nedges, max_weight, nthreads, deltas[j], ok ? "ok" : "FAILED");
+        }
+    }
+
+    free(expected);
+    free(distance);
+    free(parent);
+    csr_graph_free(csr);
+}
+
+/**
+ * Checks delta-stepping on small weights mixed with a few huge ones, so
+ * that distances span far more buckets than any thread keeps.
+ */
+static void
+check_skewed(int size, size_t nedges, size_t nheavy)
+{
+    csr_edge_t *edges = malloc(nedges * sizeof(csr_edge_t));
+    long *expected = malloc(size * sizeof(long));
+    long *distance = malloc(size * sizeof(long));
+    int *parent = malloc(size * sizeof(int));
+    long deltas[] = { 0, 1, 50 };
+    csr_graph_t *csr;
+    bool computed;
+
+    for (size_t i = 0; i < nedges; ++i) {
+        edges[i].source = rand() % size;
+        edges[i].target = rand() % size;
+        edges[i].weight = rand() % 101;
+    }
+    for (size_t i = 0; i < nheavy && i < nedges; ++i) {
+        edges[rand() % nedges].weight = 1000000000000L + rand() % 1000000;
+        edges[rand() % nedges].weight = 100000 + rand() % 100000;
+    }
+    csr = csr_graph_build(size, edges, nedges, EDGE_F_DIRECTED);
+    computed = 0 == csr_graph_shortest_paths(csr, 0, expected, NULL);
+
+    for (int nthreads = 1; nthreads <= 4; nthreads *= 2) {
+        for (int j = 0; j < countof(deltas); ++j) {
+            int rc = csr_graph_delta_stepping(csr, 0, deltas[j], nthreads, distance, parent);
+            bool ok = computed && 0 == rc &&
+                0 == memcmp(expected, distance, size * sizeof(long)) &&
+                parents_valid(csr, 0, distance, parent) && parents_lowest(csr, distance, parent);
+            printf("skewed size %d edges %zu heavy %zu threads %d delta %ld: %s\n",
+                   size, nedges, nheavy, nthreads, deltas[j], ok ? "ok" : "FAILED");
+        }
+    }
+
+    free(edges);
+    free(expected);
+    free(distance);
+    free(parent);
+    csr_graph_free(csr);
+}
+
+static void
+bench(int size, size_t nedges, long delta)
+{
+    csr_graph_t *csr = random_graph(size, nedges, 255, EDGE_F_DIRECTED);
+    long *distance = malloc(size * sizeof(long));
+    int *parent = malloc(size * sizeof(int));
+    int max_threads = parallel_threads(0);
+    double base = 0.0;
+
+    for (int nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+        double start = now();
+        double elapsed;
+
+        csr_graph_delta_stepping(csr, 0, delta, nthreads, distance, parent);
+        elapsed = now() - start;
+        if (1 == nthreads) {
+            base = elapsed;
+        }
+        printf("delta-stepping %d vertices %zu arcs: %d threads %.3fs speedup %.2f\n",
+               size, nedges, nthreads, elapsed, base / elapsed);
+
+        if (nthreads < max_threads && 2 * nthreads > max_threads) {
+            nthreads = max_threads / 2;
+        }
+    }
+
+    free(distance);
+    free(parent);
+    csr_graph_free(csr);
+}
+
+static void
+check_bfs(int size, size_t nedges, edge_flags_t flags)
+{
+    csr_graph_t *csr = random_graph(size, nedges, 1, flags);
+    csr_graph_t *csr_r = NULL;
+    long *expected = malloc(size * sizeof(long));
+    long *distance = malloc(size * sizeof(long));
+    int *hops = malloc(size * sizeof(int));
+    int *parent = malloc(size * sizeof(int));
+    bool computed;
+
+    for (size_t i = 0; i < csr->nedges; ++i) {
+        csr->weights[i] = 1;
+    }
+    csr_r = EDGE_F_DIRECTED == flags ? csr_graph_reverse(csr) : csr;
+
+    computed = 0 == csr_graph_shortest_paths(csr, 0, expected, NULL);
+
+    for (int nthreads = 1; nthreads <= 4; ++nthreads) {
+        bool ok = computed && 0 == csr_graph_bfs(csr, csr_r, 0, nthreads, hops, parent);
+        for (int v = 0; v < size; ++v) {
+            distance[v] = -1 == hops[v] ? LONG_MAX : hops[v];
+        }
+        ok = ok && 0 == memcmp(expected, distance, size * sizeof(long)) &&
+            parents_valid(csr, 0, distance, parent);
+        printf("bfs size %d edges %zu %s threads %d: %s\n", size, nedges,
+               EDGE_F_DIRECTED == flags ? "directed" : "undirected", nthreads, ok ? "ok" : "FAILED");
+    }
+
+    if (csr_r != csr) {
+        csr_graph_free(csr_r);
+    }
+    free(expected);
+    free(distance);
+    free(hops);
+    free(parent);
+    csr_graph_free(csr);
+}
+
+static void
+bench_bfs(int size, size_t nedges)
+{
+    csr_graph_t *csr = random_graph(size, nedges, 1, 0);
+    graph_search_t *search = graph_search_new(size);
+    int *distance = malloc(size * sizeof(int));
+    int *parent = malloc(size * sizeof(int));
+    int max_threads = parallel_threads(0);
+    int farthest = 0;
+    double start;
+    double base;
+
+    csr_graph_bfs(csr, csr, 0, 1, distance, parent);
+    for (int v = 0; v < size; ++v) {
+        if (distance[v] > distance[farthest]) {
+            farthest = v;
+        }
+    }
+
+    start = now();
+    csr_graph_distance(csr, search, 0, farthest);
+    base = now() - start;
+    printf("serial bfs %d vertices %zu arcs: %.3fs\n", size, csr->nedges, base);
+
+    for (int nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+        double elapsed;
+
+        start = now();
+        csr_graph_bfs(csr, csr, 0, nthreads, distance, parent);
+        elapsed = now() - start;
+        printf("direction-optimizing bfs %d vertices %zu arcs: %d threads %.3fs speedup %.2f\n",
+               size, csr->nedges, nthreads, elapsed, base / elapsed);
+
+        if (nthreads < max_threads && 2 * nthreads > max_threads) {
+            nthreads = max_threads / 2;
+        }
+    }
+
+    free(distance);
+    free(parent);
+    graph_search_free(search);
+    csr_graph_free(csr);
+}
+
+/**
+ * Checks multi-source BFS distance rows and sums against one BFS per
+ * source, for several batch widths and numbers of threads.
+ */
+static void
+check_msbfs(int size, size_t nedges, size_t nsources, edge_flags_t flags)
+{
+    csr_graph_t *csr = random_graph(size, nedges, 1, flags);
+    csr_graph_t *csr_r = EDGE_F_DIRECTED == flags ? csr_graph_reverse(csr) : csr;
+    int *sources = malloc((nsources ? nsources : 1) * sizeof(int));
+    size_t ncells = nsources * size;
+    int *expected = malloc((ncells ? ncells : 1) * sizeof(int));
+    int *distance = malloc((ncells ? ncells : 1) * sizeof(int));
+    long *expected_sum = calloc(nsources ? nsources : 1, sizeof(long));
+    int *expected_reached = calloc(nsources ? nsources : 1, sizeof(int));
+    long *sum = malloc((nsources ? nsources : 1) * sizeof(long));
+    int *reached = malloc((nsources ? nsources : 1) * sizeof(int));
+    int widths[] = { 64, 256, 512 };
+
+    for (size_t j = 0; j < nsources; ++j) {
+        int *row = &expected[j * size];
+        sources[j] = rand() % size;
+        csr_graph_bfs(csr, csr_r, sources[j], 1, row, NULL);
+        for (int v = 0; v < size; ++v) {
+            if (-1 != row[v]) {
+                expected_sum[j] += row[v];
+                expected_reached[j]++;
+            }
+        }
+    }
+
+    for (size_t w = 0; w < countof(widths); ++w) {
+        for (int nthreads = 1; nthreads <= 4; nthreads += 3) {
+            bool ok = 0 == csr_graph_msbfs(csr, csr_r, sources, nsources, widths[w], nthreads, distance, sum, reached) &&
+                0 == memcmp(expected, distance, ncells * sizeof(int)) &&
+                0 == memcmp(expected_sum, sum, nsources * sizeof(long)) &&
+                0 == memcmp(expected_reached, reached, nsources * sizeof(int));
+            printf("msbfs size %d edges %zu %s sources %zu width %d threads %d: %s\n", size, nedges,
+                   EDGE_F_DIRECTED == flags ? "directed" : "undirected", nsources, widths[w], nthreads,
+                   ok ? "ok" : "FAILED");
+        }
+    }
+
+    if (csr_r != csr) {
+        csr_graph_free(csr_r);
+    }
+    free(sources);
+    free(expected);
+    free(distance);
+    free(expected_sum);
+    free(expected_reached);
+    free(sum);
+    free(reached);
+    csr_graph_free(csr);
+}
+
+/**
+ * Sums of distances from nsources sources, one BFS per source against
+ * batches of multi-source BFS.
+ */
+static void
+bench_msbfs(int size, size_t nedges, size_t nsources)
+{
+    csr_graph_t *csr = random_graph(size, nedges, 1, 0);
+    int *sources = malloc(nsources * sizeof(int));
+    int *distance = malloc(size * sizeof(int));
+    long *sum = malloc(nsources * sizeof(long));
+    int max_threads = parallel_threads(0);
+    double start;
+    double base;
+
+    for (size_t j = 0; j < nsources; ++j) {
+        sources[j] = rand() % size;
+    }
+
+    start = now();
+    for (size_t j = 0; j < nsources; ++j) {
+        csr_graph_bfs(csr, csr, sources[j], 1, distance, NULL);
+    }
+    base = now() - start;
+    printf("%zu bfs %d vertices %zu arcs: %.3fs\n", nsources, size, csr->nedges, base);
+
+    for (int width = 64; width <= CSR_MSBFS_WIDTH; width *= 2) {
+        for (int nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+            double elapsed;
+
+            start = now();
+            csr_graph_msbfs(csr, csr, sources, nsources, width, nthreads, NULL, sum, NULL);
+            elapsed = now() - start;
+            printf("msbfs %d vertices %zu arcs %zu sources: width %d threads %d %.3fs speedup %.2f\n",
+                   size, csr->nedges, nsources, width, nthreads, elapsed, base / elapsed);
+
+            if (nthreads < max_threads && 2 * nthreads > max_threads) {
+                nthreads = max_threads / 2;
+            }
+        }
+    }
+
+    free(sources);
+    free(distance);
+    free(sum);
+    csr_graph_free(csr);
+}
+
+static bool
+csr_graph_equal(const csr_graph_t *a, const csr_graph_t *b)
+{
+    return a->size == b->size && a->nedges == b->nedges &&
+        0 == memcmp(a->offsets, b->offsets, (a->size + 1) * sizeof(size_t)) &&
+        0 == memcmp(a->targets, b->targets, a->nedges * sizeof(int)) &&
+        0 == memcmp(a->weights, b->weights, a->nedges * sizeof(long));
+}
+
+/**
+ * Saves graphs, maps them back and runs searches on mapped arrays.
+ */
+static void
+check_file(int size, size_t nedges)
+{
+    char filename[] = "/tmp/csr_graph_test.XXXXXX";
+    csr_graph_t *csr = random_graph(size, nedges, 100, EDGE_F_DIRECTED);
+    csr_graph_t *csr_r = csr_graph_reverse(csr);
+    graph_t *graph = graph_new(size);
+    graph_search_t *search = graph_search_new(size);
+    graph_search_t *search_r = graph_search_new(size);
+    csr_graph_file_t file;
+    int fd = mkstemp(filename);
+    bool ok;
+
+    close(fd);
+
+    ok = 0 == csr_graph_save(csr, csr_r, filename) &&
+        0 == csr_graph_open(&file, filename) &&
+        file.has_reverse && csr_graph_equal(csr, &file.graph) && csr_graph_equal(csr_r, &file.reverse);
+    for (int t = 0; ok && t < size; t += 1 + size / 10) {
+        ok = csr_graph_dijkstra_distance(csr, search, 0, t) ==
+            csr_graph_bidirectional_dijkstra_distance(&file.graph, &file.reverse, search, search_r, 0, t);
+    }
+    csr_graph_close(&file);
+
+    /**
+     * graph_t holding csr arcs converts back to the same CSR graph.
+     */
+    for (int u = 0; u < size; ++u) {
+        size_t i;
+        csr_graph_foreach(csr, u, i) {
+            edge_t *edge = edge_new(&graph->vertices[u], &graph->vertices[csr->targets[i]], EDGE_F_DIRECTED);
+            edge->weight = csr->weights[i];
+            vertex_edge_add(&graph->vertices[u], edge);
+        }
+    }
+    ok = ok && 0 == csr_graph_save_graph(graph, false, filename) &&
+        0 == csr_graph_open(&file, filename) &&
+        !file.has_reverse && csr_graph_equal(csr, &file.graph);
+    csr_graph_close(&file);
+
+    /**
+     * Truncated file is rejected.
+     */
+    ok = ok && 0 == truncate(filename, 100) && -1 == csr_graph_open(&file, filename) && NULL == file.base;
+
+    printf("file size %d edges %zu: %s\n", size, nedges, ok ? "ok" : "FAILED");
+
+    unlink(filename);
+    graph_search_free(search);
+    graph_search_free(search_r);
+    csr_graph_free(csr_r);
+    csr_graph_free(csr);
+}
+
+/**
+ * Checks Dijkstra variants against Bellman-Ford on random queries.
+ */
+static void
+check_dijkstra(int size, size_t nedges, edge_flags_t flags, int nsources)
+{
+    csr_graph_t *csr = random_graph(size, nedges, 100, flags);
+    csr_graph_t *csr_r = csr_graph_reverse(csr);
+    graph_search_t *search = graph_search_new(size);
+    graph_search_t *search_r = graph_search_new(size);
+    long *distance = malloc(size * sizeof(long));
+    bool ok = NULL != csr_r;
+
+    for (int k = 0; ok && k < nsources; ++k) {
+        int s = rand() % size;
+
+        ok = 0 == csr_graph_shortest_paths(csr, s, distance, NULL);
+        for (int q = 0; ok && q < 20; ++q) {
+            int t = rand() % size;
+            long expected = LONG_MAX == distance[t] ? -1 : distance[t];
+
+            ok = expected == csr_graph_dijkstra_distance(csr, search, s, t) &&
+                expected == csr_graph_bidirectional_dijkstra_distance(csr, csr_r, search, search_r, s, t);
+        }
+    }
+
+    printf("dijkstra size %d edges %zu %s: %s\n", size, nedges,
+           flags & EDGE_F_DIRECTED ? "directed" : "undirected", ok ? "ok" : "FAILED");
+
+    free(distance);
+    graph_search_free(search);
+    graph_search_free(search_r);
+    if (NULL != csr_r) {
+        csr_graph_free(csr_r);
+    }
+    csr_graph_free(csr);
+}
+
+/**
+ * Compares building graph_t from an edge list against mapping the file.
+ */
+static void
+bench_file(int size, size_t nedges)
+{
+    char filename[] = "/tmp/csr_graph_test.XXXXXX";
+    csr_edge_t *edges = malloc(nedges * sizeof(csr_edge_t));
+    graph_t *graph = graph_new(size);
+    int *distance = malloc(size * sizeof(int));
+    csr_graph_file_t file;
+    int fd = mkstemp(filename);
+    double start;
+    double elapsed;
+
+    close(fd);
+
+    for (size_t i = 0; i < nedges; ++i) {
+        edges[i].source = rand() % size;
+        edges[i].target = rand() % size;
+        edges[i].weight = rand() % 256;
+    }
+
+    start = now();
+    for (size_t i = 0; i < nedges; ++i) {
+        vertex_t *u = &graph->vertices[edges[i].source];
+        edge_t *edge = edge_new(u, &graph->vertices[edges[i].target], EDGE_F_DIRECTED);
+        edge->weight = edges[i].weight;
+        vertex_edge_add(u, edge);
+    }
+    printf("graph_t %d vertices %zu edges: build %.3fs\n", size, nedges, now() - start);
+
+    start = now();
+    csr_graph_save_graph(graph, true, filename);
+    printf("graph_t %d vertices %zu edges: save %.3fs\n", size, nedges, now() - start);
+
+    start = now();
+    csr_graph_open(&file, filename);
+    elapsed = now() - start;
+    csr_graph_bfs(&file.graph, &file.reverse, 0, 1, distance, NULL);
+    printf("mapped %d vertices %zu arcs: open %.6fs, open + first bfs %.3fs\n",
+           size, file.graph.nedges, elapsed, now() - start);
+    csr_graph_close(&file);
+
+    unlink(filename);
+    free(distance);
+    free(edges);
+}
+
+/**
+ * Converts a list based graph of directed and undirected edges, checking
+ * arcs against the same edges given to csr_graph_build and searches
+ * against those of graph_t.
+ */
+static void
+check_from_graph(int size, size_t nedges)
+{
+    graph_t *graph = graph_new(size);
+    csr_edge_t *arcs = malloc((2 * nedges + 1) * sizeof(csr_edge_t));
+    graph_search_t *search = graph_search_new(size);
+    csr_graph_t *expected;
+    csr_graph_t *csr;
+    size_t narcs = 0;
+    bool ok;
+
+    for (size_t k = 0; k < nedges; ++k) {
+        int u = rand() % size;
+        int v = rand() % size;
+        bool directed = rand() % 2;
+        edge_t *edge = edge_new(&graph->vertices[u], &graph->vertices[v], directed ? EDGE_F_DIRECTED : 0);
+
+        edge->weight = rand() % 100;
+        vertex_edge_add(&graph->vertices[u], edge);
+        arcs[narcs].source = u;
+        arcs[narcs].target = v;
+        arcs[narcs++].weight = edge->weight;
+        if (!directed && u != v) {
+            vertex_edge_add(&graph->vertices[v], edge);
+            arcs[narcs].source = v;
+            arcs[narcs].target = u;
+            arcs[narcs++].weight = edge->weight;
+        }
+    }
+
+    csr = csr_graph_from_graph(graph);
+    expected = csr_graph_build(size, arcs, narcs, EDGE_F_DIRECTED);
+    ok = NULL != csr && NULL != expected && csr_graph_equal(expected, csr);
+    for (int k = 0; ok && k < 100; ++k) {
+        int s = rand() % size;
+        int t = rand() % size;
+        ok = graph_distance(graph, search, &graph->vertices[s], &graph->vertices[t]) ==
+            csr_graph_distance(csr, search, s, t) &&
+            graph_dijkstra_distance(graph, search, &graph->vertices[s], &graph->vertices[t]) ==
+            csr_graph_dijkstra_distance(csr, search, s, t);
+    }
+
+    printf("from graph size %d edges %zu: %s\n", size, nedges, ok ? "ok" : "FAILED");
+
+    if (NULL != expected) {
+        csr_graph_free(expected);
+    }
+    if (NULL != csr) {
+        csr_graph_free(csr);
+    }
+    graph_search_free(search);
+    graph_free(graph);
+    free(arcs);
+}
+
+static int
+csr_edge_weight_cmp(const void *o1, const void *o2)
+{
+    const csr_edge_t *e1 = o1;
+    const csr_edge_t *e2 = o2;
+
+    return (e1->weight > e2->weight) - (e1->weight < e2->weight);
+}
+
+/**
+ * Checks Prim minimum spanning forest against Kruskal.
+ */
+static void
+check_mst(int size, size_t nedges)
+{
+    csr_edge_t *edges = malloc((nedges ? nedges : 1) * sizeof(csr_edge_t));
+    disjoint_sets_t *ds = disjoint_sets_new(size);
+    csr_graph_t *csr;
+    double expected = 0.0;
+
+    for (size_t k = 0; k < nedges; ++k) {
+        edges[k].source = rand() % size;
+        edges[k].target = rand() % size;
+        edges[k].weight = rand() % 100;
+    }
+    csr = csr_graph_build(size, edges, nedges, EDGE_F_NONE);
+
+    qsort(edges, nedges, sizeof(csr_edge_t), csr_edge_weight_cmp);
+    for (size_t k = 0; k < nedges; ++k) {
+        if (disjoint_sets_union(ds, edges[k].source, edges[k].target)) {
+            expected += edges[k].weight;
+        }
+    }
+
+    printf("prim size %d edges %zu: %s\n", size, nedges,
+           NULL != csr && expected == csr_graph_mst_prim_cost(csr) ? "ok" : "FAILED");
+
+    if (NULL != csr) {
+        csr_graph_free(csr);
+    }
+    disjoint_sets_free(ds);
+    free(edges);
+}
+
+/**
+ * Random arcs u -> v, u < v, plus a path through all vertices: acyclic
+ * whatever the weights, until an arc back to vertex 0 closes cycles, the
+ * lightest one weighing cycle_weight.
+ */
+static csr_graph_t *
+dag_graph(int size, size_t nedges, bool cycle, long cycle_weight)
+{
+    csr_edge_t *edges = malloc((nedges + size) * sizeof(csr_edge_t));
+    long *distance = malloc(size * sizeof(long));
+    csr_graph_t *csr;
+    size_t n = 0;
+
+    for (int v = 1; v < size; ++v) {
+        edges[n].source = v - 1;
+        edges[n].target = v;
+        edges[n++].weight = rand() % 100 - 50;
+    }
+    for (size_t k = 0; k < nedges; ++k) {
+        int u = rand() % size;
+        int v = rand() % size;
+        if (u == v) {
+            continue;
+        }
+        edges[n].source = u < v ? u : v;
+        edges[n].target = u < v ? v : u;
+        edges[n++].weight = rand() % 100 - 50;
+    }
+    csr = csr_graph_build(size, edges, n, EDGE_F_DIRECTED);
+
+    if (cycle) {
+        /**
+         * Vertices in increasing order are a topological order.
+         */
+        distance[0] = 0;
+        for (int v = 1; v < size; ++v) {
+            distance[v] = LONG_MAX;
+        }
+        for (int u = 0; u < size; ++u) {
+            size_t i;
+            csr_graph_foreach(csr, u, i) {
+                if (distance[u] + csr->weights[i] < distance[csr->targets[i]]) {
+                    distance[csr->targets[i]] = distance[u] + csr->weights[i];
+                }
+            }
+        }
+        edges[n].source = size - 1;
+        edges[n].target = 0;
+        edges[n++].weight = cycle_weight - distance[size - 1];
+        csr_graph_free(csr);
+        csr = csr_graph_build(size, edges, n, EDGE_F_DIRECTED);
+    }
+
+    free(distance);
+    free(edges);
+    return csr;
+}
+
+/**
+ * Checks cycle detection and Bellman-Ford on acyclic graphs and graphs
+ * with one cycle through every vertex, of positive or negative weight.
+ */
+static void
+check_cycles(int size, size_t nedges)
+{
+    csr_graph_t *dag = dag_graph(size, nedges, false, 0);
+    csr_graph_t *positive = dag_graph(size, nedges, true, 1);
+    csr_graph_t *negative = dag_graph(size, nedges, true, -1);
+    long *distance = malloc(size * sizeof(long));
+    bool ok;
+
+    ok = !csr_graph_contains_cycle(dag) && !csr_graph_negative_cycle(dag) &&
+        csr_graph_contains_cycle(positive) && !csr_graph_negative_cycle(positive) &&
+        csr_graph_contains_cycle(negative) && csr_graph_negative_cycle(negative);
+
+    ok = ok && 0 == csr_graph_shortest_paths(positive, size / 2, distance, NULL);
+    for (int v = 0; ok && v < size; ++v) {
+        ok = LONG_MIN < distance[v] && LONG_MAX > distance[v];
+    }
+    ok = ok && 0 == csr_graph_shortest_paths(negative, size / 2, distance, NULL);
+    for (int v = 0; ok && v < size; ++v) {
+        ok = LONG_MIN == distance[v];
+    }
+
+    printf("cycles size %d edges %zu: %s\n", size, nedges, ok ? "ok" : "FAILED");
+
+    free(distance);
+    csr_graph_free(dag);
+    csr_graph_free(positive);
+    csr_graph_free(negative);
+}
+
+/**
+ * Checks components against mutual reachability (BFS from every vertex)
+ * and the condensation against arcs of csr.
+ */
+static void
+check_scc(int size, size_t nedges)
+{
+    csr_graph_t *csr = random_graph(size, nedges, 100, EDGE_F_DIRECTED);
+    csr_graph_t *csr_r = csr_graph_reverse(csr);
+    int *distance = malloc(size * sizeof(int));
+    bool *reach = calloc((size_t)size * size, sizeof(bool));
+    int *component = malloc(size * sizeof(int));
+    int *order = malloc(size * sizeof(int));
+    int *position = NULL;
+    int ncomponents = csr_graph_scc(csr, component);
+    csr_graph_t *dag = csr_graph_condensation(csr, component, ncomponents);
+    bool ok = ncomponents > 0 && NULL != dag;
+    size_t i;
+
+    for (int s = 0; s < size; ++s) {
+        csr_graph_bfs(csr, csr_r, s, 1, distance, NULL);
+        for (int t = 0; t < size; ++t) {
+            reach[(size_t)s * size + t] = -1 != distance[t];
+        }
+    }
+    for (int u = 0; ok && u < size; ++u) {
+        for (int v = 0; ok && v < size; ++v) {
+            bool mutual = reach[(size_t)u * size + v] && reach[(size_t)v * size + u];
+            ok = mutual == (component[u] == component[v]);
+        }
+        csr_graph_foreach(csr, u, i) {
+            ok = ok && component[u] <= component[csr->targets[i]];
+        }
+    }
+
+    /**
+     * Every arc of the condensation is the lightest between its
+     * components, and every arc between components has one.
+     */
+    for (int c = 0; ok && c < ncomponents; ++c) {
+        csr_graph_foreach(dag, c, i) {
+            long lightest = LONG_MAX;
+            int d = dag->targets[i];
+            size_t j;
+
+            for (j = dag->offsets[c]; j < i; ++j) {
+                ok = ok && dag->targets[j] != d;
+            }
+            for (int u = 0; u < size; ++u) {
+                size_t k;
+                csr_graph_foreach(csr, u, k) {
+                    if (component[u] == c && component[csr->targets[k]] == d && csr->weights[k] < lightest) {
+                        lightest = csr->weights[k];
+                    }
+                }
+            }
+            ok = ok && c != d && lightest == dag->weights[i];
+        }
+    }
+    for (int u = 0; ok && u < size; ++u) {
+        csr_graph_foreach(csr, u, i) {
+            int c = component[u];
+            int d = component[csr->targets[i]];
+            size_t j;
+            bool found = c == d;
+
+            csr_graph_foreach(dag, c, j) {
+                found = found || dag->targets[j] == d;
+            }
+            ok = found;
+        }
+    }
+
+    ok = ok && (ncomponents == size || -1 == csr_graph_topological_sort(csr, order));
+    ok = ok && 0 == csr_graph_topological_sort(dag, order);
+    if (ok) {
+        position = malloc(ncomponents * sizeof(int));
+        for (int k = 0; k < ncomponents; ++k) {
+            position[order[k]] = k;
+        }
+        for (int c = 0; c < ncomponents; ++c) {
+            csr_graph_foreach(dag, c, i) {
+                ok = ok && position[c] < position[dag->targets[i]];
+            }
+        }
+    }
+
+    printf("scc size %d edges %zu: %d components: %s\n", size, nedges, ncomponents, ok ? "ok" : "FAILED");
+
+    free(position);
+    free(reach);
+    free(component);
+    free(order);
+    free(distance);
+    csr_graph_free(dag);
+    csr_graph_free(csr_r);
+    csr_graph_free(csr);
+}
+
+/**
+ * Long paths, far deeper than a recursive search could go.
+ */
+static void
+check_deep(int size)
+{
+    csr_edge_t *edges = malloc(size * sizeof(csr_edge_t));
+    graph_t *graph = graph_new(size);
+    graph_search_t *search = graph_search_new(size);
+    int *component = malloc(size * sizeof(int));
+    int *order = malloc(size * sizeof(int));
+    csr_graph_t *csr;
+    bool ok;
+
+    for (int u = 0; u + 1 < size; ++u) {
+        edge_t *edge = edge_new(&graph->vertices[u], &graph->vertices[u + 1], EDGE_F_DIRECTED);
+        vertex_edge_add(&graph->vertices[u], edge);
+        edges[u].source = u;
+        edges[u].target = u + 1;
+        edges[u].weight = 1;
+    }
+
+    csr = csr_graph_build(size, edges, size - 1, EDGE_F_DIRECTED);
+    ok = !graph_contains_cycle(graph, search) && size == csr_graph_scc(csr, component) &&
+        0 == csr_graph_topological_sort(csr, order);
+    for (int u = 0; ok && u < size; ++u) {
+        ok = u == component[u] && u == order[u];
+    }
+    csr_graph_free(csr);
+
+    /**
+     * Closing the path makes a single component.
+     */
+    edges[size - 1].source = size - 1;
+    edges[size - 1].target = 0;
+    edges[size - 1].weight = 1;
+    vertex_edge_add(&graph->vertices[size - 1], edge_new(&graph->vertices[size - 1], &graph->vertices[0], EDGE_F_DIRECTED));
+    csr = csr_graph_build(size, edges, size, EDGE_F_DIRECTED);
+    ok = ok && graph_contains_cycle(graph, search) && 1 == csr_graph_scc(csr, component) &&
+        -1 == csr_graph_topological_sort(csr, order);
+
+    printf("scc path of %d vertices: %s\n", size, ok ? "ok" : "FAILED");
+
+    csr_graph_free(csr);
+    graph_search_free(search);
+    graph_free(graph);
+    free(edges);
+    free(component);
+    free(order);
+}
+
+static void
+bench_scc(int size, size_t nedges)
+{
+    csr_graph_t *csr = random_graph(size, nedges, 1, EDGE_F_DIRECTED);
+    int *component = malloc(size * sizeof(int));
+    double start = now();
+    int ncomponents = csr_graph_scc(csr, component);
+    double elapsed = now() - start;
+    csr_graph_t *dag;
+
+    start = now();
+    dag = csr_graph_condensation(csr, component, ncomponents);
+    printf("scc %d vertices %zu arcs: %d components %.3fs, condensation %zu arcs %.3fs\n",
+           size, csr->nedges, ncomponents, elapsed, dag->nedges, now() - start);
+
+    csr_graph_free(dag);
+    free(component);
+    csr_graph_free(csr);
+}
+
+int main(int argc, char **argv)
+{
+    int size = argc > 1 ? atoi(argv[1]) : 1 << 20;
+    long delta = argc > 2 ? atol(argv[2]) : 0;
+
+    srand(1);
+
+    check(100, 400, 10);
+    check(1000, 3000, 0);
+    check(2000, 10000, 100);
+    check_skewed(2000, 4000, 20);
+    check_skewed(500, 600, 100);
+
+    check_bfs(1000, 3000, EDGE_F_DIRECTED);
+    check_bfs(5000, 40000, 0);
+    check_bfs(3000, 2000, 0);
+
+    check_msbfs(1000, 3000, 300, EDGE_F_DIRECTED);
+    check_msbfs(2000, 8000, 600, 0);
+    check_msbfs(1, 0, 3, 0);
+    check_msbfs(100, 50, 0, 0);
+
+    check_file(1000, 5000);
+    check_file(1, 0);
+
+    check_dijkstra(1, 0, 0, 5);
+    check_dijkstra(1000, 3000, EDGE_F_DIRECTED, 50);
+    check_dijkstra(2000, 2500, 0, 50);
+
+    check_from_graph(1000, 3000);
+    check_from_graph(1, 2);
+
+    check_mst(1000, 800);
+    check_mst(2000, 10000);
+    check_mst(1, 0);
+
+    check_cycles(100, 300);
+    check_cycles(1000, 2000);
+    check_cycles(2, 0);
+
+    check_scc(300, 300);
+    check_scc(300, 600);
+    check_scc(200, 2000);
+    check_scc(1, 0);
+    check_deep(1 << 21);
+
+    bench(size, 8 * (size_t)size, delta);
+    bench_bfs(size, 8 * (size_t)size);
+    bench_msbfs(size, 8 * (size_t)size, 512);
+    bench_file(size, 8 * (size_t)size);
+    bench_scc(size, 2 * (size_t)size);
+
+    return 0;
+}
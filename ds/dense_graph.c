@@ -0,0 +1,395 @@
+#include "dense_graph.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Words processed by one vector operation: row operations go word by
+ * word up to a multiple of it, then vector by vector.
+ */
+#define DENSE_GRAPH_BLOCK (DENSE_GRAPH_ALIGN / sizeof(uint64_t))
+
+static inline unsigned
+dense_popcount(uint64_t x)
+{
+    return __builtin_popcountll(x);
+}
+
+/**
+ * Bitset of nwords words, aligned as rows are.
+ */
+static uint64_t *
+dense_bitset_new(size_t nwords)
+{
+    void *bits = NULL;
+
+    if (0 != posix_memalign(&bits, DENSE_GRAPH_ALIGN, (nwords ? nwords : DENSE_GRAPH_BLOCK) * sizeof(uint64_t))) {
+        return NULL;
+    }
+    memset(bits, 0, nwords * sizeof(uint64_t));
+    return bits;
+}
+
+/**
+ * dst |= src
+ */
+static inline void
+dense_or(uint64_t *dst, const uint64_t *src, size_t nwords)
+{
+#if defined(__AVX2__)
+    for (size_t w = 0; w < nwords; w += DENSE_GRAPH_BLOCK) {
+        __m256i d = _mm256_load_si256((const __m256i *)&dst[w]);
+        __m256i s = _mm256_load_si256((const __m256i *)&src[w]);
+        _mm256_store_si256((__m256i *)&dst[w], _mm256_or_si256(d, s));
+    }
+#else
+    for (size_t w = 0; w < nwords; ++w) {
+        dst[w] |= src[w];
+    }
+#endif
+}
+
+/**
+ * dst &= ~mask, returns whether any bit is left in dst.
+ */
+static inline bool
+dense_andnot(uint64_t *dst, const uint64_t *mask, size_t nwords)
+{
+#if defined(__AVX2__)
+    __m256i any = _mm256_setzero_si256();
+
+    for (size_t w = 0; w < nwords; w += DENSE_GRAPH_BLOCK) {
+        __m256i d = _mm256_load_si256((const __m256i *)&dst[w]);
+        __m256i m = _mm256_load_si256((const __m256i *)&mask[w]);
+        d = _mm256_andnot_si256(m, d);
+        _mm256_store_si256((__m256i *)&dst[w], d);
+        any = _mm256_or_si256(any, d);
+    }
+    return !_mm256_testz_si256(any, any);
+#else
+    uint64_t any = 0;
+
+    for (size_t w = 0; w < nwords; ++w) {
+        dst[w] &= ~mask[w];
+        any |= dst[w];
+    }
+    return 0 != any;
+#endif
+}
+
+/**
+ * Returns whether a & b has any bit set.
+ */
+static inline bool
+dense_intersects(const uint64_t *a, const uint64_t *b, size_t nwords)
+{
+#if defined(__AVX2__)
+    for (size_t w = 0; w < nwords; w += DENSE_GRAPH_BLOCK) {
+        __m256i x = _mm256_load_si256((const __m256i *)&a[w]);
+        __m256i y = _mm256_load_si256((const __m256i *)&b[w]);
+        if (!_mm256_testz_si256(x, y)) {
+            return true;
+        }
+    }
+#else
+    for (size_t w = 0; w < nwords; ++w) {
+        if (a[w] & b[w]) {
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
+/**
+ * Returns number of bits set in a & b, a and b being aligned.
+ *
+ * The AVX2 version counts bits of every nibble with a 16 entries lookup
+ * table (vpshufb) and sums bytes of counts into 64 bits lanes (vpsadbw).
+ */
+static inline size_t
+dense_and_popcount(const uint64_t *a, const uint64_t *b, size_t nwords)
+{
+    size_t count = 0;
+#if defined(__AVX2__)
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i sum = _mm256_setzero_si256();
+
+    for (size_t w = 0; w < nwords; w += DENSE_GRAPH_BLOCK) {
+        __m256i x = _mm256_and_si256(_mm256_load_si256((const __m256i *)&a[w]),
+                                     _mm256_load_si256((const __m256i *)&b[w]));
+        __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(x, low));
+        __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(x, 4), low));
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+    }
+    count = _mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 1) +
+        _mm256_extract_epi64(sum, 2) + _mm256_extract_epi64(sum, 3);
+#else
+    for (size_t w = 0; w < nwords; ++w) {
+        count += dense_popcount(a[w] & b[w]);
+    }
+#endif
+    return count;
+}
+
+/**
+ * Same as dense_and_popcount, counting only bits from first on.
+ */
+static size_t
+dense_and_popcount_from(const uint64_t *a, const uint64_t *b, size_t first, size_t nwords)
+{
+    size_t w = first / DENSE_GRAPH_WORD_BITS;
+    size_t count = 0;
+
+    if (w >= nwords) {
+        return 0;
+    }
+    count = dense_popcount(a[w] & b[w] & (~UINT64_C(0) << (first % DENSE_GRAPH_WORD_BITS)));
+    for (++w; w < nwords && 0 != w % DENSE_GRAPH_BLOCK; ++w) {
+        count += dense_popcount(a[w] & b[w]);
+    }
+    return count + dense_and_popcount(a + w, b + w, nwords - w);
+}
+
+dense_graph_t *
+dense_graph_new(int size)
+{
+    dense_graph_t *dense = calloc(1, sizeof(dense_graph_t));
+
+    if (NULL != dense) {
+        size_t nbits = DENSE_GRAPH_BLOCK * DENSE_GRAPH_WORD_BITS;
+        dense->size = size;
+        dense->nwords = (size + nbits - 1) / nbits * DENSE_GRAPH_BLOCK;
+        dense->rows = dense_bitset_new((size_t)size * dense->nwords);
+        if (NULL == dense->rows) {
+            goto error;
+        }
+    }
+    return dense;
+
+error:
+    dense_graph_free(dense);
+    return NULL;
+}
+
+void
+dense_graph_free(dense_graph_t *dense)
+{
+    if (NULL != dense) {
+        free(dense->rows);
+        free(dense);
+    }
+}
+
+dense_graph_t *
+dense_graph_from_graph(graph_t *graph)
+{
+    dense_graph_t *dense = dense_graph_new(graph->size);
+
+    if (NULL != dense) {
+        for (int u = 0; u < graph->size; ++u) {
+            vertex_t *vu = &graph->vertices[u];
+            node_t *node = NULL;
+            list_foreach(vu->edges, node) {
+                dense_graph_edge_add(dense, u, edge_pair_get(node_data(node), vu)->index, EDGE_F_DIRECTED);
+            }
+        }
+    }
+    return dense;
+}
+
+size_t
+dense_graph_degree(const dense_graph_t *dense, int u)
+{
+    const uint64_t *row = dense_graph_row(dense, u);
+    size_t degree = 0;
+
+    for (size_t w = 0; w < dense->nwords; ++w) {
+        degree += dense_popcount(row[w]);
+    }
+    return degree;
+}
+
+typedef struct dense_search dense_search_t;
+
+/**
+ * Breadth-first search bitsets. Padding bits past the last vertex are
+ * marked visited, so they are never picked as sources.
+ */
+struct dense_search {
+    uint64_t *visited;
+    uint64_t *frontier;
+    uint64_t *next;
+};
+
+static void
+dense_search_fini(dense_search_t *ds)
+{
+    free(ds->visited);
+    free(ds->frontier);
+    free(ds->next);
+}
+
+static int
+dense_search_init(dense_search_t *ds, const dense_graph_t *dense)
+{
+    ds->visited = dense_bitset_new(dense->nwords);
+    ds->frontier = dense_bitset_new(dense->nwords);
+    ds->next = dense_bitset_new(dense->nwords);
+
+    if (NULL == ds->visited || NULL == ds->frontier || NULL == ds->next) {
+        dense_search_fini(ds);
+        return -1;
+    }
+    for (size_t v = dense->size; v < dense->nwords * DENSE_GRAPH_WORD_BITS; ++v) {
+        ds->visited[v / DENSE_GRAPH_WORD_BITS] |= UINT64_C(1) << (v % DENSE_GRAPH_WORD_BITS);
+    }
+    return 0;
+}
+
+/**
+ * Returns first vertex not visited from word w on, -1 if none.
+ */
+static int
+dense_search_unvisited(const dense_search_t *ds, const dense_graph_t *dense, size_t *w)
+{
+    for (; *w < dense->nwords; ++*w) {
+        if (~ds->visited[*w]) {
+            return (int)(*w * DENSE_GRAPH_WORD_BITS) + ffsll(~ds->visited[*w]) - 1;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Breadth-first search from s over vertices not visited yet, leaving
+ * them visited.
+ *
+ * @param distance receives level of every vertex reached (optional)
+ * @param label receives component of every vertex reached (optional)
+ * @param check whether to stop at the first level holding both ends of
+ *        an edge
+ * @return false if check stopped the search, true otherwise.
+ */
+static bool
+dense_search_run(const dense_graph_t *dense, dense_search_t *ds, int s, int *distance, int *label, int component, bool check)
+{
+    size_t nwords = dense->nwords;
+    int level = 0;
+
+    memset(ds->frontier, 0, nwords * sizeof(uint64_t));
+    ds->frontier[s / DENSE_GRAPH_WORD_BITS] |= UINT64_C(1) << (s % DENSE_GRAPH_WORD_BITS);
+    dense_or(ds->visited, ds->frontier, nwords);
+
+    for (;;) {
+        uint64_t *frontier = ds->frontier;
+
+        memset(ds->next, 0, nwords * sizeof(uint64_t));
+        for (size_t w = 0; w < nwords; ++w) {
+            uint64_t bits = frontier[w];
+            while (bits) {
+                int u = (int)(w * DENSE_GRAPH_WORD_BITS) + ffsll(bits) - 1;
+                const uint64_t *row = dense_graph_row(dense, u);
+                if (check && dense_intersects(row, frontier, nwords)) {
+                    return false;
+                }
+                if (NULL != distance) {
+                    distance[u] = level;
+                }
+                if (NULL != label) {
+                    label[u] = component;
+                }
+                dense_or(ds->next, row, nwords);
+                bits &= bits - 1;
+            }
+        }
+
+        if (!dense_andnot(ds->next, ds->visited, nwords)) {
+            return true;
+        }
+        dense_or(ds->visited, ds->next, nwords);
+        ds->frontier = ds->next;
+        ds->next = frontier;
+        level++;
+    }
+}
+
+int
+dense_graph_bfs(const dense_graph_t *dense, int s, int *distance)
+{
+    dense_search_t ds;
+
+    if (0 != dense_search_init(&ds, dense)) {
+        return -1;
+    }
+    for (int v = 0; v < dense->size; ++v) {
+        distance[v] = -1;
+    }
+    dense_search_run(dense, &ds, s, distance, NULL, 0, false);
+    dense_search_fini(&ds);
+    return 0;
+}
+
+int
+dense_graph_connected_count(const dense_graph_t *dense, int *label)
+{
+    dense_search_t ds;
+    size_t w = 0;
+    int count = 0;
+    int s;
+
+    if (0 != dense_search_init(&ds, dense)) {
+        return -1;
+    }
+    while (-1 != (s = dense_search_unvisited(&ds, dense, &w))) {
+        dense_search_run(dense, &ds, s, NULL, label, count++, false);
+    }
+    dense_search_fini(&ds);
+    return count;
+}
+
+bool
+dense_graph_is_bipartite(const dense_graph_t *dense)
+{
+    dense_search_t ds;
+    bool bipartite = true;
+    size_t w = 0;
+    int s;
+
+    if (0 != dense_search_init(&ds, dense)) {
+        return false;
+    }
+    while (bipartite && -1 != (s = dense_search_unvisited(&ds, dense, &w))) {
+        bipartite = dense_search_run(dense, &ds, s, NULL, NULL, 0, true);
+    }
+    dense_search_fini(&ds);
+    return bipartite;
+}
+
+long long
+dense_graph_triangles(const dense_graph_t *dense)
+{
+    long long count = 0;
+
+    for (int u = 0; u < dense->size; ++u) {
+        const uint64_t *row = dense_graph_row(dense, u);
+        size_t w = (size_t)u / DENSE_GRAPH_WORD_BITS;
+        uint64_t bits = row[w] & (~UINT64_C(1) << (u % DENSE_GRAPH_WORD_BITS));
+
+        for (;;) {
+            while (bits) {
+                int v = (int)(w * DENSE_GRAPH_WORD_BITS) + ffsll(bits) - 1;
+                count += dense_and_popcount_from(row, dense_graph_row(dense, v), v + 1, dense->nwords);
+                bits &= bits - 1;
+            }
+            if (++w == dense->nwords) {
+                break;
+            }
+            bits = row[w];
+        }
+    }
+    return count;
+}
@@ -0,0 +1,124 @@
+#ifndef __DENSE_GRAPH__H__
+#define __DENSE_GRAPH__H__
+
+#include "includes.h"
+#include "graph.h"
+
+/**
+ * Dense graph: adjacency matrix stored as one packed bitset per vertex.
+ *
+ * Bit v of row u is set if there is an arc u -> v, so a graph of V
+ * vertices takes V * V / 8 bytes whatever its number of edges, instead
+ * of one edge_t and list nodes per edge in graph_t: for graphs with more
+ * than a few percent of all possible edges it's much smaller. Rows are
+ * padded to DENSE_GRAPH_ALIGN bytes and aligned on them, so algorithms
+ * combine whole rows with word-wide (or AVX2 if enabled at compile time)
+ * AND, OR and population counts, 64 (or 256) vertices at a time.
+ *
+ * Weights are not stored.
+ */
+
+#define DENSE_GRAPH_ALIGN 32
+#define DENSE_GRAPH_WORD_BITS 64
+
+typedef struct dense_graph dense_graph_t;
+
+struct dense_graph {
+    uint64_t *rows;  /**< size * nwords words, row u at rows + u * nwords */
+    int size;        /**< number of vertices */
+    size_t nwords;   /**< words per row, multiple of DENSE_GRAPH_ALIGN / 8 */
+};
+
+static inline uint64_t *
+dense_graph_row(const dense_graph_t *dense, int u)
+{
+    return dense->rows + (size_t)u * dense->nwords;
+}
+
+static inline bool
+dense_graph_has_edge(const dense_graph_t *dense, int u, int v)
+{
+    return (dense_graph_row(dense, u)[v / DENSE_GRAPH_WORD_BITS] >> (v % DENSE_GRAPH_WORD_BITS)) & 1;
+}
+
+/**
+ * Adds edge u-v, only arc u -> v if flags has EDGE_F_DIRECTED.
+ *
+ * Parallel edges collapse into one.
+ */
+static inline void
+dense_graph_edge_add(dense_graph_t *dense, int u, int v, edge_flags_t flags)
+{
+    dense_graph_row(dense, u)[v / DENSE_GRAPH_WORD_BITS] |= UINT64_C(1) << (v % DENSE_GRAPH_WORD_BITS);
+    if (!(flags & EDGE_F_DIRECTED)) {
+        dense_graph_row(dense, v)[u / DENSE_GRAPH_WORD_BITS] |= UINT64_C(1) << (u % DENSE_GRAPH_WORD_BITS);
+    }
+}
+
+/**
+ * Allocates dense graph of size vertices and no edges.
+ */
+dense_graph_t *
+dense_graph_new(int size);
+
+void
+dense_graph_free(dense_graph_t *dense);
+
+/**
+ * Converts list based graph into dense graph: every edge found in the
+ * adjacency list of u sets bit of its other endpoint in row u.
+ */
+dense_graph_t *
+dense_graph_from_graph(graph_t *graph);
+
+/**
+ * Returns number of arcs out of u.
+ */
+size_t
+dense_graph_degree(const dense_graph_t *dense, int u);
+
+/**
+ * Breadth-first search from s.
+ *
+ * A level ORs rows of frontier vertices and masks vertices already
+ * visited out, so the search costs O(V * V / 64) word operations,
+ * independently of the number of edges.
+ *
+ * @param distance array of dense->size entries, number of arcs in a
+ *        shortest path from s, -1 if unreachable
+ * @return zero on success, -1 on allocation failure.
+ */
+int
+dense_graph_bfs(const dense_graph_t *dense, int s, int *distance);
+
+/**
+ * Connected components, dense being undirected (symmetric rows).
+ *
+ * @param label array of dense->size entries, component of every vertex,
+ *        components being numbered from 0 in order of their smallest
+ *        vertex (optional)
+ * @return number of components, -1 on allocation failure.
+ */
+int
+dense_graph_connected_count(const dense_graph_t *dense, int *label);
+
+/**
+ * Returns true if vertices of dense, being undirected, can be colored in
+ * two colors with no edge inside a color: no breadth-first search level
+ * holds both ends of an edge (a level's rows ANDed with the level itself
+ * are empty). Self loops make a graph not bipartite.
+ *
+ * False is also returned on allocation failure.
+ */
+bool
+dense_graph_is_bipartite(const dense_graph_t *dense);
+
+/**
+ * Returns number of triangles of dense, being undirected: every edge u-v,
+ * u < v, counts common neighbors w > v of u and v with one AND and
+ * population count of their rows. Self loops are ignored.
+ */
+long long
+dense_graph_triangles(const dense_graph_t *dense);
+
+#endif /* __DENSE_GRAPH__H__ */
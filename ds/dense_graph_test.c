@@ -0,0 +1,173 @@
+#include "includes.h"
+#include "dense_graph.h"
+#include "csr_graph.h"
+
+static double
+now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ * Random undirected graph holding every possible edge with probability
+ * percent / 100, as both dense and CSR graphs. Bipartite graphs only get
+ * edges between even and odd vertices.
+ */
+static dense_graph_t *
+random_graph(int size, int percent, bool bipartite, csr_graph_t **csr)
+{
+    dense_graph_t *dense = dense_graph_new(size);
+    size_t capacity = 1024;
+    size_t nedges = 0;
+    csr_edge_t *edges = malloc(capacity * sizeof(csr_edge_t));
+
+    for (int u = 0; u < size; ++u) {
+        for (int v = u + 1; v < size; ++v) {
+            if (rand() % 100 >= percent || (bipartite && (u + v) % 2 == 0)) {
+                continue;
+            }
+            if (nedges == capacity) {
+                capacity *= 2;
+                edges = realloc(edges, capacity * sizeof(csr_edge_t));
+            }
+            edges[nedges].source = u;
+            edges[nedges].target = v;
+            edges[nedges++].weight = 1;
+            dense_graph_edge_add(dense, u, v, EDGE_F_NONE);
+        }
+    }
+
+    *csr = csr_graph_build(size, edges, nedges, EDGE_F_NONE);
+    free(edges);
+    return dense;
+}
+
+static long long
+brute_force_triangles(const dense_graph_t *dense)
+{
+    long long count = 0;
+
+    for (int u = 0; u < dense->size; ++u) {
+        for (int v = u + 1; v < dense->size; ++v) {
+            for (int w = v + 1; dense_graph_has_edge(dense, u, v) && w < dense->size; ++w) {
+                count += dense_graph_has_edge(dense, u, w) && dense_graph_has_edge(dense, v, w);
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * Checks dense graph algorithms against CSR graph ones.
+ */
+static void
+check(int size, int percent, bool bipartite)
+{
+    csr_graph_t *csr = NULL;
+    dense_graph_t *dense = random_graph(size, percent, bipartite, &csr);
+    int *expected = malloc((size ? size : 1) * sizeof(int));
+    int *distance = malloc((size ? size : 1) * sizeof(int));
+    int *label = malloc((size ? size : 1) * sizeof(int));
+    bool ok = true;
+
+    for (int s = 0; ok && s < size; s += 1 + size / 8) {
+        ok = 0 == dense_graph_bfs(dense, s, distance) &&
+            0 == csr_graph_bfs(csr, csr, s, 1, expected, NULL) &&
+            0 == memcmp(expected, distance, size * sizeof(int));
+    }
+
+    ok = ok && dense_graph_connected_count(dense, label) == csr_graph_connected_count(csr);
+    for (int v = 0, max = -1; ok && v < size; ++v) {
+        size_t i;
+        ok = label[v] <= max + 1;
+        max = label[v] > max ? label[v] : max;
+        csr_graph_foreach(csr, v, i) {
+            ok = ok && label[v] == label[csr->targets[i]];
+        }
+    }
+
+    ok = ok && dense_graph_is_bipartite(dense) == csr_graph_is_bipartite(csr);
+    ok = ok && (!bipartite || dense_graph_is_bipartite(dense));
+    ok = ok && dense_graph_triangles(dense) == brute_force_triangles(dense);
+    for (int v = 0; ok && v < size; ++v) {
+        ok = dense_graph_degree(dense, v) == csr_graph_degree(csr, v);
+    }
+
+    printf("dense graph %d vertices %d%%%s: %zu arcs: %s\n", size, percent,
+           bipartite ? " bipartite" : "", csr->nedges, ok ? "ok" : "FAILED");
+
+    free(expected);
+    free(distance);
+    free(label);
+    csr_graph_free(csr);
+    dense_graph_free(dense);
+}
+
+static void
+bench(int size, int percent)
+{
+    csr_graph_t *csr = NULL;
+    dense_graph_t *dense = random_graph(size, percent, false, &csr);
+    int *distance = malloc(size * sizeof(int));
+    double elapsed[2];
+    double start;
+    long long triangles;
+
+    printf("dense graph %d vertices %zu arcs: %.1f MB, csr %.1f MB\n", size, csr->nedges,
+           size * dense->nwords * sizeof(uint64_t) / 1e6,
+           ((size + 1) * sizeof(size_t) + csr->nedges * (sizeof(int) + sizeof(long))) / 1e6);
+
+    start = now();
+    dense_graph_bfs(dense, 0, distance);
+    elapsed[0] = now() - start;
+    start = now();
+    csr_graph_bfs(csr, csr, 0, 1, distance, NULL);
+    elapsed[1] = now() - start;
+    printf("bfs: dense %.3fs, csr %.3fs\n", elapsed[0], elapsed[1]);
+
+    start = now();
+    dense_graph_connected_count(dense, NULL);
+    elapsed[0] = now() - start;
+    start = now();
+    csr_graph_connected_count(csr);
+    elapsed[1] = now() - start;
+    printf("connected components: dense %.3fs, csr %.3fs\n", elapsed[0], elapsed[1]);
+
+    start = now();
+    dense_graph_is_bipartite(dense);
+    elapsed[0] = now() - start;
+    start = now();
+    csr_graph_is_bipartite(csr);
+    elapsed[1] = now() - start;
+    printf("bipartite: dense %.3fs, csr %.3fs\n", elapsed[0], elapsed[1]);
+
+    start = now();
+    triangles = dense_graph_triangles(dense);
+    printf("triangles: %lld in %.3fs\n", triangles, now() - start);
+
+    free(distance);
+    csr_graph_free(csr);
+    dense_graph_free(dense);
+}
+
+int main(int argc, char **argv)
+{
+    int size = argc > 1 ? atoi(argv[1]) : 1 << 13;
+    int percent = argc > 2 ? atoi(argv[2]) : 10;
+
+    srand(1);
+
+    check(0, 50, false);
+    check(1, 50, false);
+    check(70, 3, false);
+    check(300, 20, false);
+    check(300, 1, false);
+    check(257, 30, true);
+    check(500, 2, true);
+
+    bench(size, percent);
+
+    return 0;
+}
@@ -1,18 +1,21 @@
 #include "disjoint_sets.h"
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
 
-typedef struct set set_t;
-
-struct set {
-    int parent;
-    int rank;
-    int size;
-    void *data;
-};
+/**
+ * Number of elements (or pairs) batch operations prefetch ahead.
+ */
+#define DISJOINT_SETS_PREFETCH 16
 
+/**
+ * parent[i] >= 0 is parent of i, parent[i] < 0 makes i a root of a set
+ * of -parent[i] elements.
+ */
 struct disjoint_sets {
     int n;
-    set_t *sets;
+    int capacity;
+    int32_t *parent;
 };
 
 disjoint_sets_t *
@@ -20,11 +23,13 @@ disjoint_sets_new(int n)
 {
     disjoint_sets_t *ds = calloc(1, sizeof(disjoint_sets_t));
     if (NULL != ds) {
-        ds->sets = calloc(n, sizeof(set_t));
-        if (NULL == ds->sets) {
+        ds->parent = malloc((n > 0 ? n : 1) * sizeof(int32_t));
+        if (NULL == ds->parent) {
             goto error;
         }
         ds->n = n;
+        ds->capacity = n > 0 ? n : 1;
+        disjoint_sets_make_set(ds);
     }
     return ds;
 
@@ -37,8 +42,8 @@ void
 disjoint_sets_free(disjoint_sets_t *ds)
 {
     if (NULL != ds) {
-        free(ds->sets);
-        ds->sets = NULL;
+        free(ds->parent);
+        ds->parent = NULL;
         free(ds);
     }
 }
@@ -48,43 +53,113 @@ disjoint_sets_make_set(disjoint_sets_t *ds)
 {
     int i;
     for (i = 0; i < ds->n; ++i) {
-        ds->sets[i].parent = i;
-        ds->sets[i].size = 1;
-        ds->sets[i].rank = 0;
+        ds->parent[i] = -1;
+    }
+}
+
+int
+disjoint_sets_add(disjoint_sets_t *ds)
+{
+    if (ds->n == ds->capacity) {
+        int capacity;
+        int32_t *parent;
+
+        if (ds->capacity == INT_MAX) {
+            return -1;
+        }
+        capacity = ds->capacity > INT_MAX - ds->capacity / 2 ? INT_MAX : ds->capacity + ds->capacity / 2 + 1;
+        parent = realloc(ds->parent, (size_t)capacity * sizeof(int32_t));
+        if (NULL == parent) {
+            return -1;
+        }
+        ds->parent = parent;
+        ds->capacity = capacity;
     }
+    ds->parent[ds->n] = -1;
+    return ds->n++;
+}
+
+int
+disjoint_sets_count(disjoint_sets_t *ds)
+{
+    return ds->n;
 }
 
 int
 disjoint_sets_find(disjoint_sets_t *ds, int i)
 {
-    while (i != ds->sets[i].parent) {
-        ds->sets[i].parent = ds->sets[ds->sets[i].parent].parent;
-        i = ds->sets[i].parent;
+    int32_t *parent = ds->parent;
+
+    while (parent[i] >= 0) {
+        if (parent[parent[i]] >= 0) {
+            parent[i] = parent[parent[i]];
+        }
+        i = parent[i];
     }
     return i;
 }
 
-void
+bool
 disjoint_sets_union(disjoint_sets_t *ds, int i, int j)
 {
     int id_i = disjoint_sets_find(ds, i);
     int id_j = disjoint_sets_find(ds, j);
 
     if (id_i == id_j) {
-        return;
+        return false;
     }
 
     int parent = id_i;
     int child  = id_j;
 
-    if (ds->sets[parent].rank < ds->sets[child].rank) {
+    /**
+     * Sizes are negative: larger set has smaller value.
+     */
+    if (ds->parent[parent] > ds->parent[child]) {
         parent = id_j;
         child  = id_i;
     }
 
-    ds->sets[child].parent = parent;
-    ds->sets[parent].size += ds->sets[child].size;
-    if (ds->sets[child].rank == ds->sets[parent].rank) {
-        ds->sets[parent].rank++;
+    ds->parent[parent] += ds->parent[child];
+    ds->parent[child] = parent;
+
+    return true;
+}
+
+int
+disjoint_sets_set_size(disjoint_sets_t *ds, int i)
+{
+    return -ds->parent[disjoint_sets_find(ds, i)];
+}
+
+void
+disjoint_sets_find_batch(disjoint_sets_t *ds, const int *elements, int *roots, size_t n)
+{
+    for (size_t k = 0; k < n; ++k) {
+        if (k + DISJOINT_SETS_PREFETCH < n) {
+            __builtin_prefetch(&ds->parent[elements[k + DISJOINT_SETS_PREFETCH]]);
+        }
+        roots[k] = disjoint_sets_find(ds, elements[k]);
+    }
+}
+
+size_t
+disjoint_sets_union_batch(disjoint_sets_t *ds, const int *pairs, size_t npairs, bool *merged)
+{
+    size_t count = 0;
+
+    for (size_t k = 0; k < npairs; ++k) {
+        bool m;
+
+        if (k + DISJOINT_SETS_PREFETCH < npairs) {
+            __builtin_prefetch(&ds->parent[pairs[2 * (k + DISJOINT_SETS_PREFETCH)]], 1);
+            __builtin_prefetch(&ds->parent[pairs[2 * (k + DISJOINT_SETS_PREFETCH) + 1]], 1);
+        }
+        m = disjoint_sets_union(ds, pairs[2 * k], pairs[2 * k + 1]);
+        if (NULL != merged) {
+            merged[k] = m;
+        }
+        count += m;
     }
+    return count;
 }
@@ -1,21 +1,85 @@
 #ifndef _DISJOINT_SETS__H_
 #define _DISJOINT_SETS__H_
 
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Disjoint sets (union-find) with path halving and union by size.
+ *
+ * Every element takes 4 bytes: a single array holds parent of every
+ * element that is not a root, and minus size of its set for every root.
+ * Elements might be appended at any time.
+ *
+ * Batch operations take arrays of elements (or pairs) and prefetch
+ * parents of elements a few positions ahead, which overlaps cache misses
+ * of the first step of many finds on large sets.
+ */
+
 typedef struct disjoint_sets disjoint_sets_t;
 
+/**
+ * Allocates disjoint sets of n elements, every one in a set of its own.
+ */
 disjoint_sets_t *
 disjoint_sets_new(int n);
 
 void
 disjoint_sets_free(disjoint_sets_t *ds);
 
+/**
+ * Makes every element a set of its own.
+ */
 void
 disjoint_sets_make_set(disjoint_sets_t *ds);
 
+/**
+ * Appends new element, in a set of its own.
+ *
+ * It's an O(1) amortized time operation.
+ *
+ * @return index of new element, -1 on allocation failure.
+ */
+int
+disjoint_sets_add(disjoint_sets_t *ds);
+
+/**
+ * Returns current number of elements.
+ */
+int
+disjoint_sets_count(disjoint_sets_t *ds);
+
 int
 disjoint_sets_find(disjoint_sets_t *ds, int i);
 
-void
+/**
+ * Merges sets of i and j, smaller set going below larger one.
+ *
+ * @return true if sets were merged, false if already the same set.
+ */
+bool
 disjoint_sets_union(disjoint_sets_t *ds, int i, int j);
 
+/**
+ * Returns number of elements in the set of i.
+ */
+int
+disjoint_sets_set_size(disjoint_sets_t *ds, int i);
+
+/**
+ * Stores representative of elements[k] in roots[k], 0 <= k < n.
+ */
+void
+disjoint_sets_find_batch(disjoint_sets_t *ds, const int *elements, int *roots, size_t n);
+
+/**
+ * Merges sets of pairs[2k] and pairs[2k + 1], 0 <= k < npairs, in order.
+ *
+ * @param merged if not NULL, merged[k] is set to whether k-th union
+ *        merged two sets (optional)
+ * @return number of unions that merged two sets.
+ */
+size_t
+disjoint_sets_union_batch(disjoint_sets_t *ds, const int *pairs, size_t npairs, bool *merged);
+
 #endif /* _DISJOINT_SETS__H_ */
@@ -0,0 +1,246 @@
+#include "includes.h"
+#include "disjoint_sets.h"
+#include "concurrent_disjoint_sets.h"
+#include "parallel.h"
+#include <stdatomic.h>
+
+typedef struct union_task union_task_t;
+
+struct union_task {
+    concurrent_disjoint_sets_t *ds;
+    const int *pairs;
+    size_t npairs;
+    atomic_size_t merged;
+};
+
+static double
+now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void
+union_worker(void *arg, int id, int nthreads)
+{
+    union_task_t *task = arg;
+    size_t merged = 0;
+    size_t begin;
+    size_t end;
+
+    parallel_range(task->npairs, id, nthreads, &begin, &end);
+    for (size_t k = begin; k < end; ++k) {
+        if (concurrent_disjoint_sets_union(task->ds, task->pairs[2 * k], task->pairs[2 * k + 1])) {
+            merged++;
+        }
+    }
+    atomic_fetch_add(&task->merged, merged);
+}
+
+static int *
+random_pairs(int n, size_t npairs)
+{
+    int *pairs = malloc(2 * npairs * sizeof(int));
+
+    for (size_t k = 0; k < 2 * npairs; ++k) {
+        pairs[k] = rand() % n;
+    }
+    return pairs;
+}
+
+/**
+ * Number of sets left after pairs are merged, counted without any
+ * disjoint sets: labels are propagated until nothing changes.
+ */
+static int
+components(const int *pairs, int n, size_t npairs)
+{
+    int *label = malloc(n * sizeof(int));
+    bool changed = true;
+    int count = 0;
+
+    for (int i = 0; i < n; ++i) {
+        label[i] = i;
+    }
+    while (changed) {
+        changed = false;
+        for (size_t k = 0; k < npairs; ++k) {
+            int u = pairs[2 * k];
+            int v = pairs[2 * k + 1];
+            if (label[u] != label[v]) {
+                label[u] = label[v] = label[u] < label[v] ? label[u] : label[v];
+                changed = true;
+            }
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        count += label[i] == i;
+    }
+
+    free(label);
+    return count;
+}
+
+/**
+ * Checks concurrent unions build the same sets as sequential ones,
+ * with smallest element of every set as representative.
+ */
+static void
+check(int n, size_t npairs)
+{
+    int *pairs = random_pairs(n, npairs);
+    disjoint_sets_t *ds = disjoint_sets_new(n);
+    int *minimum = malloc(n * sizeof(int));
+    int components = n;
+
+    disjoint_sets_make_set(ds);
+    for (size_t k = 0; k < npairs; ++k) {
+        if (disjoint_sets_find(ds, pairs[2 * k]) != disjoint_sets_find(ds, pairs[2 * k + 1])) {
+            components--;
+        }
+        disjoint_sets_union(ds, pairs[2 * k], pairs[2 * k + 1]);
+    }
+    for (int i = 0; i < n; ++i) {
+        minimum[i] = n;
+    }
+    for (int i = 0; i < n; ++i) {
+        int root = disjoint_sets_find(ds, i);
+        if (i < minimum[root]) {
+            minimum[root] = i;
+        }
+    }
+
+    for (int nthreads = 1; nthreads <= 4; ++nthreads) {
+        union_task_t task = { concurrent_disjoint_sets_new(n), pairs, npairs, 0 };
+        bool ok = true;
+
+        concurrent_disjoint_sets_make_set(task.ds);
+        parallel_run(nthreads, union_worker, &task);
+
+        ok = (size_t)(n - components) == atomic_load(&task.merged);
+        for (int i = 0; i < n && ok; ++i) {
+            int j = pairs[rand() % (2 * npairs)];
+            ok = concurrent_disjoint_sets_find(task.ds, i) == minimum[disjoint_sets_find(ds, i)] &&
+                concurrent_disjoint_sets_same_set(task.ds, i, j) ==
+                (disjoint_sets_find(ds, i) == disjoint_sets_find(ds, j));
+        }
+        printf("concurrent disjoint sets %d elements %zu unions threads %d: %s\n",
+               n, npairs, nthreads, ok ? "ok" : "FAILED");
+
+        concurrent_disjoint_sets_free(task.ds);
+    }
+
+    free(minimum);
+    free(pairs);
+    disjoint_sets_free(ds);
+}
+
+/**
+ * Checks elements appended at runtime and batch operations against
+ * one by one ones.
+ */
+static void
+check_batch(int n, size_t npairs)
+{
+    int *pairs = random_pairs(n, npairs);
+    disjoint_sets_t *ds = disjoint_sets_new(0);
+    disjoint_sets_t *batch = disjoint_sets_new(n / 2);
+    int *elements = malloc(n * sizeof(int));
+    int *roots = malloc(n * sizeof(int));
+    bool *merged = malloc(npairs * sizeof(bool));
+    size_t count = 0;
+    bool ok = true;
+
+    for (int i = 0; i < n; ++i) {
+        ok = ok && i == disjoint_sets_add(ds);
+        elements[i] = i;
+    }
+    for (int i = n / 2; i < n; ++i) {
+        ok = ok && i == disjoint_sets_add(batch);
+    }
+    ok = ok && n == disjoint_sets_count(ds) && n == disjoint_sets_count(batch);
+
+    ok = ok && disjoint_sets_union_batch(batch, pairs, npairs, merged) == n - components(pairs, n, npairs);
+    for (size_t k = 0; k < npairs; ++k) {
+        bool m = disjoint_sets_union(ds, pairs[2 * k], pairs[2 * k + 1]);
+        ok = ok && m == merged[k];
+        count += m;
+    }
+
+    disjoint_sets_find_batch(batch, elements, roots, n);
+    for (int i = 0; i < n; ++i) {
+        ok = ok && roots[i] == disjoint_sets_find(batch, i) &&
+            disjoint_sets_set_size(ds, i) == disjoint_sets_set_size(batch, i);
+    }
+    printf("disjoint sets batch %d elements %zu unions %zu merged: %s\n", n, npairs, count, ok ? "ok" : "FAILED");
+
+    free(elements);
+    free(roots);
+    free(merged);
+    free(pairs);
+    disjoint_sets_free(ds);
+    disjoint_sets_free(batch);
+}
+
+static void
+bench(int n, size_t npairs)
+{
+    int *pairs = random_pairs(n, npairs);
+    disjoint_sets_t *ds = disjoint_sets_new(n);
+    int max_threads = parallel_threads(0);
+    double start = now();
+    double base;
+
+    disjoint_sets_make_set(ds);
+    for (size_t k = 0; k < npairs; ++k) {
+        disjoint_sets_union(ds, pairs[2 * k], pairs[2 * k + 1]);
+    }
+    base = now() - start;
+    printf("disjoint sets %d elements %zu unions: %.3fs\n", n, npairs, base);
+
+    disjoint_sets_make_set(ds);
+    start = now();
+    disjoint_sets_union_batch(ds, pairs, npairs, NULL);
+    printf("disjoint sets %d elements %zu batch unions: %.3fs\n", n, npairs, now() - start);
+
+    for (int nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+        union_task_t task = { concurrent_disjoint_sets_new(n), pairs, npairs, 0 };
+        double elapsed;
+
+        concurrent_disjoint_sets_make_set(task.ds);
+        start = now();
+        parallel_run(nthreads, union_worker, &task);
+        elapsed = now() - start;
+        printf("concurrent disjoint sets %d elements %zu unions: %d threads %.3fs speedup %.2f\n",
+               n, npairs, nthreads, elapsed, base / elapsed);
+
+        concurrent_disjoint_sets_free(task.ds);
+        if (nthreads < max_threads && 2 * nthreads > max_threads) {
+            nthreads = max_threads / 2;
+        }
+    }
+
+    free(pairs);
+    disjoint_sets_free(ds);
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1 << 22;
+
+    srand(1);
+
+    check(10, 5);
+    check(1000, 500);
+    check(1000, 5000);
+    check(100000, 80000);
+
+    check_batch(10, 5);
+    check_batch(1000, 700);
+    check_batch(100000, 120000);
+
+    bench(n, 2 * (size_t)n);
+
+    return 0;
+}
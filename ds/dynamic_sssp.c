@@ -0,0 +1,334 @@
+#include "dynamic_sssp.h"
+#include "heap_define.h"
+
+typedef struct dynamic_sssp_entry dynamic_sssp_entry_t;
+
+/**
+ * Heap entries are never updated in place: stale ones (key no longer
+ * equal to distance of their vertex) are skipped.
+ */
+struct dynamic_sssp_entry {
+    long key;
+    int vertex;
+};
+
+#define dynamic_sssp_entry_less(e1, e2) ((e1).key < (e2).key)
+
+HEAP_DEFINE(dynamic_sssp_heap, dynamic_sssp_entry_t, dynamic_sssp_entry_less)
+
+static inline int
+dynamic_sssp_index(dynamic_sssp_t *sssp, vertex_t *v)
+{
+    return v - sssp->graph->vertices;
+}
+
+/**
+ * Counts vertex as touched by current update, once.
+ */
+static inline void
+dynamic_sssp_touch(dynamic_sssp_t *sssp, int v, long *touched)
+{
+    if (sssp->mark[v] != sssp->epoch) {
+        sssp->mark[v] = sssp->epoch;
+        (*touched)++;
+    }
+}
+
+static int
+dynamic_sssp_offer(dynamic_sssp_t *sssp, int v, int u, edge_t *edge, long distance)
+{
+    dynamic_sssp_entry_t entry;
+
+    sssp->distance[v] = distance;
+    sssp->parent[v] = u;
+    sssp->parent_edge[v] = edge;
+
+    entry.key = distance;
+    entry.vertex = v;
+    return dynamic_sssp_heap_insert(sssp->heap, &entry);
+}
+
+/**
+ * Dijkstra from vertices in the heap.
+ */
+static int
+dynamic_sssp_propagate(dynamic_sssp_t *sssp, long *touched)
+{
+    dynamic_sssp_entry_t entry = { 0, -1 };
+
+    while (NULL != dynamic_sssp_heap_pop_front(sssp->heap, &entry)) {
+        vertex_t *u = &sssp->graph->vertices[entry.vertex];
+        node_t *node = NULL;
+
+        if (entry.key != sssp->distance[entry.vertex]) {
+            continue;
+        }
+        dynamic_sssp_touch(sssp, entry.vertex, touched);
+
+        list_foreach(u->edges, node) {
+            edge_t *edge = node_data(node);
+            int v = dynamic_sssp_index(sssp, edge_pair_get(edge, u));
+            long distance = entry.key + edge->weight;
+
+            if (distance < sssp->distance[v] &&
+                0 != dynamic_sssp_offer(sssp, v, entry.vertex, edge, distance)) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Invalidates subtree of the shortest path tree rooted at v, appending
+ * its vertices to affected.
+ */
+static void
+dynamic_sssp_invalidate(dynamic_sssp_t *sssp, int v, int *naffected, long *touched)
+{
+    int head = *naffected;
+
+    sssp->affected[(*naffected)++] = v;
+    sssp->parent[v] = -1;
+
+    while (head < *naffected) {
+        int x = sssp->affected[head++];
+        vertex_t *u = &sssp->graph->vertices[x];
+        node_t *node = NULL;
+
+        list_foreach(u->edges, node) {
+            edge_t *edge = node_data(node);
+            int y = dynamic_sssp_index(sssp, edge_pair_get(edge, u));
+
+            if (sssp->parent[y] == x && sssp->parent_edge[y] == edge) {
+                sssp->affected[(*naffected)++] = y;
+                sssp->parent[y] = -1;
+            }
+        }
+
+        sssp->distance[x] = LONG_MAX;
+        sssp->parent_edge[x] = NULL;
+        dynamic_sssp_touch(sssp, x, touched);
+    }
+}
+
+/**
+ * Stores directions edge might be followed in as (tail, head) pairs,
+ * returns their number.
+ */
+static int
+dynamic_sssp_arcs(dynamic_sssp_t *sssp, edge_t *edge, int arcs[2][2])
+{
+    arcs[0][0] = dynamic_sssp_index(sssp, edge->endpoint1);
+    arcs[0][1] = dynamic_sssp_index(sssp, edge->endpoint2);
+    if (edge->directed || arcs[0][0] == arcs[0][1]) {
+        return 1;
+    }
+    arcs[1][0] = arcs[0][1];
+    arcs[1][1] = arcs[0][0];
+    return 2;
+}
+
+static int
+dynamic_sssp_in_edges(dynamic_sssp_t *sssp)
+{
+    graph_t *graph = sssp->graph;
+    size_t *cursor = NULL;
+    size_t nedges = 0;
+    int u;
+
+    for (u = 0; u < graph->size; ++u) {
+        node_t *node = NULL;
+        list_foreach(graph->vertices[u].edges, node) {
+            edge_t *edge = node_data(node);
+            sssp->in_offsets[dynamic_sssp_index(sssp, edge_pair_get(edge, &graph->vertices[u])) + 1]++;
+            ++nedges;
+        }
+    }
+
+    sssp->in_edges = malloc((nedges ? nedges : 1) * sizeof(edge_t *));
+    sssp->in_tails = malloc((nedges ? nedges : 1) * sizeof(int));
+    cursor = malloc((graph->size + 1) * sizeof(size_t));
+    if (NULL == sssp->in_edges || NULL == sssp->in_tails || NULL == cursor) {
+        free(cursor);
+        return -1;
+    }
+
+    for (u = 0; u < graph->size; ++u) {
+        sssp->in_offsets[u + 1] += sssp->in_offsets[u];
+    }
+    memcpy(cursor, sssp->in_offsets, (graph->size + 1) * sizeof(size_t));
+
+    for (u = 0; u < graph->size; ++u) {
+        node_t *node = NULL;
+        list_foreach(graph->vertices[u].edges, node) {
+            edge_t *edge = node_data(node);
+            size_t j = cursor[dynamic_sssp_index(sssp, edge_pair_get(edge, &graph->vertices[u]))]++;
+            sssp->in_edges[j] = edge;
+            sssp->in_tails[j] = u;
+        }
+    }
+
+    free(cursor);
+    return 0;
+}
+
+dynamic_sssp_t *
+dynamic_sssp_new(graph_t *graph, vertex_t *s)
+{
+    dynamic_sssp_t *sssp = calloc(1, sizeof(dynamic_sssp_t));
+    int size = graph->size;
+    long touched = 0;
+
+    if (NULL == sssp) {
+        return NULL;
+    }
+
+    sssp->graph = graph;
+    sssp->source = s - graph->vertices;
+    sssp->distance = malloc(size * sizeof(long));
+    sssp->parent = malloc(size * sizeof(int));
+    sssp->parent_edge = calloc(size, sizeof(edge_t *));
+    sssp->in_offsets = calloc(size + 1, sizeof(size_t));
+    sssp->affected = malloc(size * sizeof(int));
+    sssp->mark = calloc(size, sizeof(unsigned));
+    sssp->heap = dynamic_sssp_heap_new(0);
+
+    if (NULL == sssp->distance || NULL == sssp->parent || NULL == sssp->parent_edge ||
+        NULL == sssp->in_offsets || NULL == sssp->affected || NULL == sssp->mark ||
+        NULL == sssp->heap || 0 != dynamic_sssp_in_edges(sssp)) {
+        goto error;
+    }
+
+    for (size_t i = 0; i < sssp->in_offsets[size]; ++i) {
+        if (sssp->in_edges[i]->weight < 0) {
+            goto error;
+        }
+    }
+
+    for (int v = 0; v < size; ++v) {
+        sssp->distance[v] = LONG_MAX;
+        sssp->parent[v] = -1;
+    }
+
+    sssp->epoch = 1;
+    if (0 != dynamic_sssp_offer(sssp, sssp->source, -1, NULL, 0) ||
+        0 != dynamic_sssp_propagate(sssp, &touched)) {
+        goto error;
+    }
+
+    return sssp;
+
+error:
+    dynamic_sssp_free(sssp);
+    return NULL;
+}
+
+void
+dynamic_sssp_free(dynamic_sssp_t *sssp)
+{
+    if (NULL != sssp) {
+        free(sssp->distance);
+        free(sssp->parent);
+        free(sssp->parent_edge);
+        free(sssp->in_offsets);
+        free(sssp->in_edges);
+        free(sssp->in_tails);
+        free(sssp->affected);
+        free(sssp->mark);
+        if (NULL != sssp->heap) {
+            dynamic_sssp_heap_free(sssp->heap);
+        }
+        free(sssp);
+    }
+}
+
+long
+dynamic_sssp_update(dynamic_sssp_t *sssp, const weight_update_t *updates, size_t nupdates)
+{
+    long touched = 0;
+    int naffected = 0;
+    int arcs[2][2];
+    size_t k;
+
+    for (k = 0; k < nupdates; ++k) {
+        if (updates[k].weight < 0) {
+            return -1;
+        }
+    }
+    for (k = 0; k < nupdates; ++k) {
+        updates[k].edge->weight = updates[k].weight;
+    }
+
+    if (0 == ++sssp->epoch) {
+        memset(sssp->mark, 0, sssp->graph->size * sizeof(unsigned));
+        sssp->epoch = 1;
+    }
+
+    /**
+     * Tree edges no longer tight got heavier: their subtrees lose their
+     * distances.
+     */
+    for (k = 0; k < nupdates; ++k) {
+        edge_t *edge = updates[k].edge;
+        int n = dynamic_sssp_arcs(sssp, edge, arcs);
+
+        for (int a = 0; a < n; ++a) {
+            int u = arcs[a][0];
+            int v = arcs[a][1];
+
+            if (sssp->parent[v] == u && sssp->parent_edge[v] == edge &&
+                sssp->distance[u] + edge->weight > sssp->distance[v]) {
+                dynamic_sssp_invalidate(sssp, v, &naffected, &touched);
+            }
+        }
+    }
+
+    /**
+     * Invalidated vertices take the best incoming edge from vertices
+     * whose distance still holds.
+     */
+    for (int i = 0; i < naffected; ++i) {
+        int x = sssp->affected[i];
+        size_t best = 0;
+        long distance = LONG_MAX;
+
+        for (size_t j = sssp->in_offsets[x]; j < sssp->in_offsets[x + 1]; ++j) {
+            long du = sssp->distance[sssp->in_tails[j]];
+
+            if (LONG_MAX != du && du + sssp->in_edges[j]->weight < distance) {
+                distance = du + sssp->in_edges[j]->weight;
+                best = j;
+            }
+        }
+        if (LONG_MAX != distance &&
+            0 != dynamic_sssp_offer(sssp, x, sssp->in_tails[best], sssp->in_edges[best], distance)) {
+            return -1;
+        }
+    }
+
+    /**
+     * Edges that got lighter offer shorter distances to their heads.
+     */
+    for (k = 0; k < nupdates; ++k) {
+        edge_t *edge = updates[k].edge;
+        int n = dynamic_sssp_arcs(sssp, edge, arcs);
+
+        for (int a = 0; a < n; ++a) {
+            int u = arcs[a][0];
+            int v = arcs[a][1];
+
+            if (LONG_MAX != sssp->distance[u] &&
+                sssp->distance[u] + edge->weight < sssp->distance[v] &&
+                0 != dynamic_sssp_offer(sssp, v, u, edge, sssp->distance[u] + edge->weight)) {
+                return -1;
+            }
+        }
+    }
+
+    if (0 != dynamic_sssp_propagate(sssp, &touched)) {
+        return -1;
+    }
+
+    return touched;
+}
@@ -0,0 +1,74 @@
+#ifndef _DYNAMIC_SSSP__H_
+#define _DYNAMIC_SSSP__H_
+
+#include "includes.h"
+#include "graph.h"
+
+/**
+ * Single source shortest paths maintained under edge weight changes.
+ *
+ * Distances and the shortest path tree from s are computed once
+ * (Dijkstra), then every batch of weight changes only repairs the part
+ * of the tree they affect, in the spirit of Ramalingam and Reps:
+ *
+ *  - a tree edge getting heavier invalidates the subtree below it,
+ *    whose vertices get the best distance offered by an incoming edge
+ *    from outside the subtree;
+ *  - an edge getting lighter offers its head a shorter distance;
+ *
+ * and vertices whose distance improved are then propagated in Dijkstra
+ * order. Work is proportional to the vertices touched (and their edges),
+ * not to the size of the graph.
+ *
+ * Vertices and edges of the graph must not change, only weights through
+ * dynamic_sssp_update. Weights must be non-negative.
+ */
+
+typedef struct weight_update weight_update_t;
+
+struct weight_update {
+    edge_t *edge;
+    long weight;  /**< new weight */
+};
+
+typedef struct dynamic_sssp dynamic_sssp_t;
+
+struct dynamic_sssp {
+    graph_t *graph;
+    int source;
+    long *distance;        /**< LONG_MAX if unreachable */
+    int *parent;           /**< -1 for source and unreachable vertices */
+    edge_t **parent_edge;  /**< tree edge from parent */
+    size_t *in_offsets;    /**< incoming edges of v: in_edges[in_offsets[v] .. in_offsets[v + 1]) */
+    edge_t **in_edges;
+    int *in_tails;         /**< other endpoint of incoming edges */
+    int *affected;         /**< invalidated vertices of current update */
+    unsigned *mark;        /**< epoch at which vertices were last touched */
+    unsigned epoch;
+    struct dynamic_sssp_heap *heap;
+};
+
+/**
+ * Computes shortest paths from s and keeps them for updates.
+ *
+ * @return object or NULL on allocation failure or negative weights.
+ */
+dynamic_sssp_t *
+dynamic_sssp_new(graph_t *graph, vertex_t *s);
+
+void
+dynamic_sssp_free(dynamic_sssp_t *sssp);
+
+/**
+ * Sets weights of a batch of edges and repairs distances and tree.
+ *
+ * An edge might appear several times in the batch, last weight wins.
+ *
+ * @return number of distinct vertices touched (invalidated or settled
+ *         again), -1 if a weight is negative (nothing is changed) or on
+ *         allocation failure (distances are then left inconsistent).
+ */
+long
+dynamic_sssp_update(dynamic_sssp_t *sssp, const weight_update_t *updates, size_t nupdates);
+
+#endif /* _DYNAMIC_SSSP__H_ */
@@ -0,0 +1,380 @@
+#include "edge_list.h"
+#include "parallel.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef struct edge_list_block edge_list_block_t;
+
+/**
+ * Edges parsed by one thread.
+ */
+struct edge_list_block {
+    csr_edge_t *edges;
+    size_t nedges;
+    size_t capacity;
+    size_t offset;   /**< position of first edge in the final list */
+    int size;
+    bool error;
+};
+
+typedef struct edge_list_parse edge_list_parse_t;
+
+struct edge_list_parse {
+    const char *data;
+    size_t length;
+    edge_list_block_t *blocks;
+    csr_edge_t *edges;
+    size_t nedges;
+    bool error;
+    parallel_barrier_t barrier;
+};
+
+static inline bool
+edge_list_blank(char c)
+{
+    return ' ' == c || '\t' == c || '\r' == c;
+}
+
+static inline const char *
+edge_list_skip_blanks(const char *p, const char *end)
+{
+    while (p < end && edge_list_blank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+/**
+ * Returns position following next newline (or end).
+ */
+static inline const char *
+edge_list_skip_line(const char *p, const char *end)
+{
+    const char *newline = memchr(p, '\n', end - p);
+
+    return NULL == newline ? end : newline + 1;
+}
+
+/**
+ * Parses optionally signed decimal integer at p, blanks skipped.
+ *
+ * @return position following the integer, NULL if there is none or it
+ *         overflows.
+ */
+static inline const char *
+edge_list_parse_long(const char *p, const char *end, long *value)
+{
+    bool negative = false;
+    unsigned long x = 0;
+    const char *digits;
+
+    p = edge_list_skip_blanks(p, end);
+    if (p < end && ('-' == *p || '+' == *p)) {
+        negative = '-' == *p++;
+    }
+
+    for (digits = p; p < end && (unsigned)(*p - '0') < 10; ++p) {
+        unsigned d = *p - '0';
+        if (x > (LONG_MAX - d) / 10) {
+            return NULL;
+        }
+        x = 10 * x + d;
+    }
+    if (p == digits) {
+        return NULL;
+    }
+
+    *value = negative ? -(long)x : (long)x;
+    return p;
+}
+
+static inline bool
+edge_list_end_of_field(const char *p, const char *end)
+{
+    return p == end || '\n' == *p || edge_list_blank(*p);
+}
+
+static int
+edge_list_push(edge_list_block_t *block, long u, long v, long w)
+{
+    if (u < 0 || u >= INT_MAX || v < 0 || v >= INT_MAX) {
+        return -1;
+    }
+
+    if (block->nedges == block->capacity) {
+        size_t capacity = block->capacity < 1024 ? 1024 : 2 * block->capacity;
+        csr_edge_t *edges = realloc(block->edges, capacity * sizeof(csr_edge_t));
+
+        if (NULL == edges) {
+            return -1;
+        }
+        block->edges = edges;
+        block->capacity = capacity;
+    }
+
+    block->edges[block->nedges].source = u;
+    block->edges[block->nedges].target = v;
+    block->edges[block->nedges].weight = w;
+    block->nedges++;
+
+    if (u >= block->size) {
+        block->size = u + 1;
+    }
+    if (v >= block->size) {
+        block->size = v + 1;
+    }
+    return 0;
+}
+
+/**
+ * Parses lines starting in [p, end), last one possibly going past end up
+ * to limit.
+ */
+static int
+edge_list_parse_block(edge_list_block_t *block, const char *p, const char *end, const char *limit)
+{
+    while (p < end) {
+        bool dimacs = false;
+        long u, v, w = 1;
+
+        p = edge_list_skip_blanks(p, limit);
+        if (p == limit) {
+            break;
+        }
+
+        switch (*p) {
+        case '\n':
+            ++p;
+            continue;
+
+        case '#':
+        case '%':
+        case 'c':
+            p = edge_list_skip_line(p, limit);
+            continue;
+
+        case 'p':
+            /**
+             * p <problem> <n> <m>
+             */
+            p = edge_list_skip_blanks(p + 1, limit);
+            while (p < limit && !edge_list_end_of_field(p, limit)) {
+                ++p;
+            }
+            p = edge_list_parse_long(p, limit, &v);
+            if (NULL == p || v < 0 || v > INT_MAX) {
+                return -1;
+            }
+            if (v > block->size) {
+                block->size = v;
+            }
+            p = edge_list_skip_line(p, limit);
+            continue;
+
+        case 'a':
+            dimacs = true;
+            ++p;
+            break;
+
+        default:
+            break;
+        }
+
+        p = edge_list_parse_long(p, limit, &u);
+        if (NULL == p || !edge_list_end_of_field(p, limit)) {
+            return -1;
+        }
+        p = edge_list_parse_long(p, limit, &v);
+        if (NULL == p || !edge_list_end_of_field(p, limit)) {
+            return -1;
+        }
+        p = edge_list_skip_blanks(p, limit);
+        if (p < limit && '\n' != *p) {
+            p = edge_list_parse_long(p, limit, &w);
+            if (NULL == p || !edge_list_end_of_field(p, limit)) {
+                return -1;
+            }
+        }
+
+        if (dimacs) {
+            --u;
+            --v;
+        }
+        if (0 != edge_list_push(block, u, v, w)) {
+            return -1;
+        }
+
+        p = edge_list_skip_line(p, limit);
+    }
+
+    return 0;
+}
+
+/**
+ * Moves position forward to the start of a line.
+ */
+static size_t
+edge_list_line_start(const char *data, size_t length, size_t pos)
+{
+    const char *newline;
+
+    if (0 == pos || pos >= length || '\n' == data[pos - 1]) {
+        return pos < length ? pos : length;
+    }
+
+    newline = memchr(data + pos, '\n', length - pos);
+    return NULL == newline ? length : (size_t)(newline - data) + 1;
+}
+
+static void
+edge_list_parse_run(void *arg, int id, int nthreads)
+{
+    edge_list_parse_t *parse = arg;
+    edge_list_block_t *block = &parse->blocks[id];
+    size_t begin;
+    size_t end;
+
+    parallel_range(parse->length, id, nthreads, &begin, &end);
+    begin = edge_list_line_start(parse->data, parse->length, begin);
+    end = edge_list_line_start(parse->data, parse->length, end);
+
+    block->error = 0 != edge_list_parse_block(block, parse->data + begin, parse->data + end,
+                                              parse->data + parse->length);
+
+    if (parallel_barrier_wait(&parse->barrier, nthreads)) {
+        parse->nedges = 0;
+        parse->error = false;
+        for (int i = 0; i < nthreads; ++i) {
+            parse->blocks[i].offset = parse->nedges;
+            parse->nedges += parse->blocks[i].nedges;
+            parse->error = parse->error || parse->blocks[i].error;
+        }
+        if (!parse->error) {
+            parse->edges = malloc((parse->nedges ? parse->nedges : 1) * sizeof(csr_edge_t));
+            parse->error = NULL == parse->edges;
+        }
+    }
+    parallel_barrier_wait(&parse->barrier, nthreads);
+
+    if (!parse->error && block->nedges > 0) {
+        memcpy(parse->edges + block->offset, block->edges, block->nedges * sizeof(csr_edge_t));
+    }
+    free(block->edges);
+    block->edges = NULL;
+}
+
+static double
+edge_list_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int
+edge_list_load(edge_list_t *list, const char *filename, int nthreads)
+{
+    edge_list_parse_t parse;
+    double start = edge_list_now();
+    struct stat st;
+    void *data = NULL;
+    int fd;
+
+    memset(list, 0, sizeof(edge_list_t));
+    memset(&parse, 0, sizeof(edge_list_parse_t));
+
+    fd = open(filename, O_RDONLY);
+    if (-1 == fd) {
+        return -1;
+    }
+    if (0 != fstat(fd, &st)) {
+        close(fd);
+        return -1;
+    }
+
+    parse.length = st.st_size;
+    if (parse.length > 0) {
+        data = mmap(NULL, parse.length, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if (MAP_FAILED == data) {
+        return -1;
+    }
+    if (NULL != data) {
+        posix_madvise(data, parse.length, POSIX_MADV_SEQUENTIAL);
+    }
+
+    nthreads = parallel_threads(nthreads);
+    parse.data = data;
+    parse.blocks = calloc(nthreads, sizeof(edge_list_block_t));
+    parallel_barrier_init(&parse.barrier);
+
+    if (NULL == parse.blocks) {
+        parse.error = true;
+    }
+    else {
+        nthreads = parallel_run(nthreads, edge_list_parse_run, &parse);
+    }
+
+    if (NULL != data) {
+        munmap(data, parse.length);
+    }
+
+    if (!parse.error) {
+        list->edges = parse.edges;
+        list->nedges = parse.nedges;
+        for (int i = 0; i < nthreads; ++i) {
+            if (parse.blocks[i].size > list->size) {
+                list->size = parse.blocks[i].size;
+            }
+        }
+        list->bytes = parse.length;
+        list->seconds = edge_list_now() - start;
+    }
+    else {
+        free(parse.edges);
+    }
+    free(parse.blocks);
+
+    return parse.error ? -1 : 0;
+}
+
+void
+edge_list_free(edge_list_t *list)
+{
+    free(list->edges);
+    memset(list, 0, sizeof(edge_list_t));
+}
+
+graph_t *
+edge_list_graph(const edge_list_t *list, edge_flags_t flags)
+{
+    graph_t *graph = graph_new(list->size);
+
+    if (NULL == graph || (list->size > 0 && NULL == graph->vertices)) {
+        graph_free(graph);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < list->nedges; ++i) {
+        const csr_edge_t *e = &list->edges[i];
+        vertex_t *u = &graph->vertices[e->source];
+        vertex_t *v = &graph->vertices[e->target];
+        edge_t *edge = edge_new(u, v, flags);
+
+        if (NULL == edge) {
+            graph_free(graph);
+            return NULL;
+        }
+        edge->weight = e->weight;
+        vertex_edge_add(u, edge);
+        if (!(flags & EDGE_F_DIRECTED) && u != v) {
+            vertex_edge_add(v, edge);
+        }
+    }
+
+    return graph;
+}
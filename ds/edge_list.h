@@ -0,0 +1,77 @@
+#ifndef _EDGE_LIST__H_
+#define _EDGE_LIST__H_
+
+#include "csr_graph.h"
+
+/**
+ * Parallel loader of edge list text files.
+ *
+ * The file is mapped in memory and split in one block per thread, every
+ * block boundary being moved forward to the next line start. Threads
+ * parse lines of their block with a hand written tokenizer (no scanf,
+ * no copy of the text) into their own edge buffers, which are then
+ * concatenated in file order.
+ *
+ * Accepted lines, leading blanks aside:
+ *
+ *   u v [w]      SNAP style edge, vertices numbered from 0
+ *   a u v w      DIMACS arc, vertices numbered from 1
+ *   p sp n m     DIMACS problem line, n raises the number of vertices
+ *   # % c ...    comments, as well as empty lines
+ *
+ * Fields are separated by spaces or tabs and w defaults to 1. A third
+ * field of a SNAP line is always read as w, so for files whose third
+ * column is something else (timestamps of temporal graphs, ...) weights
+ * are meaningless and should be dropped by the caller. Anything after
+ * the fields of an edge, w included, is ignored.
+ */
+
+typedef struct edge_list edge_list_t;
+
+struct edge_list {
+    csr_edge_t *edges;
+    size_t nedges;
+    int size;        /**< largest vertex + 1, at least n of the problem line */
+    size_t bytes;    /**< length of the file */
+    double seconds;  /**< time taken by edge_list_load */
+};
+
+/**
+ * Loads edge list file on nthreads threads (<= 0 for number of online
+ * processors).
+ *
+ * Edges are in file order, whatever the number of threads.
+ *
+ * @param list object filled on success
+ * @return zero on success, -1 on I/O or allocation failure, or if a line
+ *         is malformed or holds a vertex out of int range.
+ */
+int
+edge_list_load(edge_list_t *list, const char *filename, int nthreads);
+
+void
+edge_list_free(edge_list_t *list);
+
+/**
+ * Returns parse throughput of edge_list_load in MB/s.
+ */
+static inline double
+edge_list_throughput(const edge_list_t *list)
+{
+    return list->seconds > 0 ? list->bytes / list->seconds / 1e6 : 0.0;
+}
+
+/**
+ * Builds list based graph from edge list.
+ *
+ * CSR graphs are built by csr_graph_build(list->size, list->edges,
+ * list->nedges, flags).
+ *
+ * @param flags EDGE_F_DIRECTED to add edges only to their source,
+ *        otherwise every edge is shared by both endpoints
+ * @return graph or NULL on allocation failure.
+ */
+graph_t *
+edge_list_graph(const edge_list_t *list, edge_flags_t flags);
+
+#endif /* _EDGE_LIST__H_ */
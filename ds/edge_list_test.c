@@ -0,0 +1,171 @@
+#include "includes.h"
+#include "edge_list.h"
+#include "parallel.h"
+
+static double
+now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void
+write_file(const char *filename, const char *text)
+{
+    FILE *f = fopen(filename, "w");
+    fputs(text, f);
+    fclose(f);
+}
+
+static bool
+edges_equal(const edge_list_t *list, const csr_edge_t *edges, size_t nedges)
+{
+    if (list->nedges != nedges) {
+        return false;
+    }
+    for (size_t i = 0; i < nedges; ++i) {
+        if (list->edges[i].source != edges[i].source ||
+            list->edges[i].target != edges[i].target ||
+            list->edges[i].weight != edges[i].weight) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks formats accepted, on every number of threads (blocks boundaries
+ * falling at every position of a small file).
+ */
+static void
+check_formats(const char *filename)
+{
+    const char *snap =
+        "# Directed graph\n"
+        "# FromNodeId\tToNodeId\n"
+        "0\t1\n"
+        "  1 2 7\n"
+        "\n"
+        "% comment\r\n"
+        "2 0 -3 1234567890\n"
+        "4\t3\t5\r\n"
+        "3 4";
+    const csr_edge_t snap_edges[] = { { 0, 1, 1 }, { 1, 2, 7 }, { 2, 0, -3 }, { 4, 3, 5 }, { 3, 4, 1 } };
+    const char *dimacs =
+        "c 9th DIMACS challenge\n"
+        "p sp 6 3\n"
+        "a 1 2 10\n"
+        "a 2 3 20\n"
+        "a 3 1 30\n";
+    const csr_edge_t dimacs_edges[] = { { 0, 1, 10 }, { 1, 2, 20 }, { 2, 0, 30 } };
+    const char *invalid[] = { "0 1\nx 2\n", "0\n", "0 1x\n", "-1 2\n", "0 99999999999\n" };
+    edge_list_t list;
+    bool ok = true;
+
+    for (int nthreads = 1; nthreads <= 64; nthreads *= 2) {
+        write_file(filename, snap);
+        ok = ok && 0 == edge_list_load(&list, filename, nthreads) && 5 == list.size &&
+            edges_equal(&list, snap_edges, countof(snap_edges));
+        edge_list_free(&list);
+
+        write_file(filename, dimacs);
+        ok = ok && 0 == edge_list_load(&list, filename, nthreads) && 6 == list.size &&
+            edges_equal(&list, dimacs_edges, countof(dimacs_edges));
+        edge_list_free(&list);
+
+        for (int i = 0; i < countof(invalid); ++i) {
+            write_file(filename, invalid[i]);
+            ok = ok && -1 == edge_list_load(&list, filename, nthreads) && NULL == list.edges;
+        }
+
+        write_file(filename, "");
+        ok = ok && 0 == edge_list_load(&list, filename, nthreads) && 0 == list.nedges && 0 == list.size;
+        edge_list_free(&list);
+    }
+
+    printf("edge list formats: %s\n", ok ? "ok" : "FAILED");
+}
+
+/**
+ * Compares parallel loader against fscanf on a random SNAP style file.
+ */
+static void
+bench(const char *filename, int size, size_t nedges)
+{
+    csr_edge_t *edges = malloc(nedges * sizeof(csr_edge_t));
+    int max_threads = parallel_threads(0);
+    FILE *f = fopen(filename, "w");
+    edge_list_t list;
+    csr_graph_t *csr;
+    graph_t *graph;
+    double start;
+    double elapsed;
+    size_t bytes;
+    size_t n = 0;
+    int u, v;
+    bool ok;
+
+    fprintf(f, "# random graph\n");
+    for (size_t i = 0; i < nedges; ++i) {
+        edges[i].source = rand() % size;
+        edges[i].target = rand() % size;
+        edges[i].weight = rand() % 1000;
+        fprintf(f, "%d\t%d\t%ld\n", edges[i].source, edges[i].target, edges[i].weight);
+    }
+    bytes = ftell(f);
+    fclose(f);
+
+    f = fopen(filename, "r");
+    start = now();
+    fscanf(f, "%*[^\n]\n");
+    while (2 == fscanf(f, "%d %d %*d", &u, &v)) {
+        ++n;
+    }
+    elapsed = now() - start;
+    fclose(f);
+    printf("fscanf %zu edges: %.3fs %.1f MB/s\n", n, elapsed, bytes / elapsed / 1e6);
+
+    for (int nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+        ok = 0 == edge_list_load(&list, filename, nthreads) && edges_equal(&list, edges, nedges);
+        printf("edge list %zu edges: %d threads %.3fs %.1f MB/s: %s\n",
+               list.nedges, nthreads, list.seconds, edge_list_throughput(&list), ok ? "ok" : "FAILED");
+        if (nthreads < max_threads) {
+            edge_list_free(&list);
+        }
+
+        if (nthreads < max_threads && 2 * nthreads > max_threads) {
+            nthreads = max_threads / 2;
+        }
+    }
+
+    start = now();
+    csr = csr_graph_build(list.size, list.edges, list.nedges, EDGE_F_DIRECTED);
+    printf("csr graph from edge list: %.3fs\n", now() - start);
+
+    start = now();
+    graph = edge_list_graph(&list, EDGE_F_DIRECTED);
+    printf("graph_t from edge list: %.3fs\n", now() - start);
+
+    graph_free(graph);
+    csr_graph_free(csr);
+    edge_list_free(&list);
+    free(edges);
+}
+
+int main(int argc, char **argv)
+{
+    int size = argc > 1 ? atoi(argv[1]) : 1 << 20;
+    char filename[] = "/tmp/edge_list_test.XXXXXX";
+    int fd = mkstemp(filename);
+
+    close(fd);
+    srand(1);
+
+    check_formats(filename);
+    bench(filename, size, 8 * (size_t)size);
+
+    unlink(filename);
+
+    return 0;
+}
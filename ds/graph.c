@@ -1,6 +1,32 @@
 #include "graph.h"
 #include "disjoint_sets.h"
+#include "rollback_disjoint_sets.h"
+#include "concurrent_disjoint_sets.h"
 #include "heap.h"
+#include "radix_heap.h"
+#include "pairing_heap.h"
+#include "parallel.h"
+#include <stdatomic.h>
+
+/**
+ * Arity of heaps used by graph algorithms: decrease-key heavy workloads
+ * favor shallow heaps (see heap_test).
+ */
+#define GRAPH_HEAP_ARITY 4
+
+/**
+ * Number of nodes pairing heaps allocate at once.
+ */
+#define GRAPH_PAIRING_POOL 1024
+
+/**
+ * Connected components (Afforest): neighbors of every vertex linked
+ * before looking for the largest component, number of vertices sampled
+ * to find it and number of vertices threads claim at once.
+ */
+#define GRAPH_COMPONENTS_ROUNDS  2
+#define GRAPH_COMPONENTS_SAMPLES 1024
+#define GRAPH_COMPONENTS_CHUNK   256
 
 int
 vertex_init(vertex_t *vertex)
@@ -105,7 +131,6 @@ graph_new(size_t size)
                     goto error;
                 }
                 graph->vertices[i].index = i;
-                graph->vertices[i].heap_index = i;
             }
         }
     }
@@ -148,19 +173,80 @@ graph_vertex_get(graph_t *graph, int i)
     return &graph->vertices[i];
 }
 
-bool
-graph_connected(graph_t *graph, vertex_t *u, vertex_t *v)
+graph_search_t *
+graph_search_new(int size)
+{
+    graph_search_t *search = calloc(1, sizeof(graph_search_t));
+
+    if (NULL != search) {
+        search->vertices = calloc(size, sizeof(search_vertex_t));
+        if (NULL == search->vertices) {
+            goto error;
+        }
+        search->size = size;
+        search->epoch = 1;
+    }
+    return search;
+
+error:
+    graph_search_free(search);
+    return NULL;
+}
+
+void
+graph_search_free(graph_search_t *search)
+{
+    if (NULL != search) {
+        free(search->vertices);
+        search->vertices = NULL;
+        free(search->queue);
+        search->queue = NULL;
+        free(search);
+    }
+}
+
+void
+graph_search_reset(graph_search_t *search)
+{
+    search->clock = 0;
+    if (0 == ++search->epoch) {
+        /**
+         * epoch wrapped around: some vertex might still carry
+         * a stamp equal to the new epoch.
+         */
+        memset(search->vertices, 0, search->size * sizeof(search_vertex_t));
+        search->epoch = 1;
+    }
+}
+
+int *
+graph_search_queue(graph_search_t *search)
+{
+    if (NULL == search->queue) {
+        search->queue = malloc((search->size ? search->size : 1) * sizeof(int));
+    }
+    return search->queue;
+}
+
+static search_vertex_t *
+search_vertex_get(graph_search_t *search, vertex_t *v)
+{
+    return graph_search_vertex(search, v->index);
+}
+
+static bool
+vertex_connected(graph_search_t *search, vertex_t *u, vertex_t *v)
 {
     node_t *node = NULL;
-    u->visited = 1;
+    search_vertex_get(search, u)->visited = 1;
     if (u == v) {
         return true;
     }
     list_foreach(u->edges, node) { 
         edge_t *edge = node_data(node);
         vertex_t *z = edge_pair_get(edge, u);
-        if (!z->visited) {
-            if (graph_connected(graph, z, v)) {
+        if (!search_vertex_get(search, z)->visited) {
+            if (vertex_connected(search, z, v)) {
                 return true;
             }
         }
@@ -168,77 +254,321 @@ graph_connected(graph_t *graph, vertex_t *u, vertex_t *v)
     return false; 
 }
 
-void
-vertex_visit(vertex_t *u)
+bool
+graph_connected(graph_t *graph, graph_search_t *search, vertex_t *u, vertex_t *v)
 {
-    node_t *node = NULL;
-    u->visited = 1;
-    list_foreach(u->edges, node) { 
-        edge_t *edge = node_data(node);
-        vertex_t *v = edge_pair_get(edge, u);
-        if (!v->visited) {
-            vertex_visit(v);
-        }
-    }
+    graph_search_reset(search);
+
+    return vertex_connected(search, u, v);
 }
 
 int
 graph_connected_count(graph_t *graph)
 {
-    int count = 0;
-    for (int i = 0; i < graph->size; ++i) {
-        if (!graph->vertices[i].visited) {
-            ++count;
-            vertex_visit(&graph->vertices[i]);
+    return graph_components(graph, 1, NULL, NULL);
+}
+
+typedef struct components components_t;
+
+/**
+ * State shared by threads computing connected components.
+ */
+struct components {
+    graph_t *graph;
+    const int *pairs;
+    size_t npairs;
+    int size;
+    concurrent_disjoint_sets_t *ds;
+    int *label;
+    atomic_size_t next;       /**< next vertex to be claimed */
+    int largest;              /**< representative of largest component sampled */
+    parallel_barrier_t barrier;
+};
+
+static int
+components_int_cmp(const void *o1, const void *o2)
+{
+    int i1 = *(const int *)o1;
+    int i2 = *(const int *)o2;
+
+    return i1 < i2 ? -1 : i1 > i2;
+}
+
+/**
+ * Samples representatives of random vertices and returns the most
+ * frequent one, probably representative of the largest component.
+ */
+static int
+components_sample(components_t *c)
+{
+    int samples[GRAPH_COMPONENTS_SAMPLES];
+    unsigned long long x = 0x9e3779b97f4a7c15ULL;
+    int largest = 0;
+    int best = 0;
+
+    for (int k = 0; k < GRAPH_COMPONENTS_SAMPLES; ++k) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        samples[k] = concurrent_disjoint_sets_find(c->ds, (int)(x % (unsigned long long)c->size));
+    }
+    qsort(samples, GRAPH_COMPONENTS_SAMPLES, sizeof(int), components_int_cmp);
+
+    for (int k = 0, j; k < GRAPH_COMPONENTS_SAMPLES; k = j) {
+        for (j = k; j < GRAPH_COMPONENTS_SAMPLES && samples[j] == samples[k]; ++j);
+        if (j - k > best) {
+            best = j - k;
+            largest = samples[k];
         }
     }
-    return count;
+    return largest;
 }
 
-static bool 
-check_cycle(vertex_t *u)
+/**
+ * Links u to its neighbors at positions [first, last) of its edge list.
+ *
+ * Once u is in the largest component, its undirected edges are skipped:
+ * each of them is in the edge list of its other endpoint as well, and is
+ * linked from there if that endpoint is not in the largest component.
+ */
+static void
+components_link(components_t *c, vertex_t *u, int first, int last, bool largest)
 {
     node_t *node = NULL;
-    u->visited = 1;
-    u->previsit = ++u->clock;
-    list_foreach(u->edges, node) { 
+    int k = 0;
+
+    list_foreach(u->edges, node) {
         edge_t *edge = node_data(node);
-        vertex_t *v = edge_pair_get(edge, u);
-        if (!v->visited) {
-            if (check_cycle(v)) {
-                return true;
+
+        if (k >= last) {
+            break;
+        }
+        if (k++ < first || (largest && !edge->directed)) {
+            continue;
+        }
+        concurrent_disjoint_sets_union(c->ds, u->index, edge_pair_get(edge, u)->index);
+    }
+}
+
+/**
+ * Afforest: every vertex is linked to its first few neighbors, which
+ * in most graphs already gathers most vertices in a single large
+ * component. Then only vertices out of the largest component link the
+ * rest of their neighbors.
+ */
+static void
+components_graph_worker(void *arg, int id, int nthreads)
+{
+    components_t *c = arg;
+    graph_t *graph = c->graph;
+    size_t first;
+
+    for (int round = 0; round <= GRAPH_COMPONENTS_ROUNDS; ++round) {
+        while ((first = atomic_fetch_add(&c->next, GRAPH_COMPONENTS_CHUNK)) < (size_t)graph->size) {
+            size_t last = first + GRAPH_COMPONENTS_CHUNK < (size_t)graph->size ? first + GRAPH_COMPONENTS_CHUNK : (size_t)graph->size;
+
+            for (size_t u = first; u < last; ++u) {
+                if (round < GRAPH_COMPONENTS_ROUNDS) {
+                    components_link(c, &graph->vertices[u], round, round + 1, false);
+                }
+                else {
+                    bool largest = concurrent_disjoint_sets_find(c->ds, u) == c->largest;
+                    components_link(c, &graph->vertices[u], GRAPH_COMPONENTS_ROUNDS, INT_MAX, largest);
+                }
             }
         }
-        else {
-            if (0 == v->postvisit) {
-                return true;
+
+        if (parallel_barrier_wait(&c->barrier, nthreads)) {
+            atomic_store(&c->next, 0);
+            if (GRAPH_COMPONENTS_ROUNDS - 1 == round) {
+                c->largest = components_sample(c);
             }
         }
+        parallel_barrier_wait(&c->barrier, nthreads);
     }
-    u->postvisit = ++u->clock;
-    return false;
 }
 
+static void
+components_edges_worker(void *arg, int id, int nthreads)
+{
+    components_t *c = arg;
+    size_t begin, end;
+
+    parallel_range(c->npairs, id, nthreads, &begin, &end);
+    for (size_t k = begin; k < end; ++k) {
+        concurrent_disjoint_sets_union(c->ds, c->pairs[2 * k], c->pairs[2 * k + 1]);
+    }
+}
+
+static void
+components_find_worker(void *arg, int id, int nthreads)
+{
+    components_t *c = arg;
+    size_t begin, end;
+
+    parallel_range(c->size, id, nthreads, &begin, &end);
+    for (size_t v = begin; v < end; ++v) {
+        c->label[v] = concurrent_disjoint_sets_find(c->ds, v);
+    }
+}
+
+/**
+ * Turns sets of c->ds into component labels and sizes.
+ *
+ * Representative of every set is its smallest vertex, so components are
+ * numbered in order of their smallest vertex, and labels of vertices
+ * are relabeled in increasing order with the label of their
+ * representative already known.
+ */
+static int
+components_label(components_t *c, int nthreads, int *sizes)
+{
+    int count = 0;
+
+    if (NULL == c->label) {
+        for (int v = 0; v < c->size; ++v) {
+            count += concurrent_disjoint_sets_find(c->ds, v) == v;
+        }
+        return count;
+    }
+
+    parallel_run(nthreads, components_find_worker, c);
+
+    for (int v = 0; v < c->size; ++v) {
+        c->label[v] = c->label[v] == v ? count++ : c->label[c->label[v]];
+    }
+    if (NULL != sizes) {
+        memset(sizes, 0, count * sizeof(int));
+        for (int v = 0; v < c->size; ++v) {
+            sizes[c->label[v]]++;
+        }
+    }
+    return count;
+}
+
+int
+graph_components(graph_t *graph, int nthreads, int *label, int *sizes)
+{
+    components_t c = { .graph = graph, .size = graph->size, .label = label };
+    int count;
+
+    nthreads = parallel_threads(nthreads);
+
+    c.ds = concurrent_disjoint_sets_new(graph->size);
+    if (NULL == c.ds) {
+        return -1;
+    }
+    concurrent_disjoint_sets_make_set(c.ds);
+    atomic_init(&c.next, 0);
+    parallel_barrier_init(&c.barrier);
+
+    if (graph->size > 0) {
+        parallel_run(nthreads, components_graph_worker, &c);
+    }
+    count = components_label(&c, nthreads, sizes);
+
+    concurrent_disjoint_sets_free(c.ds);
+    return count;
+}
+
+int
+graph_components_edges(int size, const int *pairs, size_t npairs, int nthreads, int *label, int *sizes)
+{
+    components_t c = { .pairs = pairs, .npairs = npairs, .size = size, .label = label };
+    int count;
+
+    nthreads = parallel_threads(nthreads);
+
+    c.ds = concurrent_disjoint_sets_new(size);
+    if (NULL == c.ds) {
+        return -1;
+    }
+    concurrent_disjoint_sets_make_set(c.ds);
+
+    parallel_run(nthreads, components_edges_worker, &c);
+    count = components_label(&c, nthreads, sizes);
+
+    concurrent_disjoint_sets_free(c.ds);
+    return count;
+}
+
+typedef struct cycle_frame cycle_frame_t;
+
+/**
+ * Vertex on the dfs path and next node of its adjacency list to follow.
+ */
+struct cycle_frame {
+    vertex_t *u;
+    node_t *node;
+};
+
 bool
-graph_contains_cycle(graph_t *graph)
+graph_contains_cycle(graph_t *graph, graph_search_t *search)
 {
-    for (int i = 0; i < graph->size; ++i) {
-        if (!graph->vertices[i].visited) {
-            if (check_cycle(&graph->vertices[i])) {
-                return true;
+    cycle_frame_t *stack = malloc((graph->size ? graph->size : 1) * sizeof(cycle_frame_t));
+    bool cycle = false;
+
+    if (NULL == stack) {
+        return false;
+    }
+
+    graph_search_reset(search);
+
+    for (int i = 0; i < graph->size && !cycle; ++i) {
+        search_vertex_t *su = graph_search_vertex(search, i);
+        int top = 0;
+
+        if (su->visited) {
+            continue;
+        }
+
+        su->visited = 1;
+        su->previsit = ++search->clock;
+        stack[top].u = &graph->vertices[i];
+        stack[top++].node = list_head(graph->vertices[i].edges);
+
+        while (top > 0) {
+            cycle_frame_t *frame = &stack[top - 1];
+            search_vertex_t *sv = NULL;
+            vertex_t *v = NULL;
+
+            if (NULL == frame->node) {
+                search_vertex_get(search, frame->u)->postvisit = ++search->clock;
+                --top;
+                continue;
+            }
+
+            v = edge_pair_get(node_data(frame->node), frame->u);
+            frame->node = list_next(frame->u->edges, frame->node);
+            sv = search_vertex_get(search, v);
+
+            if (!sv->visited) {
+                sv->visited = 1;
+                sv->previsit = ++search->clock;
+                stack[top].u = v;
+                stack[top++].node = list_head(v->edges);
+            }
+            else if (0 == sv->postvisit) {
+                cycle = true;
+                break;
             }
         }
     }
-    return false;
+
+    free(stack);
+    return cycle;
 }
 
 int
-graph_distance(graph_t *graph, vertex_t *v, vertex_t *u)
+graph_distance(graph_t *graph, graph_search_t *search, vertex_t *v, vertex_t *u)
 {
-    for (int i = 0; i < graph->size; ++i) { 
-        graph->vertices[i].visited = 0;
-        graph->vertices[i].distance = 0;
-    }
+    search_vertex_t *sv = NULL;
+
+    graph_search_reset(search);
+
+    sv = search_vertex_get(search, v);
+    sv->visited = 1;
+    sv->distance = 0;
 
     list_t *list = list_new();
 
@@ -246,18 +576,22 @@ graph_distance(graph_t *graph, vertex_t *v, vertex_t *u)
 
     while ((v = list_pop_front(list))) {
 
+        sv = search_vertex_get(search, v);
+
         if (v == u) {
             list_free(list);
-            return v->distance;
+            return sv->distance;
         }
 
         node_t *node;
         list_foreach(v->edges, node) { 
             edge_t *edge = node_data(node);
             vertex_t *z = edge_pair_get(edge, v);
-            if (!z->visited) {
-                z->visited = 1;
-                z->distance = v->distance + 1;
+            search_vertex_t *sz = search_vertex_get(search, z);
+            if (!sz->visited) {
+                sz->visited = 1;
+                sz->distance = sv->distance + 1;
+                sz->parent = v->index;
                 list_push_back(list, z);
             }
         }
@@ -269,14 +603,11 @@ graph_distance(graph_t *graph, vertex_t *v, vertex_t *u)
 }
 
 bool
-graph_is_bipartite(graph_t *graph)
+graph_is_bipartite(graph_t *graph, graph_search_t *search)
 {
     vertex_t *v = NULL;
 
-    for (int i = 0; i < graph->size; ++i) { 
-        graph->vertices[i].visited = 0;
-        graph->vertices[i].color = WHITE;
-    }
+    graph_search_reset(search);
 
     list_t *list = list_new();
 
@@ -284,17 +615,20 @@ graph_is_bipartite(graph_t *graph)
 
     while ((v = list_pop_front(list))) {
 
+        search_vertex_t *sv = search_vertex_get(search, v);
+
         node_t *node;
         list_foreach(v->edges, node) { 
             edge_t *edge = node_data(node);
             vertex_t *u = edge_pair_get(edge, v);
-            if (!u->visited) {
-                u->visited = 1;
-                u->color = v->color == WHITE ? BLACK : WHITE;
+            search_vertex_t *su = search_vertex_get(search, u);
+            if (!su->visited) {
+                su->visited = 1;
+                su->color = sv->color == WHITE ? BLACK : WHITE;
                 list_push_back(list, u);
             }
             else {
-                if (u->color == v->color) {
+                if (su->color == sv->color) {
                     list_free(list);
                     return false;
                 }
@@ -310,8 +644,8 @@ graph_is_bipartite(graph_t *graph)
 static bool
 vertex_cmp(const void *o1, const void *o2)
 {
-    const vertex_t *const *v1 = o1;
-    const vertex_t *const *v2 = o2;
+    const search_vertex_t *const *v1 = o1;
+    const search_vertex_t *const *v2 = o2;
 
     return (*v1)->distance <= (*v2)->distance;
 }
@@ -319,219 +653,511 @@ vertex_cmp(const void *o1, const void *o2)
 static void
 vertex_update(void *o, size_t heap_index)
 {
-    vertex_t *const *v = o;
+    search_vertex_t *const *v = o;
 
     (*v)->heap_index = heap_index; 
 }
 
 static
-bool vertex_relax(vertex_t *u, edge_t *edge)
+bool vertex_relax(graph_search_t *search, vertex_t *u, edge_t *edge)
 {
-    if (u->distance < LONG_MAX) {
+    search_vertex_t *su = search_vertex_get(search, u);
+
+    if (su->distance < LONG_MAX) {
         vertex_t *v = edge_pair_get(edge, u);
-        if (v->distance > u->distance + (long)edge->weight) {
-            v->distance = u->distance + (long)edge->weight;
-            v->parent = u;
+        search_vertex_t *sv = search_vertex_get(search, v);
+        if (sv->distance > su->distance + (long)edge->weight) {
+            sv->distance = su->distance + (long)edge->weight;
+            sv->parent = u->index;
             return true;
         }
     }
     return false;
 }
 
-int
-graph_dijkstra_distance(graph_t *graph, vertex_t *u, vertex_t *v)
+/**
+ * Dijkstra from s, stops as soon as t is settled.
+ *
+ * Vertices are inserted into the heap only when first reached, so
+ * a query costs time proportional to the part of the graph it
+ * explores. Returns distance from s to t, LONG_MAX if unreachable.
+ */
+static long
+dijkstra(graph_t *graph, graph_search_t *search, vertex_t *s, vertex_t *t)
 {
-    heap_t *h = NULL;
+    long distance = LONG_MAX;
+    search_vertex_t *su = NULL;
+    heap_t *h = heap_new(0, sizeof(search_vertex_t *), GRAPH_HEAP_ARITY, vertex_cmp, NULL, vertex_update);
 
-    vertex_t **vertices = malloc(graph->size * sizeof(vertex_t *));
+    if (NULL == h) {
+        return LONG_MAX;
+    }
 
-    for (int i = 0; i < graph->size; ++i) { 
-        graph->vertices[i].visited = 0;
-        graph->vertices[i].distance = LONG_MAX;
-        vertices[i] = &graph->vertices[i];
+    graph_search_reset(search);
+
+    su = search_vertex_get(search, s);
+    su->distance = 0;
+    if (0 != heap_insert(h, &su)) {
+        goto out;
     }
 
-    u->distance = 0;
+    while (NULL != heap_pop_front(h, &su)) {
 
-    h = heap_build(vertices, graph->size, sizeof(vertex_t *), vertex_cmp, NULL, vertex_update);
+        vertex_t *u = &graph->vertices[graph_search_index(search, su)];
 
-    while (NULL != heap_top(h)) {
-        heap_pop_front(h, &u);
+        su->visited = 1;
 
-        if (u == v) {
-            free(vertices);
-            if (LONG_MAX == u->distance) {
-                return -1;
-            }
-            return u->distance;
+        if (u == t) {
+            distance = su->distance;
+            break;
         }
 
         node_t *node;
         list_foreach(u->edges, node) {
             edge_t *edge = node_data(node);
-            if (vertex_relax(u, edge)) {
-                vertex_t *z = edge_pair_get(edge, u);
-                heap_update(h, z->heap_index);
+            vertex_t *z = edge_pair_get(edge, u);
+            search_vertex_t *sz = search_vertex_get(search, z);
+            bool discovered = LONG_MAX != sz->distance;
+            if (!sz->visited && vertex_relax(search, u, edge)) {
+                if (discovered) {
+                    heap_update(h, sz->heap_index);
+                }
+                else if (0 != heap_insert(h, &sz)) {
+                    goto out;
+                }
             }
         }
     }
 
+out:
     heap_free(h);
 
-    return -1;   
+    return distance;
 }
 
-bool
-graph_negative_cycle(graph_t *graph)
+int
+graph_dijkstra_distance(graph_t *graph, graph_search_t *search, vertex_t *u, vertex_t *v)
 {
-    for (int i = 0; i < graph->size; ++i) { 
-        graph->vertices[i].visited = 0;
-        graph->vertices[i].color = WHITE;
-        graph->vertices[i].distance = LONG_MAX;
-        graph->vertices[i].parent = NULL;
-    }
+    long distance = dijkstra(graph, search, u, v);
 
-    graph->vertices[0].distance = 0;
-   
-    for (int j = 0; j < graph->size; ++j) {
-        bool relaxed = false;
-        for (int i = 0; i < graph->size; ++i) {
-            vertex_t *u = &graph->vertices[i];
-            node_t *node;
-            if (LONG_MAX == u->distance) {
-                u->distance = 0;
-            }
-            list_foreach(u->edges, node) {
-                edge_t *edge = node_data(node);
-                if (vertex_relax(u, edge)) {
-                    relaxed = true;
-                }
-            }
-        }
-        if (!relaxed) {
-            return false;
-        }
-        if (j == graph->size - 1) {
-            return true;
-        }
+    if (LONG_MAX == distance) {
+        return -1;
     }
-    return false;
+    return distance;
 }
 
-void
-graph_shortest_paths(graph_t *graph, vertex_t *s)
+static bool
+pairing_vertex_cmp(const void *o1, const void *o2)
 {
-    bool negative_cycle = false;
-    list_t *cycle = list_new();
+    const search_vertex_t *v1 = o1;
+    const search_vertex_t *v2 = o2;
 
+    return v1->distance <= v2->distance;
+}
 
-    for (int i = 0; i < graph->size; ++i) { 
-        graph->vertices[i].visited = 0;
-        graph->vertices[i].color = WHITE;
-        graph->vertices[i].distance = LONG_MAX;
-        graph->vertices[i].parent = NULL;
+/**
+ * Same as dijkstra, on a pairing heap.
+ */
+static long
+pairing_dijkstra(graph_t *graph, graph_search_t *search, vertex_t *s, vertex_t *t)
+{
+    long distance = LONG_MAX;
+    search_vertex_t *su = NULL;
+    pairing_heap_t *h = pairing_heap_new(pairing_vertex_cmp, GRAPH_PAIRING_POOL);
+
+    if (NULL == h) {
+        return LONG_MAX;
     }
 
-    s->distance = 0;
-   
-    for (int j = 0; j < graph->size; ++j) {
-        bool relaxed = false;
-        for (int i = 0; i < graph->size; ++i) {
-            vertex_t *u = &graph->vertices[i];
-            node_t *node;
-            if (u->distance != LONG_MAX) {
-                list_foreach(u->edges, node) {
-                    edge_t *edge = node_data(node);
-                    if (vertex_relax(u, edge)) {
-                        relaxed = true;
-                        if (j == graph->size - 1) {
-                            list_push_back(cycle, edge_pair_get(edge, u));
-                        }
-                    }
-                }
-            }
-        }
-        if (!relaxed) {
+    graph_search_reset(search);
+
+    su = search_vertex_get(search, s);
+    su->distance = 0;
+    su->heap_node = pairing_heap_insert(h, su);
+    if (NULL == su->heap_node) {
+        goto out;
+    }
+
+    while (NULL != (su = pairing_heap_pop_front(h))) {
+
+        vertex_t *u = &graph->vertices[graph_search_index(search, su)];
+
+        su->visited = 1;
+
+        if (u == t) {
+            distance = su->distance;
             break;
         }
-        if (j == graph->size - 1) {
-            negative_cycle = true;
-        }
-    }
 
-    if (negative_cycle) {
-        vertex_t *v;
-        while ((v = list_pop_front(cycle))) {
-            if (!v->visited) {
-                node_t *node;
-                v->visited = 1;
-                v->distance = LONG_MIN;
-                list_foreach(v->edges, node) {
-                    edge_t *edge = node_data(node);
-                    list_push_back(cycle, edge_pair_get(edge, v));
+        node_t *node;
+        list_foreach(u->edges, node) {
+            edge_t *edge = node_data(node);
+            vertex_t *z = edge_pair_get(edge, u);
+            search_vertex_t *sz = search_vertex_get(search, z);
+            bool discovered = LONG_MAX != sz->distance;
+            if (!sz->visited && vertex_relax(search, u, edge)) {
+                if (discovered) {
+                    pairing_heap_decrease(h, sz->heap_node);
+                }
+                else {
+                    sz->heap_node = pairing_heap_insert(h, sz);
+                    if (NULL == sz->heap_node) {
+                        goto out;
+                    }
                 }
             }
         }
     }
 
-    list_free(cycle);
+out:
+    pairing_heap_free(h);
+
+    return distance;
 }
 
-static bool
-mst_cost_cmp(const void *o1, const void *o2)
+int
+graph_pairing_dijkstra_distance(graph_t *graph, graph_search_t *search, vertex_t *s, vertex_t *t)
 {
-    const vertex_t *const *v1 = o1;
-    const vertex_t *const *v2 = o2;
+    long distance = pairing_dijkstra(graph, search, s, t);
 
-    return (*v1)->cost <= (*v2)->cost;
+    if (LONG_MAX == distance) {
+        return -1;
+    }
+    return distance;
 }
 
-double
-graph_mst_prim_cost(graph_t *graph)
+static void
+radix_vertex_update(void *o, size_t handle)
 {
-    double cost = 0.0;
-    heap_t *h = NULL;
-    vertex_t **vertices = malloc(graph->size * sizeof(vertex_t *));
+    search_vertex_t *v = o;
+    v->heap_index = handle;
+}
 
-    for (int i = 0; i < graph->size; ++i) { 
-        graph->vertices[i].visited = 0;
-        graph->vertices[i].color = WHITE;
-        graph->vertices[i].distance = LONG_MAX;
-        graph->vertices[i].parent = NULL;
-        graph->vertices[i].cost = DBL_MAX;
-        vertices[i] = &graph->vertices[i];
+/**
+ * Same as dijkstra, on a radix heap: distances of vertices settled never
+ * decrease with non-negative weights, so keys are monotone.
+ */
+static long
+radix_dijkstra(graph_t *graph, graph_search_t *search, vertex_t *s, vertex_t *t)
+{
+    long distance = LONG_MAX;
+    search_vertex_t *su = NULL;
+    radix_heap_t *h = radix_heap_new(radix_vertex_update);
+
+    if (NULL == h) {
+        return LONG_MAX;
     }
 
-    vertex_t *u = &graph->vertices[0];
+    graph_search_reset(search);
+
+    su = search_vertex_get(search, s);
+    su->distance = 0;
+    if (0 != radix_heap_insert(h, 0, su)) {
+        goto out;
+    }
 
-    u->cost = 0.0;
+    while (NULL != (su = radix_heap_pop_front(h, NULL))) {
 
-    h = heap_build(vertices, graph->size, sizeof(vertex_t *), mst_cost_cmp, NULL, vertex_update);
+        vertex_t *u = &graph->vertices[graph_search_index(search, su)];
 
-    while (NULL != heap_top(h)) {
-        heap_pop_front(h, &u);
+        su->visited = 1;
 
-        u->visited = 1;
+        if (u == t) {
+            distance = su->distance;
+            break;
+        }
 
         node_t *node;
         list_foreach(u->edges, node) {
             edge_t *edge = node_data(node);
-            vertex_t *v = edge_pair_get(edge, u);
-            if (!v->visited) {
-                if (v->cost > edge->weight) {
-                    v->cost = edge->weight;
-                    v->parent = u;
-                    heap_update(h, v->heap_index);
+            vertex_t *z = edge_pair_get(edge, u);
+            search_vertex_t *sz = search_vertex_get(search, z);
+            bool discovered = LONG_MAX != sz->distance;
+            if (!sz->visited && vertex_relax(search, u, edge)) {
+                if (discovered) {
+                    if (0 != radix_heap_decrease(h, sz->heap_index, sz->distance)) {
+                        goto out;
+                    }
+                }
+                else if (0 != radix_heap_insert(h, sz->distance, sz)) {
+                    goto out;
                 }
             }
         }
     }
 
-    heap_free(h);
+out:
+    radix_heap_free(h);
 
-    for (int i = 0; i < graph->size; ++i) {
-        cost += graph->vertices[i].cost;
-    }
+    return distance;
+}
+
+int
+graph_radix_dijkstra_distance(graph_t *graph, graph_search_t *search, vertex_t *s, vertex_t *t)
+{
+    long distance = radix_dijkstra(graph, search, s, t);
+
+    if (LONG_MAX == distance) {
+        return -1;
+    }
+    return distance;
+}
+
+int
+graph_path(graph_t *graph, graph_search_t *search, vertex_t *t, list_t *path)
+{
+    node_t *next = NULL;
+    int count = 0;
+    int i = t->index;
+
+    if (LONG_MAX == graph_search_vertex(search, i)->distance) {
+        return -1;
+    }
+
+    /**
+     * Vertices come from t back to the root, each one inserted before
+     * the previous one, after vertices already in path.
+     */
+    while (i >= 0) {
+        list_push_before(path, next, &graph->vertices[i]);
+        next = NULL == next ? list_tail(path) : list_previous(path, next);
+        i = graph_search_vertex(search, i)->parent;
+        ++count;
+    }
+
+    return count;
+}
+
+long
+graph_dijkstra_path(graph_t *graph, graph_search_t *search, vertex_t *s, vertex_t *t, list_t *path)
+{
+    long distance = dijkstra(graph, search, s, t);
+
+    if (LONG_MAX == distance) {
+        return -1;
+    }
+
+    if (NULL != path) {
+        graph_path(graph, search, t, path);
+    }
+
+    return distance;
+}
+
+bool
+graph_negative_cycle(graph_t *graph, graph_search_t *search)
+{
+    graph_search_reset(search);
+
+    graph_search_vertex(search, 0)->distance = 0;
+   
+    for (int j = 0; j < graph->size; ++j) {
+        bool relaxed = false;
+        for (int i = 0; i < graph->size; ++i) {
+            vertex_t *u = &graph->vertices[i];
+            search_vertex_t *su = search_vertex_get(search, u);
+            node_t *node;
+            if (LONG_MAX == su->distance) {
+                su->distance = 0;
+            }
+            list_foreach(u->edges, node) {
+                edge_t *edge = node_data(node);
+                if (vertex_relax(search, u, edge)) {
+                    relaxed = true;
+                }
+            }
+        }
+        if (!relaxed) {
+            return false;
+        }
+        if (j == graph->size - 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+graph_shortest_paths(graph_t *graph, graph_search_t *search, vertex_t *s)
+{
+    bool negative_cycle = false;
+    list_t *cycle = list_new();
+
+    graph_search_reset(search);
+
+    search_vertex_get(search, s)->distance = 0;
+   
+    for (int j = 0; j < graph->size; ++j) {
+        bool relaxed = false;
+        for (int i = 0; i < graph->size; ++i) {
+            vertex_t *u = &graph->vertices[i];
+            node_t *node;
+            if (graph_search_vertex(search, i)->distance != LONG_MAX) {
+                list_foreach(u->edges, node) {
+                    edge_t *edge = node_data(node);
+                    if (vertex_relax(search, u, edge)) {
+                        relaxed = true;
+                        if (j == graph->size - 1) {
+                            list_push_back(cycle, edge_pair_get(edge, u));
+                        }
+                    }
+                }
+            }
+        }
+        if (!relaxed) {
+            break;
+        }
+        if (j == graph->size - 1) {
+            negative_cycle = true;
+        }
+    }
+
+    if (negative_cycle) {
+        vertex_t *v;
+        while ((v = list_pop_front(cycle))) {
+            search_vertex_t *sv = search_vertex_get(search, v);
+            if (!sv->visited) {
+                node_t *node;
+                sv->visited = 1;
+                sv->distance = LONG_MIN;
+                list_foreach(v->edges, node) {
+                    edge_t *edge = node_data(node);
+                    list_push_back(cycle, edge_pair_get(edge, v));
+                }
+            }
+        }
+    }
+
+    list_free(cycle);
+}
+
+static bool
+mst_cost_cmp(const void *o1, const void *o2)
+{
+    const search_vertex_t *const *v1 = o1;
+    const search_vertex_t *const *v2 = o2;
+
+    return (*v1)->cost <= (*v2)->cost;
+}
+
+double
+graph_mst_prim_cost(graph_t *graph, graph_search_t *search)
+{
+    double cost = 0.0;
+    heap_t *h = NULL;
+    search_vertex_t *su = NULL;
+    search_vertex_t **vertices = malloc((graph->size ? graph->size : 1) * sizeof(search_vertex_t *));
+
+    if (NULL == vertices) {
+        return NAN;
+    }
+
+    graph_search_reset(search);
+
+    for (int i = 0; i < graph->size; ++i) { 
+        vertices[i] = graph_search_vertex(search, i);
+    }
+
+    if (graph->size > 0) {
+        vertices[0]->cost = 0.0;
+    }
+
+    /** on success the heap owns vertices */
+    h = heap_build(vertices, graph->size, sizeof(search_vertex_t *), GRAPH_HEAP_ARITY, mst_cost_cmp, NULL, vertex_update);
+    if (NULL == h) {
+        free(vertices);
+        return NAN;
+    }
+
+    while (NULL != heap_top(h)) {
+        heap_pop_front(h, &su);
+
+        su->visited = 1;
+
+        vertex_t *u = &graph->vertices[graph_search_index(search, su)];
+
+        node_t *node;
+        list_foreach(u->edges, node) {
+            edge_t *edge = node_data(node);
+            vertex_t *v = edge_pair_get(edge, u);
+            search_vertex_t *sv = search_vertex_get(search, v);
+            if (!sv->visited) {
+                if (sv->cost > edge->weight) {
+                    sv->cost = edge->weight;
+                    sv->parent = u->index;
+                    heap_update(h, sv->heap_index);
+                }
+            }
+        }
+    }
+
+    heap_free(h);
+
+    for (int i = 0; i < graph->size; ++i) {
+        cost += graph_search_vertex(search, i)->cost;
+    }
+
+    return cost;
+}
+
+static bool
+pairing_cost_cmp(const void *o1, const void *o2)
+{
+    const search_vertex_t *v1 = o1;
+    const search_vertex_t *v2 = o2;
+
+    return v1->cost <= v2->cost;
+}
+
+double
+graph_pairing_mst_prim_cost(graph_t *graph, graph_search_t *search)
+{
+    double cost = 0.0;
+    search_vertex_t *su = NULL;
+    pairing_heap_t *h = pairing_heap_new(pairing_cost_cmp, graph->size > 0 ? graph->size : 1);
+
+    if (NULL == h) {
+        return NAN;
+    }
+
+    graph_search_reset(search);
+
+    for (int i = 0; i < graph->size; ++i) {
+        su = graph_search_vertex(search, i);
+        su->cost = 0 == i ? 0.0 : DBL_MAX;
+        su->heap_node = pairing_heap_insert(h, su);
+        if (NULL == su->heap_node) {
+            pairing_heap_free(h);
+            return NAN;
+        }
+    }
+
+    while (NULL != (su = pairing_heap_pop_front(h))) {
+
+        su->visited = 1;
+
+        vertex_t *u = &graph->vertices[graph_search_index(search, su)];
+
+        node_t *node;
+        list_foreach(u->edges, node) {
+            edge_t *edge = node_data(node);
+            vertex_t *v = edge_pair_get(edge, u);
+            search_vertex_t *sv = search_vertex_get(search, v);
+            if (!sv->visited) {
+                if (sv->cost > edge->weight) {
+                    sv->cost = edge->weight;
+                    sv->parent = u->index;
+                    pairing_heap_decrease(h, sv->heap_node);
+                }
+            }
+        }
+    }
+
+    pairing_heap_free(h);
+
+    for (int i = 0; i < graph->size; ++i) {
+        cost += graph_search_vertex(search, i)->cost;
+    }
 
     return cost;
 }
@@ -550,10 +1176,6 @@ graph_max_distance_k_cluster(vertex_t *vertices, size_t nvertices, edge_t **edge
 {
     int i;
 
-    for (i = 0; i < nvertices; ++i) {
-        vertices[i].heap_index = i;
-    }
-
     disjoint_sets_t *ds = disjoint_sets_new(nvertices);
 
     disjoint_sets_make_set(ds);
@@ -561,12 +1183,12 @@ graph_max_distance_k_cluster(vertex_t *vertices, size_t nvertices, edge_t **edge
     heap_sort(edges, nedges, sizeof(edge_t *), edge_cmp);
 
     for (i = 0; i < nedges; ++i) {
-        vertex_t *u = edges[i]->endpoint1;
-        vertex_t *v = edges[i]->endpoint2;
+        int u = edges[i]->endpoint1 - vertices;
+        int v = edges[i]->endpoint2 - vertices;
 
-        if (disjoint_sets_find(ds, u->heap_index) != disjoint_sets_find(ds, v->heap_index)) {
+        if (disjoint_sets_find(ds, u) != disjoint_sets_find(ds, v)) {
             if (nvertices > k) {
-                disjoint_sets_union(ds, u->heap_index, v->heap_index);
+                disjoint_sets_union(ds, u, v);
                 --nvertices;
             }
             else {
@@ -580,6 +1202,404 @@ graph_max_distance_k_cluster(vertex_t *vertices, size_t nvertices, edge_t **edge
     return edges[i]->weight;
 }
 
+typedef struct msf_edge msf_edge_t;
+
+/**
+ * Edge still linking two components: index in input array breaks ties
+ * among equal weights, so that every component has a single lightest
+ * edge and those edges never form a cycle.
+ */
+struct msf_edge {
+    long weight;
+    size_t id;
+    int u;
+    int v;
+};
+
+#define MSF_NONE ((size_t)-1)
+
+typedef struct msf msf_t;
+
+/**
+ * State shared by threads computing a minimum spanning forest.
+ */
+struct msf {
+    vertex_t *vertices;
+    edge_t **edges;
+    size_t nedges;
+    msf_edge_t *live;
+    msf_edge_t *next_live;
+    size_t nlive;
+    int *roots;             /**< components of endpoints of live edges */
+    atomic_size_t *best;    /**< lightest live edge of every component */
+    concurrent_disjoint_sets_t *ds;
+    size_t *chosen;         /**< input indices of forest edges */
+    atomic_size_t nchosen;
+    size_t *counts;         /**< live edges kept by every thread */
+    parallel_barrier_t barrier;
+};
+
+static inline bool
+msf_less(const msf_edge_t *e1, const msf_edge_t *e2)
+{
+    return e1->weight < e2->weight || (e1->weight == e2->weight && e1->id < e2->id);
+}
+
+static void
+msf_best_update(msf_t *m, int root, size_t i)
+{
+    size_t best = atomic_load_explicit(&m->best[root], memory_order_relaxed);
+
+    while ((MSF_NONE == best || msf_less(&m->live[i], &m->live[best])) &&
+           !atomic_compare_exchange_weak_explicit(&m->best[root], &best, i,
+                                                  memory_order_relaxed, memory_order_relaxed));
+}
+
+/**
+ * Boruvka: every round, each component picks its lightest edge to
+ * another component, all picked edges are added to the forest, and
+ * edges left inside a component are dropped. Number of components at
+ * least halves every round.
+ *
+ * Endpoints of edges kept are replaced by their representatives, so
+ * that finds of next round start at (or next to) a root.
+ */
+static void
+msf_worker(void *arg, int id, int nthreads)
+{
+    msf_t *m = arg;
+    size_t begin, end;
+    size_t i;
+
+    parallel_range(m->nedges, id, nthreads, &begin, &end);
+    for (i = begin; i < end; ++i) {
+        edge_t *edge = m->edges[i];
+        m->live[i].weight = edge->weight;
+        m->live[i].id = i;
+        m->live[i].u = edge->endpoint1 - m->vertices;
+        m->live[i].v = edge->endpoint2 - m->vertices;
+    }
+    parallel_barrier_wait(&m->barrier, nthreads);
+
+    while (m->nlive > 0) {
+        size_t kept = 0;
+        size_t first = 0;
+
+        parallel_range(m->nlive, id, nthreads, &begin, &end);
+
+        for (i = begin; i < end; ++i) {
+            int ru = concurrent_disjoint_sets_find(m->ds, m->live[i].u);
+            int rv = concurrent_disjoint_sets_find(m->ds, m->live[i].v);
+            m->roots[2 * i] = ru;
+            m->roots[2 * i + 1] = rv;
+            if (ru != rv) {
+                msf_best_update(m, ru, i);
+                msf_best_update(m, rv, i);
+            }
+        }
+        parallel_barrier_wait(&m->barrier, nthreads);
+
+        for (i = begin; i < end; ++i) {
+            int ru = m->roots[2 * i];
+            int rv = m->roots[2 * i + 1];
+            if (ru != rv &&
+                (i == atomic_load_explicit(&m->best[ru], memory_order_relaxed) ||
+                 i == atomic_load_explicit(&m->best[rv], memory_order_relaxed)) &&
+                concurrent_disjoint_sets_union(m->ds, ru, rv)) {
+                m->chosen[atomic_fetch_add(&m->nchosen, 1)] = m->live[i].id;
+            }
+        }
+        parallel_barrier_wait(&m->barrier, nthreads);
+
+        for (i = begin; i < end; ++i) {
+            int ru = m->roots[2 * i];
+            int rv = m->roots[2 * i + 1];
+            if (ru != rv) {
+                atomic_store_explicit(&m->best[ru], MSF_NONE, memory_order_relaxed);
+                atomic_store_explicit(&m->best[rv], MSF_NONE, memory_order_relaxed);
+                m->roots[2 * i] = concurrent_disjoint_sets_find(m->ds, ru);
+                m->roots[2 * i + 1] = concurrent_disjoint_sets_find(m->ds, rv);
+                if (m->roots[2 * i] != m->roots[2 * i + 1]) {
+                    kept++;
+                    continue;
+                }
+            }
+            m->roots[2 * i] = -1;
+        }
+        m->counts[id] = kept;
+        parallel_barrier_wait(&m->barrier, nthreads);
+
+        for (int t = 0; t < id; ++t) {
+            first += m->counts[t];
+        }
+        for (i = begin; i < end; ++i) {
+            if (-1 != m->roots[2 * i]) {
+                msf_edge_t *e = &m->next_live[first++];
+                *e = m->live[i];
+                e->u = m->roots[2 * i];
+                e->v = m->roots[2 * i + 1];
+            }
+        }
+
+        if (parallel_barrier_wait(&m->barrier, nthreads)) {
+            msf_edge_t *live = m->live;
+            m->live = m->next_live;
+            m->next_live = live;
+            m->nlive = 0;
+            for (int t = 0; t < nthreads; ++t) {
+                m->nlive += m->counts[t];
+            }
+        }
+        parallel_barrier_wait(&m->barrier, nthreads);
+    }
+}
+
+static int
+msf_id_cmp(const void *o1, const void *o2)
+{
+    size_t i1 = *(const size_t *)o1;
+    size_t i2 = *(const size_t *)o2;
+
+    return i1 < i2 ? -1 : i1 > i2;
+}
+
+long
+graph_msf(vertex_t *vertices, size_t nvertices, edge_t **edges, size_t nedges, int nthreads, edge_t **msf, double *cost)
+{
+    msf_t m = { .vertices = vertices, .edges = edges, .nedges = nedges, .nlive = nedges };
+    long count = -1;
+
+    nthreads = parallel_threads(nthreads);
+
+    m.live = malloc((nedges ? nedges : 1) * sizeof(msf_edge_t));
+    m.next_live = malloc((nedges ? nedges : 1) * sizeof(msf_edge_t));
+    m.roots = malloc((nedges ? 2 * nedges : 1) * sizeof(int));
+    m.best = malloc((nvertices ? nvertices : 1) * sizeof(atomic_size_t));
+    m.chosen = malloc((nvertices ? nvertices : 1) * sizeof(size_t));
+    m.counts = malloc(nthreads * sizeof(size_t));
+    m.ds = concurrent_disjoint_sets_new(nvertices);
+    if (NULL == m.live || NULL == m.next_live || NULL == m.roots || NULL == m.best ||
+        NULL == m.chosen || NULL == m.counts || NULL == m.ds) {
+        goto out;
+    }
+
+    for (size_t v = 0; v < nvertices; ++v) {
+        atomic_init(&m.best[v], MSF_NONE);
+    }
+    concurrent_disjoint_sets_make_set(m.ds);
+    atomic_init(&m.nchosen, 0);
+    parallel_barrier_init(&m.barrier);
+
+    parallel_run(nthreads, msf_worker, &m);
+
+    count = atomic_load(&m.nchosen);
+    qsort(m.chosen, count, sizeof(size_t), msf_id_cmp);
+
+    if (NULL != cost) {
+        *cost = 0.0;
+    }
+    for (long i = 0; i < count; ++i) {
+        if (NULL != msf) {
+            msf[i] = edges[m.chosen[i]];
+        }
+        if (NULL != cost) {
+            *cost += edges[m.chosen[i]]->weight;
+        }
+    }
+
+out:
+    if (NULL != m.ds) {
+        concurrent_disjoint_sets_free(m.ds);
+    }
+    free(m.live);
+    free(m.next_live);
+    free(m.roots);
+    free(m.best);
+    free(m.chosen);
+    free(m.counts);
+    return count;
+}
+
+static int
+dendrogram_edge_cmp(const void *o1, const void *o2)
+{
+    const edge_t *e1 = *(edge_t * const *)o1;
+    const edge_t *e2 = *(edge_t * const *)o2;
+
+    return e1->weight < e2->weight ? -1 : e1->weight > e2->weight;
+}
+
+graph_dendrogram_t *
+graph_dendrogram_build(vertex_t *vertices, size_t nvertices, edge_t **edges, size_t nedges, int nthreads)
+{
+    graph_dendrogram_t *dendrogram = calloc(1, sizeof(graph_dendrogram_t));
+    edge_t **msf = malloc((nvertices ? nvertices : 1) * sizeof(edge_t *));
+    int *cluster = malloc((nvertices ? nvertices : 1) * sizeof(int));
+    disjoint_sets_t *ds = disjoint_sets_new(nvertices);
+    long nmsf;
+
+    if (NULL == dendrogram || NULL == msf || NULL == cluster || NULL == ds) {
+        goto error;
+    }
+    dendrogram->size = nvertices;
+    dendrogram->merges = malloc((nvertices ? nvertices : 1) * sizeof(graph_merge_t));
+    if (NULL == dendrogram->merges) {
+        goto error;
+    }
+
+    nmsf = graph_msf(vertices, nvertices, edges, nedges, nthreads, msf, NULL);
+    if (nmsf < 0 || parallel_sort(msf, nmsf, sizeof(edge_t *), dendrogram_edge_cmp, nthreads) < 0) {
+        goto error;
+    }
+
+    /**
+     * cluster[r] is the cluster whose vertices are the set of root r.
+     */
+    for (int v = 0; v < (int)nvertices; ++v) {
+        cluster[v] = v;
+    }
+    for (long i = 0; i < nmsf; ++i) {
+        graph_merge_t *merge = &dendrogram->merges[i];
+        int ru = disjoint_sets_find(ds, msf[i]->endpoint1 - vertices);
+        int rv = disjoint_sets_find(ds, msf[i]->endpoint2 - vertices);
+
+        merge->left = cluster[ru] < cluster[rv] ? cluster[ru] : cluster[rv];
+        merge->right = cluster[ru] < cluster[rv] ? cluster[rv] : cluster[ru];
+        merge->height = msf[i]->weight;
+        disjoint_sets_union(ds, ru, rv);
+        merge->size = disjoint_sets_set_size(ds, ru);
+        cluster[disjoint_sets_find(ds, ru)] = nvertices + i;
+    }
+    dendrogram->nmerges = nmsf;
+
+    free(msf);
+    free(cluster);
+    disjoint_sets_free(ds);
+    return dendrogram;
+
+error:
+    free(msf);
+    free(cluster);
+    disjoint_sets_free(ds);
+    graph_dendrogram_free(dendrogram);
+    return NULL;
+}
+
+void
+graph_dendrogram_free(graph_dendrogram_t *dendrogram)
+{
+    if (NULL != dendrogram) {
+        free(dendrogram->merges);
+        free(dendrogram);
+    }
+}
+
+long
+graph_dendrogram_spacing(graph_dendrogram_t *dendrogram, int k)
+{
+    int merge = dendrogram->size - k;
+
+    if (merge < 0) {
+        return 0;
+    }
+    return merge < dendrogram->nmerges ? dendrogram->merges[merge].height : LONG_MAX;
+}
+
+/**
+ * Returns number of merges not higher than height.
+ */
+static int
+dendrogram_merges_below(graph_dendrogram_t *dendrogram, long height)
+{
+    int first = 0;
+    int last = dendrogram->nmerges;
+
+    while (first < last) {
+        int middle = first + (last - first) / 2;
+        if (dendrogram->merges[middle].height <= height) {
+            first = middle + 1;
+        }
+        else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+int
+graph_dendrogram_clusters(graph_dendrogram_t *dendrogram, long height)
+{
+    return dendrogram->size - dendrogram_merges_below(dendrogram, height);
+}
+
+/**
+ * Labels vertices once the first nmerges merges are made.
+ *
+ * Left and right clusters of every merge are tracked down to one of their
+ * vertices (first[c]), which is enough to replay merges on disjoint sets.
+ */
+static int
+dendrogram_cut_merges(graph_dendrogram_t *dendrogram, int nmerges, int *label)
+{
+    int size = dendrogram->size;
+    int *first = malloc((size + nmerges > 0 ? size + nmerges : 1) * sizeof(int));
+    disjoint_sets_t *ds = disjoint_sets_new(size);
+    int count = 0;
+
+    if (NULL == first || NULL == ds) {
+        free(first);
+        disjoint_sets_free(ds);
+        return -1;
+    }
+
+    for (int v = 0; v < size; ++v) {
+        first[v] = v;
+    }
+    for (int i = 0; i < nmerges; ++i) {
+        graph_merge_t *merge = &dendrogram->merges[i];
+        disjoint_sets_union(ds, first[merge->left], first[merge->right]);
+        first[size + i] = first[merge->left];
+    }
+
+    /**
+     * first cluster found in a set names it.
+     */
+    for (int v = 0; v < size; ++v) {
+        first[v] = -1;
+    }
+    for (int v = 0; v < size; ++v) {
+        int root = disjoint_sets_find(ds, v);
+        if (-1 == first[root]) {
+            first[root] = count++;
+        }
+        label[v] = first[root];
+    }
+
+    free(first);
+    disjoint_sets_free(ds);
+    return count;
+}
+
+int
+graph_dendrogram_cut(graph_dendrogram_t *dendrogram, int k, int *label)
+{
+    int nmerges = dendrogram->size - k;
+
+    if (nmerges < 0) {
+        nmerges = 0;
+    }
+    if (nmerges > dendrogram->nmerges) {
+        nmerges = dendrogram->nmerges;
+    }
+    return dendrogram_cut_merges(dendrogram, nmerges, label);
+}
+
+int
+graph_dendrogram_cut_height(graph_dendrogram_t *dendrogram, long height, int *label)
+{
+    return dendrogram_cut_merges(dendrogram, dendrogram_merges_below(dendrogram, height), label);
+}
+
 graph_t *
 graph_reverse(graph_t *graph)
 {
@@ -601,97 +1621,709 @@ graph_reverse(graph_t *graph)
     return graph_r;
 }
 
-static bool 
-bidirectional_dijkstra_distance(graph_t *graph, heap_t *h, list_t *proc, graph_t *graph_r, list_t *proc_r, long *distance)
+typedef struct order_entry order_entry_t;
+
+struct order_entry {
+    int degree;
+    int vertex;
+};
+
+static int
+order_entry_cmp(const void *p1, const void *p2)
 {
-    node_t *node = NULL;
-    vertex_t *v, *v_r;
+    const order_entry_t *e1 = p1;
+    const order_entry_t *e2 = p2;
 
-    *distance = LONG_MAX;
+    if (e1->degree != e2->degree) {
+        return e1->degree < e2->degree ? -1 : 1;
+    }
+    return e1->vertex < e2->vertex ? -1 : e1->vertex > e2->vertex;
+}
 
-    heap_pop_front(h, &v);
+typedef struct order_search order_search_t;
+
+/**
+ * State of breadth-first searches computing an ordering: vertices are
+ * marked with the stamp of the last search that reached them, so that
+ * searches don't need to clear marks.
+ */
+struct order_search {
+    graph_t *graph;
+    int *degree;
+    int *mark;
+    int stamp;
+    int *queue;
+    order_entry_t *entries;
+};
+
+/**
+ * Breadth-first search from s over vertices not numbered yet (perm[v]
+ * being -1), leaving vertices in visit order in queue.
+ *
+ * @param sorted whether neighbors of every vertex are visited by
+ *        increasing degree instead of adjacency order
+ * @param last receives index in queue of the first vertex of the last
+ *        level (optional)
+ * @param depth receives number of levels after the first one (optional)
+ * @return number of vertices visited.
+ */
+static int
+order_bfs(order_search_t *os, const int *perm, int s, bool sorted, int *last, int *depth)
+{
+    int head = 0;
+    int tail = 0;
+    int level = 0;
+    int level_begin = 0;
+    int level_end = 1;
+
+    os->stamp++;
+    os->mark[s] = os->stamp;
+    os->queue[tail++] = s;
+
+    while (head < tail) {
+        vertex_t *u = &os->graph->vertices[os->queue[head++]];
+        int first = tail;
+        node_t *node = NULL;
 
-    list_foreach(v->edges, node) {
-        edge_t *edge = node_data(node);
-        if (vertex_relax(v, edge)) {
-            vertex_t *z = edge_pair_get(edge, v);
-            heap_update(h, z->heap_index);
+        list_foreach(u->edges, node) {
+            int v = edge_pair_get(node_data(node), u)->index;
+            if (-1 == perm[v] && os->stamp != os->mark[v]) {
+                os->mark[v] = os->stamp;
+                os->queue[tail++] = v;
+            }
+        }
+
+        if (sorted && tail - first > 1) {
+            for (int k = first; k < tail; ++k) {
+                os->entries[k - first].degree = os->degree[os->queue[k]];
+                os->entries[k - first].vertex = os->queue[k];
+            }
+            qsort(os->entries, tail - first, sizeof(order_entry_t), order_entry_cmp);
+            for (int k = first; k < tail; ++k) {
+                os->queue[k] = os->entries[k - first].vertex;
+            }
+        }
+
+        if (head == level_end && head < tail) {
+            level_begin = head;
+            level_end = tail;
+            level++;
         }
     }
 
-    //fprintf(stdout, "from heap (%zu %ld)\n", u->index, u->distance);
+    if (NULL != last) {
+        *last = level_begin;
+    }
+    if (NULL != depth) {
+        *depth = level;
+    }
+    return tail;
+}
 
-    v->visited = 1;
-    list_push_back(proc, v);
+/**
+ * Returns a pseudo-peripheral vertex of the component of s (George and
+ * Liu): starting from its lowest degree vertex, moves to the lowest
+ * degree vertex of the last level of a search from the current one, as
+ * long as that search goes deeper.
+ */
+static int
+order_peripheral(order_search_t *os, const int *perm, int s)
+{
+    int n = order_bfs(os, perm, s, false, NULL, NULL);
+    int x = s;
+    int eccentricity = -1;
+
+    for (int k = 0; k < n; ++k) {
+        if (os->degree[os->queue[k]] < os->degree[x]) {
+            x = os->queue[k];
+        }
+    }
 
-    v_r = &graph_r->vertices[v->index]; 
+    for (;;) {
+        int last, depth;
+        int y;
 
-    if (v_r->visited) {
-        node_t *node;
-        list_foreach(proc, node) {
-            vertex_t *u   = node_data(node);
-            vertex_t *u_r = &graph_r->vertices[u->index];
-            //fprintf(stdout, "(%zu %ld) (%zu %ld %d)\n", v->index, v->distance, v_r->index, v_r->distance, v_r->visited);
-            if ((u->distance < LONG_MAX && u_r->distance < LONG_MAX) && (u->distance + u_r->distance < *distance)) {
-                *distance = u->distance + u_r->distance;
+        n = order_bfs(os, perm, x, false, &last, &depth);
+        if (depth <= eccentricity) {
+            return x;
+        }
+        eccentricity = depth;
+        y = os->queue[last];
+        for (int k = last + 1; k < n; ++k) {
+            if (os->degree[os->queue[k]] < os->degree[y]) {
+                y = os->queue[k];
             }
         }
-        return true; /**< forward/backward searches met in the middle */
+        if (y == x) {
+            return x;
+        }
+        x = y;
     }
-    return false;
 }
 
-long
-graph_bidirectional_dijkstra_distance(graph_t *graph, graph_t *graph_r, vertex_t *s, vertex_t *t)
+int
+graph_ordering(graph_t *graph, graph_order_t order, int *perm)
 {
-    long distance = LONG_MAX;
-    heap_t *h_r = NULL;
-    heap_t *h = NULL;
-    list_t *proc = NULL;
-    list_t *proc_r = NULL;
+    order_search_t os;
+    int size = graph->size;
+    int next = 0;
+    int rc = -1;
+
+    memset(&os, 0, sizeof(os));
+    os.graph = graph;
+    os.degree = calloc(size ? size : 1, sizeof(int));
+    os.mark = calloc(size ? size : 1, sizeof(int));
+    os.queue = malloc((size ? size : 1) * sizeof(int));
+    os.entries = malloc((size ? size : 1) * sizeof(order_entry_t));
+
+    if (NULL == os.degree || NULL == os.mark || NULL == os.queue || NULL == os.entries) {
+        goto out;
+    }
 
-    vertex_t **vertices   = malloc(graph->size   * sizeof(vertex_t *));
-    vertex_t **vertices_r = malloc(graph_r->size * sizeof(vertex_t *));
+    for (int v = 0; v < size; ++v) {
+        node_t *node = NULL;
+        list_foreach(graph->vertices[v].edges, node) {
+            os.degree[v]++;
+        }
+        perm[v] = -1;
+    }
 
-    for (int i = 0; i < graph->size; ++i) { 
+    if (GRAPH_ORDER_DEGREE == order) {
+        for (int v = 0; v < size; ++v) {
+            os.entries[v].degree = -os.degree[v];
+            os.entries[v].vertex = v;
+        }
+        qsort(os.entries, size, sizeof(order_entry_t), order_entry_cmp);
+        for (int k = 0; k < size; ++k) {
+            perm[os.entries[k].vertex] = k;
+        }
+        rc = 0;
+        goto out;
+    }
 
-        graph->vertices[i].visited = 0;
-        graph->vertices[i].distance = LONG_MAX;
-        vertices[i] = &graph->vertices[i];
-        vertices[i]->parent = NULL;
+    for (int s = 0; s < size; ++s) {
+        int n;
 
-        graph_r->vertices[i].visited = 0;
-        graph_r->vertices[i].distance = LONG_MAX;
-        vertices_r[i] = &graph_r->vertices[i];
-        vertices_r[i]->parent = NULL;
+        if (-1 != perm[s]) {
+            continue;
+        }
+        /* edges being followed from their source only, a search from
+         * the peripheral vertex may miss s: it's searched again */
+        if (GRAPH_ORDER_RCM == order) {
+            n = order_bfs(&os, perm, order_peripheral(&os, perm, s), true, NULL, NULL);
+        }
+        else {
+            n = order_bfs(&os, perm, s, false, NULL, NULL);
+        }
+        for (int k = 0; k < n; ++k) {
+            perm[os.queue[k]] = next++;
+        }
+        if (-1 == perm[s]) {
+            --s;
+        }
     }
 
-    s->distance = 0;
-    graph_r->vertices[t->index].distance = 0;
+    if (GRAPH_ORDER_RCM == order) {
+        for (int v = 0; v < size; ++v) {
+            perm[v] = size - 1 - perm[v];
+        }
+    }
+    rc = 0;
+
+out:
+    free(os.degree);
+    free(os.mark);
+    free(os.queue);
+    free(os.entries);
+    return rc;
+}
 
-    h   = heap_build(vertices,   graph->size,   sizeof(vertex_t *), vertex_cmp, NULL, vertex_update);
-    h_r = heap_build(vertices_r, graph_r->size, sizeof(vertex_t *), vertex_cmp, NULL, vertex_update);
+typedef struct permute_arc permute_arc_t;
 
-    proc   = list_new();
-    proc_r = list_new();
-    
-    do {
+/**
+ * Entry of adjacency list u of permuted graph, edge being slot-th edge
+ * created (both entries of an undirected edge share their slot).
+ */
+struct permute_arc {
+    int u;
+    int v;
+    size_t slot;
+};
 
-        if (bidirectional_dijkstra_distance(graph,   h,   proc,   graph_r, proc_r, &distance)) {
-            break;
+static int
+permute_arc_cmp(const void *p1, const void *p2)
+{
+    const permute_arc_t *a1 = p1;
+    const permute_arc_t *a2 = p2;
+
+    if (a1->u != a2->u) {
+        return a1->u < a2->u ? -1 : 1;
+    }
+    if (a1->v != a2->v) {
+        return a1->v < a2->v ? -1 : 1;
+    }
+    return a1->slot < a2->slot ? -1 : a1->slot > a2->slot;
+}
+
+graph_t *
+graph_permute(graph_t *graph, const int *perm)
+{
+    graph_t *graph_p = graph_new(graph->size);
+    permute_arc_t *arcs = NULL;
+    edge_t **sources = NULL;
+    edge_t **created = NULL;
+    size_t narcs = 0;
+    size_t nslots = 0;
+    bool ok = false;
+
+    if (NULL == graph_p) {
+        return NULL;
+    }
+
+    for (int u = 0; u < graph->size; ++u) {
+        node_t *node = NULL;
+        list_foreach(graph->vertices[u].edges, node) {
+            narcs++;
         }
+    }
+    arcs = malloc((narcs ? narcs : 1) * sizeof(permute_arc_t));
+    sources = malloc((narcs ? narcs : 1) * sizeof(edge_t *));
+    created = calloc(narcs ? narcs : 1, sizeof(edge_t *));
+    if (NULL == arcs || NULL == sources || NULL == created) {
+        goto out;
+    }
+
+    /* undirected edges, listed by both endpoints, get both arcs from the
+     * endpoint with the lowest new index */
+    narcs = 0;
+    for (int u = 0; u < graph->size; ++u) {
+        vertex_t *vu = &graph->vertices[u];
+        node_t *node = NULL;
+
+        graph_p->vertices[perm[u]].data = vu->data;
+        list_foreach(vu->edges, node) {
+            edge_t *edge = node_data(node);
+            int v = edge_pair_get(edge, vu)->index;
+            bool shared = EDGE_SHARED == edge->state && u != v;
 
-        if (bidirectional_dijkstra_distance(graph_r, h_r, proc_r, graph,   proc,   &distance)) {
+            if (shared && perm[v] < perm[u]) {
+                continue;
+            }
+            sources[nslots] = edge;
+            arcs[narcs].u = perm[u];
+            arcs[narcs].v = perm[v];
+            arcs[narcs++].slot = nslots;
+            if (shared) {
+                arcs[narcs].u = perm[v];
+                arcs[narcs].v = perm[u];
+                arcs[narcs++].slot = nslots;
+            }
+            nslots++;
+        }
+    }
+
+    qsort(arcs, narcs, sizeof(permute_arc_t), permute_arc_cmp);
+
+    for (size_t k = 0; k < narcs; ++k) {
+        size_t slot = arcs[k].slot;
+        if (NULL == created[slot]) {
+            edge_t *edge = sources[slot];
+            created[slot] = edge_new(&graph_p->vertices[perm[edge->endpoint1->index]],
+                                     &graph_p->vertices[perm[edge->endpoint2->index]],
+                                     edge->directed ? EDGE_F_DIRECTED : EDGE_F_NONE);
+            if (NULL == created[slot]) {
+                goto out;
+            }
+            created[slot]->weight = edge->weight;
+        }
+        vertex_edge_add(&graph_p->vertices[arcs[k].u], created[slot]);
+    }
+    ok = true;
+
+out:
+    if (!ok) {
+        /* edges not added to any list yet are not owned by graph_p */
+        for (size_t slot = 0; NULL != created && slot < nslots; ++slot) {
+            if (NULL != created[slot] && EDGE_CREATED == created[slot]->state) {
+                free(created[slot]);
+            }
+        }
+        graph_free(graph_p);
+        graph_p = NULL;
+    }
+    free(arcs);
+    free(sources);
+    free(created);
+    return graph_p;
+}
+
+/**
+ * Settles top of the heap of one search direction and relaxes its edges.
+ *
+ * Whenever an edge reaches a vertex already labeled by the other search
+ * direction, best known s-t distance is updated.
+ *
+ * @return zero on success, -1 on allocation failure.
+ */
+static int
+bidirectional_dijkstra_step(graph_t *graph, heap_t *h, graph_search_t *search, graph_search_t *search_o, long *best)
+{
+    search_vertex_t *su = NULL;
+    vertex_t *u;
+    node_t *node;
+
+    heap_pop_front(h, &su);
+    su->visited = 1;
+
+    u = &graph->vertices[graph_search_index(search, su)];
+
+    list_foreach(u->edges, node) {
+        edge_t *edge = node_data(node);
+        vertex_t *z = edge_pair_get(edge, u);
+        search_vertex_t *sz = search_vertex_get(search, z);
+        search_vertex_t *sz_o = graph_search_vertex(search_o, z->index);
+        bool discovered = LONG_MAX != sz->distance;
+        long d = su->distance + (long)edge->weight;
+
+        if (!sz->visited && vertex_relax(search, u, edge)) {
+            if (discovered) {
+                heap_update(h, sz->heap_index);
+            }
+            else if (0 != heap_insert(h, &sz)) {
+                return -1;
+            }
+        }
+        if (LONG_MAX != sz_o->distance && d + sz_o->distance < *best) {
+            *best = d + sz_o->distance;
+        }
+    }
+    return 0;
+}
+
+long
+graph_bidirectional_dijkstra_distance(graph_t *graph, graph_t *graph_r, graph_search_t *search, graph_search_t *search_r, vertex_t *s, vertex_t *t)
+{
+    long best = LONG_MAX;
+    heap_t *h = heap_new(0, sizeof(search_vertex_t *), GRAPH_HEAP_ARITY, vertex_cmp, NULL, vertex_update);
+    heap_t *h_r = heap_new(0, sizeof(search_vertex_t *), GRAPH_HEAP_ARITY, vertex_cmp, NULL, vertex_update);
+    search_vertex_t *sv;
+
+    if (NULL == h || NULL == h_r) {
+        goto error;
+    }
+
+    graph_search_reset(search);
+    graph_search_reset(search_r);
+
+    if (s->index == t->index) {
+        best = 0;
+    }
+
+    sv = search_vertex_get(search, s);
+    sv->distance = 0;
+    if (0 != heap_insert(h, &sv)) {
+        goto error;
+    }
+    sv = graph_search_vertex(search_r, t->index);
+    sv->distance = 0;
+    if (0 != heap_insert(h_r, &sv)) {
+        goto error;
+    }
+
+    /**
+     * Stop when no path through vertices not yet settled by any side
+     * can be shorter than the best path found so far.
+     */
+    while (heap_size(h) > 0 && heap_size(h_r) > 0) {
+        search_vertex_t *top = *(search_vertex_t **)heap_top(h);
+        search_vertex_t *top_r = *(search_vertex_t **)heap_top(h_r);
+
+        if (LONG_MAX != best && top->distance + top_r->distance >= best) {
             break;
         }
 
-    } while (true);
+        if (0 != (top->distance <= top_r->distance ?
+                  bidirectional_dijkstra_step(graph, h, search, search_r, &best) :
+                  bidirectional_dijkstra_step(graph_r, h_r, search_r, search, &best))) {
+            goto error;
+        }
+    }
 
-    list_free(proc);
-    list_free(proc_r);
+out:
+    if (NULL != h) {
+        heap_free(h);
+    }
+    if (NULL != h_r) {
+        heap_free(h_r);
+    }
 
-    heap_free(h);
-    heap_free(h_r);
+    return best;
+
+error:
+    best = -1;
+    goto out;
+}
+
+typedef struct connectivity_event connectivity_event_t;
+
+/**
+ * Addition or removal of edge u-v (u <= v) at time.
+ */
+struct connectivity_event {
+    int u;
+    int v;
+    size_t time;
+    connectivity_op_type_t type;
+};
+
+static int
+connectivity_event_cmp(const void *o1, const void *o2)
+{
+    const connectivity_event_t *e1 = o1;
+    const connectivity_event_t *e2 = o2;
+
+    if (e1->u != e2->u) {
+        return e1->u < e2->u ? -1 : 1;
+    }
+    if (e1->v != e2->v) {
+        return e1->v < e2->v ? -1 : 1;
+    }
+    return e1->time < e2->time ? -1 : e1->time > e2->time;
+}
+
+typedef struct connectivity_interval connectivity_interval_t;
+
+/**
+ * Edge u-v alive for queries in [first, last).
+ */
+struct connectivity_interval {
+    int u;
+    int v;
+    size_t first;
+    size_t last;
+};
+
+/**
+ * Segment tree over queries: leaf P + i holds query i, P being the
+ * smallest power of two not less than number of queries. Edges of node
+ * x are edges[offsets[x]] .. edges[offsets[x + 1] - 1].
+ */
+typedef struct connectivity_tree connectivity_tree_t;
+
+struct connectivity_tree {
+    size_t leaves;
+    size_t *offsets;
+    int *edges;       /**< pairs of endpoints */
+    size_t nqueries;
+    size_t *queries;  /**< time of every query */
+    const connectivity_op_t *ops;
+    bool *connected;
+    rollback_disjoint_sets_t *ds;
+};
+
+/**
+ * Stores edge of interval in node x, or only counts it if edges
+ * of the tree are not allocated yet.
+ */
+static inline void
+connectivity_tree_node_add(connectivity_tree_t *tree, size_t x, const connectivity_interval_t *interval)
+{
+    if (NULL == tree->edges) {
+        tree->offsets[x + 1]++;
+    }
+    else {
+        size_t k = tree->offsets[x]++;
+        tree->edges[2 * k] = interval->u;
+        tree->edges[2 * k + 1] = interval->v;
+    }
+}
 
-    return distance;   
+/**
+ * Adds edge of interval to the O(log(q)) nodes covering its queries.
+ */
+static void
+connectivity_tree_add(connectivity_tree_t *tree, const connectivity_interval_t *interval)
+{
+    size_t l = interval->first + tree->leaves;
+    size_t r = interval->last + tree->leaves;
+
+    for (; l < r; l >>= 1, r >>= 1) {
+        if (l & 1) {
+            connectivity_tree_node_add(tree, l++, interval);
+        }
+        if (r & 1) {
+            connectivity_tree_node_add(tree, --r, interval);
+        }
+    }
+}
+
+static int
+connectivity_tree_visit(connectivity_tree_t *tree, size_t x, size_t first, size_t last)
+{
+    size_t checkpoint = rollback_disjoint_sets_checkpoint(tree->ds);
+    int rc = 0;
+
+    if (first >= tree->nqueries) {
+        return 0;
+    }
+
+    for (size_t i = tree->offsets[x]; i < tree->offsets[x + 1]; ++i) {
+        if (rollback_disjoint_sets_union(tree->ds, tree->edges[2 * i], tree->edges[2 * i + 1]) < 0) {
+            return -1;
+        }
+    }
+
+    if (x >= tree->leaves) {
+        const connectivity_op_t *op = &tree->ops[tree->queries[first]];
+        tree->connected[tree->queries[first]] = rollback_disjoint_sets_same_set(tree->ds, op->u, op->v);
+    }
+    else {
+        size_t middle = first + (last - first) / 2;
+        rc = connectivity_tree_visit(tree, 2 * x, first, middle);
+        if (0 == rc) {
+            rc = connectivity_tree_visit(tree, 2 * x + 1, middle, last);
+        }
+    }
+
+    rollback_disjoint_sets_rollback(tree->ds, checkpoint);
+
+    return rc;
+}
+
+int
+graph_dynamic_connectivity(int size, const connectivity_op_t *ops, size_t nops, bool *connected)
+{
+    connectivity_tree_t tree = { 0 };
+    connectivity_event_t *events = NULL;
+    connectivity_interval_t *intervals = NULL;
+    size_t *before = malloc((nops + 1) * sizeof(size_t)); /**< queries before time */
+    size_t *open = NULL;
+    size_t nevents = 0;
+    size_t nintervals = 0;
+    size_t i;
+    size_t j;
+    size_t x;
+    int rc = -1;
+
+    if (NULL == before) {
+        goto out;
+    }
+
+    before[0] = 0;
+    for (i = 0; i < nops; ++i) {
+        before[i + 1] = before[i] + (CONNECTIVITY_QUERY == ops[i].type);
+        nevents += CONNECTIVITY_QUERY != ops[i].type;
+    }
+    tree.nqueries = before[nops];
+    tree.ops = ops;
+    tree.connected = connected;
+
+    events = malloc((nevents ? nevents : 1) * sizeof(connectivity_event_t));
+    intervals = malloc((nevents ? nevents : 1) * sizeof(connectivity_interval_t));
+    open = malloc((nevents ? nevents : 1) * sizeof(size_t));
+    tree.queries = malloc((tree.nqueries ? tree.nqueries : 1) * sizeof(size_t));
+    if (NULL == events || NULL == intervals || NULL == open || NULL == tree.queries) {
+        goto out;
+    }
+
+    nevents = 0;
+    for (i = 0; i < nops; ++i) {
+        if (CONNECTIVITY_QUERY == ops[i].type) {
+            tree.queries[before[i]] = i;
+        }
+        else if (ops[i].u != ops[i].v) {
+            connectivity_event_t *e = &events[nevents++];
+            e->u = ops[i].u < ops[i].v ? ops[i].u : ops[i].v;
+            e->v = ops[i].u < ops[i].v ? ops[i].v : ops[i].u;
+            e->time = i;
+            e->type = ops[i].type;
+        }
+    }
+
+    /**
+     * Events of the same edge end up together in time order: every
+     * removal closes interval of the last addition still open.
+     */
+    qsort(events, nevents, sizeof(connectivity_event_t), connectivity_event_cmp);
+
+    for (i = 0; i < nevents; i = j) {
+        size_t nopen = 0;
+
+        for (j = i; j < nevents && events[j].u == events[i].u && events[j].v == events[i].v; ++j) {
+            size_t start;
+
+            if (CONNECTIVITY_ADD == events[j].type) {
+                open[nopen++] = events[j].time;
+                continue;
+            }
+            if (0 == nopen) {
+                continue;
+            }
+            start = open[--nopen];
+            if (before[start] < before[events[j].time]) {
+                intervals[nintervals++] = (connectivity_interval_t){ events[i].u, events[i].v, before[start], before[events[j].time] };
+            }
+        }
+        while (nopen > 0) {
+            size_t start = open[--nopen];
+            if (before[start] < tree.nqueries) {
+                intervals[nintervals++] = (connectivity_interval_t){ events[i].u, events[i].v, before[start], tree.nqueries };
+            }
+        }
+    }
+
+    if (0 == tree.nqueries) {
+        rc = 0;
+        goto out;
+    }
+
+    tree.leaves = 1;
+    while (tree.leaves < tree.nqueries) {
+        tree.leaves *= 2;
+    }
+    tree.offsets = calloc(2 * tree.leaves + 1, sizeof(size_t));
+    if (NULL == tree.offsets) {
+        goto out;
+    }
+
+    /**
+     * Count edges of every node, then place them.
+     */
+    for (i = 0; i < nintervals; ++i) {
+        connectivity_tree_add(&tree, &intervals[i]);
+    }
+    for (x = 0; x < 2 * tree.leaves; ++x) {
+        tree.offsets[x + 1] += tree.offsets[x];
+    }
+    tree.edges = malloc((tree.offsets[2 * tree.leaves] ? 2 * tree.offsets[2 * tree.leaves] : 1) * sizeof(int));
+    if (NULL == tree.edges) {
+        goto out;
+    }
+    for (i = 0; i < nintervals; ++i) {
+        connectivity_tree_add(&tree, &intervals[i]);
+    }
+    for (x = 2 * tree.leaves; x > 0; --x) {
+        tree.offsets[x] = tree.offsets[x - 1];
+    }
+    tree.offsets[0] = 0;
+
+    tree.ds = rollback_disjoint_sets_new(size);
+    if (NULL == tree.ds) {
+        goto out;
+    }
+
+    rc = connectivity_tree_visit(&tree, 1, 0, tree.leaves);
+
+out:
+    if (NULL != tree.ds) {
+        rollback_disjoint_sets_free(tree.ds);
+    }
+    free(tree.offsets);
+    free(tree.edges);
+    free(tree.queries);
+    free(events);
+    free(intervals);
+    free(open);
+    free(before);
+    return rc;
 }
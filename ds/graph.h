@@ -13,18 +13,9 @@ enum color {
 typedef struct vertex vertex_t;
 
 struct vertex {
-    vertex_t *parent;
     void *data;
     list_t *edges;
-    int clock;
-    int previsit;
-    int postvisit;
-    long distance;
     size_t index;
-    size_t heap_index;
-    color_t color;
-    double cost;
-    unsigned visited:1;
 };
 
 typedef enum edge_flags edge_flags_t;
@@ -53,6 +44,22 @@ struct edge {
     unsigned char state:2;
 };
 
+typedef enum connectivity_op_type connectivity_op_type_t;
+
+enum connectivity_op_type {
+    CONNECTIVITY_ADD    = 0, /**< adds edge u-v */
+    CONNECTIVITY_REMOVE = 1, /**< removes one edge u-v previously added */
+    CONNECTIVITY_QUERY  = 2  /**< are u and v connected? */
+};
+
+typedef struct connectivity_op connectivity_op_t;
+
+struct connectivity_op {
+    connectivity_op_type_t type;
+    int u;
+    int v;
+};
+
 typedef struct graph graph_t;
 
 struct graph {
@@ -60,6 +67,124 @@ struct graph {
     int size;
 };
 
+typedef struct search_vertex search_vertex_t;
+
+/**
+ * Per query state of a vertex.
+ *
+ * Fields are only meaningful while epoch matches the epoch of
+ * the search owning it, otherwise they hold defaults (see
+ * graph_search_vertex).
+ */
+struct search_vertex {
+    long distance;
+    double cost;
+    size_t heap_index;
+    struct pairing_heap_node *heap_node; /**< handle in pairing heap */
+    int parent; /**< index of parent vertex, -1 if none */
+    int previsit;
+    int postvisit;
+    unsigned epoch;
+    color_t color;
+    unsigned visited:1;
+};
+
+typedef struct graph_search graph_search_t;
+
+/**
+ * Query context for graph algorithms.
+ *
+ * Algorithms keep all per vertex state (visited, distance, parent, ...)
+ * in a search context instead of in the graph itself, so one read-only
+ * graph might be queried concurrently by several threads, each one
+ * owning its own context.
+ *
+ * Resetting a context is an O(1) operation: it just bumps the epoch,
+ * stale vertex states are lazily reinitialized when first accessed.
+ * Hence a query costs time proportional to the vertices it touches.
+ */
+struct graph_search {
+    search_vertex_t *vertices;
+    int *queue; /**< size vertices, allocated by the first query needing it */
+    int size;
+    int clock;
+    unsigned epoch;
+};
+
+/**
+ * Allocates new search context for graphs with up to size vertices.
+ */
+graph_search_t *
+graph_search_new(int size);
+
+void
+graph_search_free(graph_search_t *search);
+
+/**
+ * Invalidates state of every vertex of the search.
+ *
+ * It's an O(1) amortized time operation.
+ */
+void
+graph_search_reset(graph_search_t *search);
+
+/**
+ * Returns queue of search->size vertices owned by search, allocating it
+ * on first call, so breadth-first queries don't allocate one each time.
+ *
+ * @return queue or NULL in case of error.
+ */
+int *
+graph_search_queue(graph_search_t *search);
+
+/**
+ * Returns state of i-th vertex for current search epoch.
+ */
+static inline search_vertex_t *
+graph_search_vertex(graph_search_t *search, int i)
+{
+    search_vertex_t *sv = &search->vertices[i];
+
+    if (sv->epoch != search->epoch) {
+        sv->distance = LONG_MAX;
+        sv->cost = DBL_MAX;
+        sv->heap_index = 0;
+        sv->parent = -1;
+        sv->previsit = 0;
+        sv->postvisit = 0;
+        sv->epoch = search->epoch;
+        sv->color = WHITE;
+        sv->visited = 0;
+    }
+    return sv;
+}
+
+static inline int
+graph_search_index(graph_search_t *search, search_vertex_t *sv)
+{
+    return sv - search->vertices;
+}
+
+/**
+ * Returns distance of i-th vertex found by last query run on search,
+ * LONG_MAX if it was not reached.
+ */
+static inline long
+graph_search_distance(graph_search_t *search, int i)
+{
+    return graph_search_vertex(search, i)->distance;
+}
+
+/**
+ * Returns parent index of i-th vertex found by last query run on search,
+ * -1 if it has none.
+ */
+static inline int
+graph_search_parent(graph_search_t *search, int i)
+{
+    return graph_search_vertex(search, i)->parent;
+}
+
 vertex_t *
 vertex_new(void);
 
@@ -72,6 +197,9 @@ edge_new(vertex_t *v1, vertex_t *v2, edge_flags_t flags);
 void
 edge_free(edge_t *edge);
 
+vertex_t *
+edge_pair_get(edge_t *edge, vertex_t *u);
+
 graph_t *
 graph_new(size_t size);
 
@@ -85,36 +213,338 @@ vertex_t *
 graph_vertex_get(graph_t *graph, int i);
 
 bool
-graph_connected(graph_t *graph, vertex_t *u, vertex_t *v);
+graph_connected(graph_t *graph, graph_search_t *search, vertex_t *u, vertex_t *v);
 
+/**
+ * Returns number of connected components (see graph_components).
+ */
 int 
 graph_connected_count(graph_t *graph);
 
-bool
-graph_contains_cycle(graph_t *graph);
+/**
+ * Computes connected components on nthreads threads (<= 0 for number of
+ * online processors), without any recursion.
+ *
+ * Edges link their endpoints whatever their direction (weakly connected
+ * components). Afforest: every vertex is first linked to its first
+ * neighbors in concurrent disjoint sets, then the largest component is
+ * guessed by sampling and only vertices out of it link their remaining
+ * neighbors, which skips most edges of graphs with a giant component.
+ *
+ * @param graph graph object
+ * @param nthreads number of threads
+ * @param label label[v] is set to component of vertex v, components
+ *        being numbered from 0 in order of their smallest vertex
+ *        (optional, graph->size entries)
+ * @param sizes sizes[c] is set to number of vertices of component c
+ *        (optional, requires label, graph->size entries)
+ * @return number of components, -1 on allocation failure.
+ */
+int
+graph_components(graph_t *graph, int nthreads, int *label, int *sizes);
 
+/**
+ * Same as graph_components, on size vertices and npairs edges
+ * pairs[2k]-pairs[2k + 1], all of them linked in parallel.
+ */
 int
-graph_distance(graph_t *graph, vertex_t *v, vertex_t *u);
+graph_components_edges(int size, const int *pairs, size_t npairs, int nthreads, int *label, int *sizes);
+
+/**
+ * Returns true if a depth-first search finds an edge to a vertex still
+ * on its path. Search is iterative, on an explicit stack of graph->size
+ * entries (false is returned if it cannot be allocated).
+ *
+ * See csr_graph_scc for strongly connected components.
+ */
+bool
+graph_contains_cycle(graph_t *graph, graph_search_t *search);
 
 int
-graph_dijkstra_distance(graph_t *graph, vertex_t *v, vertex_t *u);
+graph_distance(graph_t *graph, graph_search_t *search, vertex_t *v, vertex_t *u);
+
+/**
+ * Returns weight of a shortest path from v to u, -1 if unreachable.
+ *
+ * Search stops as soon as u is settled and vertices only enter the
+ * priority queue when first reached, so the query costs time
+ * proportional to the part of the graph explored, not to V.
+ */
+int
+graph_dijkstra_distance(graph_t *graph, graph_search_t *search, vertex_t *v, vertex_t *u);
+
+/**
+ * Same as graph_dijkstra_distance, on a radix heap instead of the binary
+ * heap: insertions and decrease-keys are O(1), removals O(log(C))
+ * amortized, C being the largest edge weight, with no comparison
+ * callbacks. Edge weights must be non-negative.
+ *
+ * Parents are left in search, so graph_path recovers the path found.
+ */
+int
+graph_radix_dijkstra_distance(graph_t *graph, graph_search_t *search, vertex_t *s, vertex_t *t);
+
+/**
+ * Same as graph_dijkstra_distance, on a pairing heap instead of the binary
+ * heap: decrease-key relinks a subtree in O(1) time instead of sifting,
+ * which pays off on dense graphs where most relaxations decrease the key
+ * of a vertex already in the heap.
+ *
+ * Parents are left in search, so graph_path recovers the path found.
+ */
+int
+graph_pairing_dijkstra_distance(graph_t *graph, graph_search_t *search, vertex_t *s, vertex_t *t);
+
+/**
+ * Same as graph_dijkstra_distance, also returning the path found.
+ *
+ * @param path list to which vertices of the path, from s to t, are
+ *        appended (optional)
+ * @return weight of the path, -1 if t is not reachable from s.
+ */
+long
+graph_dijkstra_path(graph_t *graph, graph_search_t *search, vertex_t *s, vertex_t *t, list_t *path);
+
+/**
+ * Appends to path vertices from the root of the search to t, following
+ * parents left in search by last query.
+ *
+ * @return number of vertices in the path, -1 if t was not reached.
+ */
+int
+graph_path(graph_t *graph, graph_search_t *search, vertex_t *t, list_t *path);
 
 bool
-graph_is_bipartite(graph_t *graph);
+graph_is_bipartite(graph_t *graph, graph_search_t *search);
 
 bool
-graph_negative_cycle(graph_t *graph);
-
+graph_negative_cycle(graph_t *graph, graph_search_t *search);
+
+/**
+ * Bellman-Ford single source shortest paths.
+ *
+ * Distances and parents are left in search, vertices reachable from
+ * a negative cycle get LONG_MIN distance.
+ */
 void
-graph_shortest_paths(graph_t *graph, vertex_t *s);
+graph_shortest_paths(graph_t *graph, graph_search_t *search, vertex_t *s);
 
+/**
+ * Prim minimum spanning tree from vertex 0, graph being undirected.
+ *
+ * @return cost of the tree, NAN on allocation failure.
+ */
+double
+graph_mst_prim_cost(graph_t *graph, graph_search_t *search);
+
+/**
+ * Same as graph_mst_prim_cost, on a pairing heap instead of the binary
+ * heap (see graph_pairing_dijkstra_distance).
+ *
+ * @return cost of a minimum spanning tree, NAN on allocation failure.
+ */
 double
-graph_mst_prim_cost(graph_t *graph);
+graph_pairing_mst_prim_cost(graph_t *graph, graph_search_t *search);
+
+/**
+ * Computes a minimum spanning forest on nthreads threads (<= 0 for
+ * number of online processors), the graph being made of nvertices
+ * vertices and nedges edges, whatever their direction.
+ *
+ * Parallel Boruvka on concurrent disjoint sets: every round, each
+ * component picks its lightest edge to another component (ties broken
+ * by index in edges), picked edges are united, and edges left inside a
+ * component are dropped. It's an O(m log(n)) work operation, usually
+ * much less since most edges are dropped in the first rounds.
+ *
+ * @param vertices array of vertices edges point to
+ * @param nvertices number of vertices
+ * @param edges edges of the graph (as in graph_max_distance_k_cluster)
+ * @param nedges number of edges
+ * @param nthreads number of threads
+ * @param msf receives edges of the forest, in the order they appear in
+ *        edges (optional, nvertices - 1 entries)
+ * @param cost receives total weight of the forest (optional)
+ * @return number of edges in the forest (nvertices - number of connected
+ *         components), -1 on allocation failure.
+ */
+long
+graph_msf(vertex_t *vertices, size_t nvertices, edge_t **edges, size_t nedges, int nthreads, edge_t **msf, double *cost);
+
+typedef struct graph_merge graph_merge_t;
+
+/**
+ * Merge of two clusters of a single-linkage dendrogram.
+ *
+ * Clusters 0 .. size - 1 are vertices, merge i creates cluster size + i.
+ */
+struct graph_merge {
+    int left;
+    int right;
+    long height;  /**< weight of the edge linking both clusters */
+    int size;     /**< number of vertices of cluster created */
+};
+
+typedef struct graph_dendrogram graph_dendrogram_t;
+
+/**
+ * Single-linkage clustering merge tree: merges are in order, heights
+ * non-decreasing. Disconnected graphs have size - nmerges root
+ * clusters.
+ */
+struct graph_dendrogram {
+    int size;
+    int nmerges;
+    graph_merge_t *merges;
+};
+
+/**
+ * Builds single-linkage dendrogram of a graph (same input as
+ * graph_max_distance_k_cluster), on nthreads threads (<= 0 for number
+ * of online processors).
+ *
+ * Single-linkage merges are Kruskal unions: edges of the minimum
+ * spanning forest (graph_msf) are sorted (parallel_sort) and replayed.
+ * Only forest edges are sorted, not every edge, and edges array is left
+ * unchanged.
+ *
+ * @return dendrogram object or NULL in case of error.
+ */
+graph_dendrogram_t *
+graph_dendrogram_build(vertex_t *vertices, size_t nvertices, edge_t **edges, size_t nedges, int nthreads);
+
+void
+graph_dendrogram_free(graph_dendrogram_t *dendrogram);
+
+/**
+ * Returns spacing of k-clustering, that is, smallest distance between
+ * two vertices in different clusters once only k clusters are left
+ * (same as graph_max_distance_k_cluster), LONG_MAX if clusters left
+ * are never linked. It's an O(1) time operation.
+ */
+long
+graph_dendrogram_spacing(graph_dendrogram_t *dendrogram, int k);
+
+/**
+ * Returns number of clusters left once every merge not higher than
+ * height is made. It's an O(log(n)) time operation.
+ */
+int
+graph_dendrogram_clusters(graph_dendrogram_t *dendrogram, long height);
+
+/**
+ * Labels vertices with their cluster once only k clusters are left
+ * (more if graph has more than k connected components). Clusters are
+ * numbered from 0 in order of their smallest vertex. It's an
+ * O(n a(n)) time operation.
+ *
+ * @param label size entries
+ * @return number of clusters.
+ */
+int
+graph_dendrogram_cut(graph_dendrogram_t *dendrogram, int k, int *label);
+
+/**
+ * Same as graph_dendrogram_cut, making every merge not higher than height.
+ */
+int
+graph_dendrogram_cut_height(graph_dendrogram_t *dendrogram, long height, int *label);
 
 double
 graph_max_distance_k_cluster(vertex_t *vertices, size_t nvertices, edge_t **edges, size_t nedges, int k);
 
+/**
+ * Returns new graph with every arc of graph reversed.
+ *
+ * Undirected edges, being arcs in both directions, show up reversed
+ * twice as directed edges.
+ */
+graph_t *
+graph_reverse(graph_t *graph);
+
+typedef enum graph_order graph_order_t;
+
+enum graph_order {
+    GRAPH_ORDER_RCM    = 0, /**< reverse Cuthill-McKee */
+    GRAPH_ORDER_DEGREE = 1, /**< decreasing degree */
+    GRAPH_ORDER_BFS    = 2  /**< breadth-first search visit order */
+};
+
+/**
+ * Computes a vertex ordering meant to improve locality of traversals.
+ *
+ * Adjacency is taken as stored, so edges of directed graphs are only
+ * followed from their source.
+ *
+ * - GRAPH_ORDER_BFS numbers vertices as breadth-first searches started
+ *   from every vertex not visited yet, in index order, reach them:
+ *   neighbors of a vertex get close indices.
+ * - GRAPH_ORDER_RCM is the same, every search starting from a vertex of
+ *   minimum degree found at the last level of a search from the lowest
+ *   degree vertex of its component (pseudo-peripheral vertex), visiting
+ *   neighbors by increasing degree, the whole numbering being reversed.
+ *   It keeps ends of edges close to each other (small bandwidth).
+ * - GRAPH_ORDER_DEGREE numbers vertices by decreasing degree, ties by
+ *   index, so that hubs most traversals go through share cache lines.
+ *
+ * @param perm array of graph->size entries, perm[v] being new index of
+ *        vertex v
+ * @return zero on success, -1 on allocation failure.
+ */
+int
+graph_ordering(graph_t *graph, graph_order_t order, int *perm);
+
+/**
+ * Returns new graph with vertex v of graph renumbered perm[v].
+ *
+ * Vertices and their data are moved to their new index and edges are
+ * allocated anew in order of new indices of their endpoints, so that
+ * a traversal following the new numbering walks memory forward. Every
+ * adjacency list is sorted by new index of neighbors.
+ *
+ * @param perm permutation of [0, graph->size) (see graph_ordering)
+ * @return graph or NULL on allocation failure.
+ */
+graph_t *
+graph_permute(graph_t *graph, const int *perm);
+
+/**
+ * Bidirectional Dijkstra, graph_r being graph_reverse(graph) (or graph
+ * itself when undirected).
+ *
+ * Vertices are inserted into the heaps only when first reached from s
+ * or t, and the search stops once no unsettled vertex can improve the
+ * best s-t path found.
+ *
+ * @return distance from s to t, LONG_MAX if unreachable, -1 on
+ *         allocation failure.
+ */
 long
-graph_bidirectional_dijkstra_distance(graph_t *graph, graph_t *graph_r, vertex_t *s, vertex_t *t);
+graph_bidirectional_dijkstra_distance(graph_t *graph, graph_t *graph_r, graph_search_t *search, graph_search_t *search_r, vertex_t *s, vertex_t *t);
+
+/**
+ * Answers connectivity queries over a sequence of edge additions and
+ * removals on size vertices, known in advance (offline).
+ *
+ * Operation at index k happens at time k. Every edge is alive during a
+ * time interval, from its addition to its removal (or the end). Intervals
+ * are mapped to the queries they span and stored in O(log(q)) nodes of a
+ * segment tree over queries. A depth-first traversal of the tree unites
+ * edges of every node on the way down, answers the query of every leaf
+ * reached and undoes unions of the node on the way up, using disjoint
+ * sets with rollback. It's an O((n + m) log(q) log(n) + q log(n)) time
+ * operation, m being number of edges added.
+ *
+ * Parallel edges are counted: u-v stays alive until it has been removed
+ * as many times as it was added. Removals of edges not alive are ignored.
+ *
+ * @param size number of vertices
+ * @param ops operations, in time order
+ * @param nops number of operations
+ * @param connected connected[k] is set for every query at index k
+ * @return 0 on success, -1 on allocation failure.
+ */
+int
+graph_dynamic_connectivity(int size, const connectivity_op_t *ops, size_t nops, bool *connected);
 
 #endif /* __GRAPH__H__ */
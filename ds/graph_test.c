@@ -0,0 +1,1264 @@
+#include "includes.h"
+#include "graph.h"
+#include "alt.h"
+#include "ch.h"
+#include "dynamic_sssp.h"
+#include "disjoint_sets.h"
+#include "parallel.h"
+
+static double
+now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ * Random operations: removals pick some edge added before, so that
+ * most of them hit an edge still alive.
+ */
+static connectivity_op_t *
+random_ops(int size, size_t nops)
+{
+    connectivity_op_t *ops = malloc(nops * sizeof(connectivity_op_t));
+    size_t nadded = 0;
+
+    for (size_t k = 0; k < nops; ++k) {
+        int r = rand() % 3;
+
+        if (CONNECTIVITY_REMOVE == r && nadded > 0) {
+            size_t a = rand() % k;
+            while (CONNECTIVITY_ADD != ops[a].type) {
+                a = rand() % k;
+            }
+            ops[k].type = CONNECTIVITY_REMOVE;
+            ops[k].u = rand() % 2 ? ops[a].u : ops[a].v;
+            ops[k].v = ops[k].u == ops[a].u ? ops[a].v : ops[a].u;
+        }
+        else {
+            ops[k].type = CONNECTIVITY_REMOVE == r ? CONNECTIVITY_ADD : r;
+            ops[k].u = rand() % size;
+            ops[k].v = rand() % size;
+            nadded += CONNECTIVITY_ADD == ops[k].type;
+        }
+    }
+    return ops;
+}
+
+/**
+ * Answers every query from scratch on edges alive at its time.
+ */
+static void
+brute_connectivity(int size, const connectivity_op_t *ops, size_t nops, bool *connected)
+{
+    int *count = calloc(size * size, sizeof(int));
+
+    for (size_t k = 0; k < nops; ++k) {
+        int u = ops[k].u < ops[k].v ? ops[k].u : ops[k].v;
+        int v = ops[k].u < ops[k].v ? ops[k].v : ops[k].u;
+
+        if (CONNECTIVITY_ADD == ops[k].type) {
+            count[u * size + v]++;
+        }
+        else if (CONNECTIVITY_REMOVE == ops[k].type) {
+            if (count[u * size + v] > 0) {
+                count[u * size + v]--;
+            }
+        }
+        else {
+            disjoint_sets_t *ds = disjoint_sets_new(size);
+            for (int i = 0; i < size * size; ++i) {
+                if (count[i] > 0) {
+                    disjoint_sets_union(ds, i / size, i % size);
+                }
+            }
+            connected[k] = disjoint_sets_find(ds, u) == disjoint_sets_find(ds, v);
+            disjoint_sets_free(ds);
+        }
+    }
+
+    free(count);
+}
+
+static void
+check_connectivity(int size, size_t nops)
+{
+    connectivity_op_t *ops = random_ops(size, nops);
+    bool *expected = calloc(nops, sizeof(bool));
+    bool *connected = calloc(nops, sizeof(bool));
+    bool ok;
+
+    brute_connectivity(size, ops, nops, expected);
+    ok = 0 == graph_dynamic_connectivity(size, ops, nops, connected) &&
+        0 == memcmp(expected, connected, nops * sizeof(bool));
+    printf("dynamic connectivity %d vertices %zu operations: %s\n", size, nops, ok ? "ok" : "FAILED");
+
+    free(ops);
+    free(expected);
+    free(connected);
+}
+
+static void
+bench_connectivity(int size, size_t nops)
+{
+    connectivity_op_t *ops = random_ops(size, nops);
+    bool *connected = calloc(nops, sizeof(bool));
+    double start = now();
+
+    graph_dynamic_connectivity(size, ops, nops, connected);
+    printf("dynamic connectivity %d vertices %zu operations: %.3fs\n", size, nops, now() - start);
+
+    free(ops);
+    free(connected);
+}
+
+static void
+edge_add(graph_t *graph, int u, int v, long weight, edge_flags_t flags)
+{
+    edge_t *edge = edge_new(&graph->vertices[u], &graph->vertices[v], flags);
+
+    edge->weight = weight;
+    vertex_edge_add(&graph->vertices[u], edge);
+    if (!(flags & EDGE_F_DIRECTED) && u != v) {
+        vertex_edge_add(&graph->vertices[v], edge);
+    }
+}
+
+/**
+ * Random graph, also returning its edges as pairs of endpoints.
+ */
+static graph_t *
+random_graph(int size, size_t nedges, int directed_percent, int **pairs)
+{
+    graph_t *graph = graph_new(size);
+
+    *pairs = malloc(2 * nedges * sizeof(int));
+    for (size_t k = 0; k < nedges; ++k) {
+        int u = rand() % size;
+        int v = rand() % size;
+        edge_add(graph, u, v, 1 + rand() % 100, rand() % 100 < directed_percent ? EDGE_F_DIRECTED : 0);
+        (*pairs)[2 * k] = u;
+        (*pairs)[2 * k + 1] = v;
+    }
+    return graph;
+}
+
+/**
+ * Labels components sequentially: label of a component is number of
+ * components with a smaller smallest vertex.
+ */
+static int
+expected_components(int size, const int *pairs, size_t npairs, int *label)
+{
+    disjoint_sets_t *ds = disjoint_sets_new(size);
+    int *id = malloc(size * sizeof(int));
+    int count = 0;
+
+    disjoint_sets_union_batch(ds, pairs, npairs, NULL);
+    for (int v = 0; v < size; ++v) {
+        id[v] = -1;
+    }
+    for (int v = 0; v < size; ++v) {
+        int root = disjoint_sets_find(ds, v);
+        if (-1 == id[root]) {
+            id[root] = count++;
+        }
+        label[v] = id[root];
+    }
+
+    free(id);
+    disjoint_sets_free(ds);
+    return count;
+}
+
+static void
+check_components(int size, size_t nedges, int directed_percent)
+{
+    int *pairs = NULL;
+    graph_t *graph = random_graph(size, nedges, directed_percent, &pairs);
+    int *expected = malloc(size * sizeof(int));
+    int *label = malloc(size * sizeof(int));
+    int *sizes = malloc(size * sizeof(int));
+    int count = expected_components(size, pairs, nedges, expected);
+
+    for (int nthreads = 1; nthreads <= 4; ++nthreads) {
+        bool ok = count == graph_components(graph, nthreads, label, sizes) &&
+            0 == memcmp(expected, label, size * sizeof(int));
+        int total = 0;
+
+        for (int c = 0; c < count && ok; ++c) {
+            total += sizes[c];
+        }
+        ok = ok && total == size && count == graph_connected_count(graph);
+        ok = ok && count == graph_components_edges(size, pairs, nedges, nthreads, label, NULL) &&
+            0 == memcmp(expected, label, size * sizeof(int));
+        printf("components %d vertices %zu edges %d%% directed threads %d: %s\n",
+               size, nedges, directed_percent, nthreads, ok ? "ok" : "FAILED");
+    }
+
+    free(pairs);
+    free(expected);
+    free(label);
+    free(sizes);
+    graph_free(graph);
+}
+
+static void
+bench_components(int size, size_t nedges)
+{
+    int *pairs = NULL;
+    graph_t *graph = random_graph(size, nedges, 0, &pairs);
+    int *label = malloc(size * sizeof(int));
+    int max_threads = parallel_threads(0);
+    disjoint_sets_t *ds = disjoint_sets_new(size);
+    double start = now();
+    double base;
+
+    disjoint_sets_union_batch(ds, pairs, nedges, NULL);
+    base = now() - start;
+    printf("sequential disjoint sets %d vertices %zu edges: %.3fs\n", size, nedges, base);
+
+    for (int nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+        double elapsed;
+        double elapsed_edges;
+        int count;
+
+        start = now();
+        count = graph_components(graph, nthreads, label, NULL);
+        elapsed = now() - start;
+        start = now();
+        graph_components_edges(size, pairs, nedges, nthreads, label, NULL);
+        elapsed_edges = now() - start;
+        printf("components %d vertices %zu edges (%d): %d threads graph %.3fs edges %.3fs\n",
+               size, nedges, count, nthreads, elapsed, elapsed_edges);
+
+        if (nthreads < max_threads && 2 * nthreads > max_threads) {
+            nthreads = max_threads / 2;
+        }
+    }
+
+    free(pairs);
+    free(label);
+    disjoint_sets_free(ds);
+    graph_free(graph);
+}
+
+static int
+edge_weight_cmp(const void *o1, const void *o2)
+{
+    const edge_t *e1 = *(edge_t * const *)o1;
+    const edge_t *e2 = *(edge_t * const *)o2;
+
+    return e1->weight < e2->weight ? -1 : e1->weight > e2->weight;
+}
+
+/**
+ * Kruskal: returns number of forest edges and its cost.
+ */
+static long
+kruskal(graph_t *graph, edge_t **edges, size_t nedges, double *cost)
+{
+    edge_t **sorted = malloc(nedges * sizeof(edge_t *));
+    disjoint_sets_t *ds = disjoint_sets_new(graph->size);
+    long count = 0;
+
+    memcpy(sorted, edges, nedges * sizeof(edge_t *));
+    qsort(sorted, nedges, sizeof(edge_t *), edge_weight_cmp);
+    *cost = 0.0;
+    for (size_t k = 0; k < nedges; ++k) {
+        if (disjoint_sets_union(ds, sorted[k]->endpoint1->index, sorted[k]->endpoint2->index)) {
+            *cost += sorted[k]->weight;
+            count++;
+        }
+    }
+
+    free(sorted);
+    disjoint_sets_free(ds);
+    return count;
+}
+
+/**
+ * Returns every edge of graph, undirected ones once.
+ */
+static edge_t **
+graph_edges(graph_t *graph, size_t *nedges)
+{
+    size_t capacity = 16;
+    edge_t **edges = malloc(capacity * sizeof(edge_t *));
+    size_t n = 0;
+
+    for (int u = 0; u < graph->size; ++u) {
+        node_t *node;
+        list_foreach(graph->vertices[u].edges, node) {
+            edge_t *edge = node_data(node);
+            if (edge->endpoint1 != &graph->vertices[u]) {
+                continue;
+            }
+            if (n == capacity) {
+                capacity *= 2;
+                edges = realloc(edges, capacity * sizeof(edge_t *));
+            }
+            edges[n++] = edge;
+        }
+    }
+    *nedges = n;
+    return edges;
+}
+
+static void
+check_msf(int size, size_t nedges)
+{
+    int *pairs = NULL;
+    graph_t *graph = random_graph(size, nedges, 0, &pairs);
+    edge_t **edges = graph_edges(graph, &nedges);
+    edge_t **msf = malloc(size * sizeof(edge_t *));
+    double expected;
+    long count = kruskal(graph, edges, nedges, &expected);
+
+    for (int nthreads = 1; nthreads <= 4; ++nthreads) {
+        disjoint_sets_t *ds = disjoint_sets_new(size);
+        double cost = -1.0;
+        double sum = 0.0;
+        bool ok = count == graph_msf(graph->vertices, size, edges, nedges, nthreads, msf, &cost) &&
+            cost == expected;
+
+        for (long k = 0; k < count && ok; ++k) {
+            sum += msf[k]->weight;
+            ok = disjoint_sets_union(ds, msf[k]->endpoint1->index, msf[k]->endpoint2->index);
+        }
+        ok = ok && sum == cost;
+        printf("msf %d vertices %zu edges threads %d: %s\n", size, nedges, nthreads, ok ? "ok" : "FAILED");
+        disjoint_sets_free(ds);
+    }
+
+    free(pairs);
+    free(edges);
+    free(msf);
+    graph_free(graph);
+}
+
+/**
+ * Checks both Prim variants against Kruskal on a random graph made
+ * connected by a path through all vertices (Prim only spans the
+ * component of vertex 0).
+ */
+static void
+check_prim(int size, size_t nedges)
+{
+    int *pairs = NULL;
+    graph_t *graph = random_graph(size, nedges, 0, &pairs);
+    graph_search_t *search = graph_search_new(size);
+    edge_t **edges;
+    double expected;
+    double cost;
+    bool ok;
+
+    for (int v = 1; v < size; ++v) {
+        edge_add(graph, v - 1, v, 1 + rand() % 100, 0);
+    }
+    edges = graph_edges(graph, &nedges);
+    ok = size - 1 == kruskal(graph, edges, nedges, &expected);
+    cost = graph_mst_prim_cost(graph, search);
+    ok = ok && cost == expected && cost == graph_pairing_mst_prim_cost(graph, search);
+    printf("prim %d vertices %zu edges: %s\n", size, nedges, ok ? "ok" : "FAILED");
+
+    graph_search_free(search);
+    free(pairs);
+    free(edges);
+    graph_free(graph);
+}
+
+static void
+bench_msf(int size, size_t nedges)
+{
+    int *pairs = NULL;
+    graph_t *graph = random_graph(size, nedges, 0, &pairs);
+    edge_t **edges = graph_edges(graph, &nedges);
+    int max_threads = parallel_threads(0);
+    double start = now();
+    double base;
+    double cost;
+
+    kruskal(graph, edges, nedges, &cost);
+    base = now() - start;
+    printf("kruskal %d vertices %zu edges: %.3fs\n", size, nedges, base);
+
+    for (int nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+        double elapsed;
+
+        start = now();
+        graph_msf(graph->vertices, size, edges, nedges, nthreads, NULL, &cost);
+        elapsed = now() - start;
+        printf("boruvka msf %d vertices %zu edges: %d threads %.3fs speedup %.2f\n",
+               size, nedges, nthreads, elapsed, base / elapsed);
+
+        if (nthreads < max_threads && 2 * nthreads > max_threads) {
+            nthreads = max_threads / 2;
+        }
+    }
+
+    free(pairs);
+    free(edges);
+    graph_free(graph);
+}
+
+static int
+long_cmp(const void *o1, const void *o2)
+{
+    long l1 = *(const long *)o1;
+    long l2 = *(const long *)o2;
+
+    return l1 < l2 ? -1 : l1 > l2;
+}
+
+static void
+check_parallel_sort(size_t n)
+{
+    long *expected = malloc(n * sizeof(long));
+    long *array = malloc(n * sizeof(long));
+
+    for (size_t k = 0; k < n; ++k) {
+        expected[k] = rand() % 1000;
+    }
+    qsort(expected, n, sizeof(long), long_cmp);
+    for (int nthreads = 1; nthreads <= 7; ++nthreads) {
+        memcpy(array, expected, n * sizeof(long));
+        for (size_t k = n; k > 1; --k) {
+            size_t j = rand() % k;
+            long t = array[k - 1];
+            array[k - 1] = array[j];
+            array[j] = t;
+        }
+        bool ok = 0 == parallel_sort(array, n, sizeof(long), long_cmp, nthreads) &&
+            0 == memcmp(expected, array, n * sizeof(long));
+        printf("parallel sort %zu elements threads %d: %s\n", n, nthreads, ok ? "ok" : "FAILED");
+    }
+
+    free(expected);
+    free(array);
+}
+
+/**
+ * Checks every k against graph_max_distance_k_cluster and a Kruskal
+ * stopped at k clusters.
+ */
+static void
+check_dendrogram(int size, size_t nedges)
+{
+    int *pairs = NULL;
+    graph_t *graph = random_graph(size, nedges, 0, &pairs);
+    edge_t **edges = graph_edges(graph, &nedges);
+    edge_t **sorted = malloc(nedges * sizeof(edge_t *));
+    int *label = malloc(size * sizeof(int));
+    int *expected = malloc(size * sizeof(int));
+    graph_dendrogram_t *dendrogram = graph_dendrogram_build(graph->vertices, size, edges, nedges, 0);
+    int components = graph_components(graph, 1, NULL, NULL);
+    bool ok = NULL != dendrogram && size - components == dendrogram->nmerges;
+
+    memcpy(sorted, edges, nedges * sizeof(edge_t *));
+    qsort(sorted, nedges, sizeof(edge_t *), edge_weight_cmp);
+
+    for (int k = size; k >= 1 && ok; --k) {
+        disjoint_sets_t *ds = disjoint_sets_new(size);
+        int clusters = size;
+        long spacing = LONG_MAX;
+        int count;
+
+        for (size_t i = 0; i < nedges; ++i) {
+            int u = sorted[i]->endpoint1->index;
+            int v = sorted[i]->endpoint2->index;
+            if (disjoint_sets_find(ds, u) != disjoint_sets_find(ds, v)) {
+                if (clusters == k) {
+                    spacing = sorted[i]->weight;
+                    break;
+                }
+                disjoint_sets_union(ds, u, v);
+                clusters--;
+            }
+        }
+        count = graph_dendrogram_cut(dendrogram, k, label);
+        ok = spacing == graph_dendrogram_spacing(dendrogram, k) && count == clusters;
+        if (LONG_MAX != spacing) {
+            ok = ok && spacing == graph_max_distance_k_cluster(graph->vertices, size, edges, nedges, k);
+        }
+
+        /**
+         * Same partition, both numbered by smallest vertex.
+         */
+        for (int v = 0; v < size; ++v) {
+            expected[v] = -1;
+        }
+        for (int v = 0, n = 0; v < size && ok; ++v) {
+            int root = disjoint_sets_find(ds, v);
+            if (-1 == expected[root]) {
+                expected[root] = n++;
+            }
+            ok = label[v] == expected[root];
+        }
+        disjoint_sets_free(ds);
+    }
+
+    for (int k = 0; k < dendrogram->nmerges && ok; ++k) {
+        long height = dendrogram->merges[k].height;
+        ok = graph_dendrogram_clusters(dendrogram, height) == graph_dendrogram_cut_height(dendrogram, height, label) &&
+            graph_dendrogram_clusters(dendrogram, height) <= size - k - 1;
+    }
+    printf("dendrogram %d vertices %zu edges: %s\n", size, nedges, ok ? "ok" : "FAILED");
+
+    graph_dendrogram_free(dendrogram);
+    free(pairs);
+    free(edges);
+    free(sorted);
+    free(label);
+    free(expected);
+    graph_free(graph);
+}
+
+static void
+bench_dendrogram(int size, size_t nedges)
+{
+    int *pairs = NULL;
+    graph_t *graph = random_graph(size, nedges, 0, &pairs);
+    edge_t **edges = graph_edges(graph, &nedges);
+    graph_dendrogram_t *dendrogram;
+    double start = now();
+
+    graph_max_distance_k_cluster(graph->vertices, size, edges, nedges, size / 2);
+    printf("k-cluster spacing %d vertices %zu edges: %.3fs\n", size, nedges, now() - start);
+
+    start = now();
+    dendrogram = graph_dendrogram_build(graph->vertices, size, edges, nedges, 0);
+    printf("dendrogram %d vertices %zu edges: %.3fs, %d merges\n", size, nedges, now() - start, dendrogram->nmerges);
+
+    graph_dendrogram_free(dendrogram);
+    free(pairs);
+    free(edges);
+    graph_free(graph);
+}
+
+/**
+ * A single long path used to overflow the stack of the recursive search.
+ */
+static void
+check_path(int size)
+{
+    graph_t *graph = graph_new(size);
+    int *label = malloc(size * sizeof(int));
+    int *sizes = malloc(size * sizeof(int));
+    bool ok;
+
+    for (int v = 1; v < size; ++v) {
+        edge_add(graph, v - 1, v, 1, 0);
+    }
+    ok = 1 == graph_components(graph, 0, label, sizes) && size == sizes[0] && 0 == label[size - 1];
+    printf("components path of %d vertices: %s\n", size, ok ? "ok" : "FAILED");
+
+    free(label);
+    free(sizes);
+    graph_free(graph);
+}
+
+/**
+ * Checks Dijkstra variants against graph_dijkstra_distance on random
+ * queries, and that graph_dijkstra_path appends the path from s to t
+ * after vertices already in the list, each one being parent of the next.
+ */
+static void
+check_dijkstra(int size, size_t nedges, int directed_percent, int nqueries)
+{
+    int *pairs = NULL;
+    graph_t *graph = random_graph(size, nedges, directed_percent, &pairs);
+    graph_t *graph_r = 0 == directed_percent ? graph : graph_reverse(graph);
+    graph_search_t *search = graph_search_new(size);
+    graph_search_t *search_r = graph_search_new(size);
+    bool ok = NULL != graph_r;
+
+    for (int q = 0; ok && q < nqueries; ++q) {
+        vertex_t *s = &graph->vertices[rand() % size];
+        vertex_t *t = &graph->vertices[rand() % size];
+        long expected = graph_dijkstra_distance(graph, search, s, t);
+        long bidirectional = graph_bidirectional_dijkstra_distance(graph, graph_r, search, search_r, s, t);
+
+        list_t *path = list_new();
+        node_t *node;
+        vertex_t *u = NULL;
+
+        ok = expected == (LONG_MAX == bidirectional ? -1 : bidirectional) &&
+            expected == graph_radix_dijkstra_distance(graph, search, s, t) &&
+            expected == graph_pairing_dijkstra_distance(graph, search, s, t);
+
+        list_push_back(path, t);
+        ok = ok && expected == graph_dijkstra_path(graph, search, s, t, path) &&
+            t == node_data(list_head(path));
+        if (ok && -1 != expected) {
+            node = list_next(path, list_head(path));
+            ok = NULL != node && s == node_data(node) && t == node_data(list_tail(path));
+            for (; ok && NULL != node; node = list_next(path, node)) {
+                vertex_t *v = node_data(node);
+                ok = (NULL == u ? -1 : (int)u->index) == graph_search_vertex(search, v->index)->parent;
+                u = v;
+            }
+        }
+        list_free(path);
+    }
+
+    printf("dijkstra variants size %d edges %zu directed %d%%: %s\n",
+           size, nedges, directed_percent, ok ? "ok" : "FAILED");
+
+    graph_search_free(search);
+    graph_search_free(search_r);
+    if (NULL != graph_r && graph != graph_r) {
+        graph_free(graph_r);
+    }
+    graph_free(graph);
+    free(pairs);
+}
+
+static weight_update_t *
+random_updates(edge_t **edges, size_t nedges, size_t nupdates)
+{
+    weight_update_t *updates = malloc(nupdates * sizeof(weight_update_t));
+
+    for (size_t k = 0; k < nupdates; ++k) {
+        updates[k].edge = edges[rand() % nedges];
+        switch (rand() % 4) {
+        case 0:
+            updates[k].weight = 0;
+            break;
+        case 1:
+            updates[k].weight = updates[k].edge->weight * 2 + 1;
+            break;
+        default:
+            updates[k].weight = 1 + rand() % 100;
+            break;
+        }
+    }
+    return updates;
+}
+
+/**
+ * Checks distances against Bellman-Ford from scratch after every batch,
+ * and that every parent edge is tight.
+ */
+static void
+check_dynamic_sssp(int size, size_t nedges, int directed_percent, size_t nupdates)
+{
+    int *pairs = NULL;
+    graph_t *graph = random_graph(size, nedges, directed_percent, &pairs);
+    edge_t **edges = graph_edges(graph, &nedges);
+    graph_search_t *search = graph_search_new(size);
+    dynamic_sssp_t *sssp = dynamic_sssp_new(graph, &graph->vertices[0]);
+    weight_update_t negative = { edges[0], -1 };
+    long touched = 0;
+    bool ok = NULL != sssp && -1 == dynamic_sssp_update(sssp, &negative, 1);
+
+    for (int round = 0; ok && round < 50; ++round) {
+        weight_update_t *updates = random_updates(edges, nedges, nupdates);
+        long n = dynamic_sssp_update(sssp, updates, nupdates);
+
+        ok = n >= 0 && n <= size;
+        touched += n;
+
+        graph_shortest_paths(graph, search, &graph->vertices[0]);
+        for (int v = 0; ok && v < size; ++v) {
+            edge_t *edge = sssp->parent_edge[v];
+            int u = sssp->parent[v];
+
+            ok = graph_search_distance(search, v) == sssp->distance[v];
+            if (0 == v || LONG_MAX == sssp->distance[v]) {
+                ok = ok && -1 == u && NULL == edge;
+            }
+            else {
+                ok = ok && -1 != u && NULL != edge &&
+                    &graph->vertices[v] == edge_pair_get(edge, &graph->vertices[u]) &&
+                    (!edge->directed || edge->endpoint1 == &graph->vertices[u]) &&
+                    sssp->distance[u] + edge->weight == sssp->distance[v];
+            }
+        }
+        free(updates);
+    }
+
+    printf("dynamic sssp size %d edges %zu directed %d%% batch %zu: %ld touched: %s\n",
+           size, nedges, directed_percent, nupdates, touched, ok ? "ok" : "FAILED");
+
+    dynamic_sssp_free(sssp);
+    graph_search_free(search);
+    free(edges);
+    free(pairs);
+}
+
+static void
+bench_dynamic_sssp(int size, size_t nedges)
+{
+    int *pairs = NULL;
+    graph_t *graph = random_graph(size, nedges, 50, &pairs);
+    edge_t **edges = graph_edges(graph, &nedges);
+    double start = now();
+    dynamic_sssp_t *sssp = dynamic_sssp_new(graph, &graph->vertices[0]);
+    size_t batches[] = { 1, 10, 100, 1000 };
+
+    printf("dynamic sssp %d vertices %zu edges: from scratch %.3fs\n", size, nedges, now() - start);
+
+    for (int i = 0; i < countof(batches); ++i) {
+        weight_update_t *updates = random_updates(edges, nedges, batches[i]);
+        long touched;
+
+        start = now();
+        touched = dynamic_sssp_update(sssp, updates, batches[i]);
+        printf("dynamic sssp batch of %zu updates: %ld vertices touched %.6fs\n",
+               batches[i], touched, now() - start);
+        free(updates);
+    }
+
+    dynamic_sssp_free(sssp);
+    free(edges);
+    free(pairs);
+}
+
+/**
+ * Grid graph of width x height vertices, edges to right and bottom
+ * neighbors (some of them one-way), road network like.
+ */
+static graph_t *
+grid_graph(int width, int height, int directed_percent)
+{
+    graph_t *graph = graph_new(width * height);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int u = y * width + x;
+            if (x + 1 < width) {
+                bool directed = rand() % 100 < directed_percent;
+                if (directed && rand() % 2) {
+                    edge_add(graph, u + 1, u, 1 + rand() % 100, EDGE_F_DIRECTED);
+                }
+                else {
+                    edge_add(graph, u, u + 1, 1 + rand() % 100, directed ? EDGE_F_DIRECTED : 0);
+                }
+            }
+            if (y + 1 < height) {
+                bool directed = rand() % 100 < directed_percent;
+                if (directed && rand() % 2) {
+                    edge_add(graph, u + width, u, 1 + rand() % 100, EDGE_F_DIRECTED);
+                }
+                else {
+                    edge_add(graph, u, u + width, 1 + rand() % 100, directed ? EDGE_F_DIRECTED : 0);
+                }
+            }
+        }
+    }
+    return graph;
+}
+
+static size_t
+settled_count(graph_search_t *search)
+{
+    size_t count = 0;
+
+    for (int i = 0; i < search->size; ++i) {
+        count += graph_search_vertex(search, i)->visited;
+    }
+    return count;
+}
+
+/**
+ * Compares unidirectional and bidirectional ALT against Dijkstra on
+ * random queries, printing average settled vertices of each.
+ */
+static void
+check_alt(graph_t *graph, int directed_percent, int nlandmarks, alt_selection_t selection, int nqueries)
+{
+    int size = graph->size;
+    graph_t *graph_r = 0 == directed_percent ? graph : graph_reverse(graph);
+    graph_search_t *search = graph_search_new(size);
+    graph_search_t *search_r = graph_search_new(size);
+    double start = now();
+    alt_t *alt = alt_build(graph, graph_r, nlandmarks, selection, 4);
+    double elapsed = now() - start;
+    size_t settled[3] = { 0, 0, 0 };
+    bool ok = NULL != alt;
+
+    for (int q = 0; ok && q < nqueries; ++q) {
+        int s = rand() % size;
+        int t = rand() % size;
+        long expected = graph_dijkstra_distance(graph, search, &graph->vertices[s], &graph->vertices[t]);
+
+        settled[0] += settled_count(search);
+        ok = expected == alt_distance(alt, search, s, t);
+        settled[1] += settled_count(search);
+        ok = ok && expected == alt_bidirectional_distance(alt, search, search_r, s, t);
+        settled[2] += settled_count(search) + settled_count(search_r);
+        ok = ok && (-1 == expected || alt_bound(alt, s, t) <= expected);
+    }
+
+    printf("alt %d vertices directed %d%% %d landmarks %s: preprocessing %.3fs, "
+           "settled dijkstra %zu, a* %zu, bidirectional a* %zu: %s\n",
+           size, directed_percent, nlandmarks, ALT_AVOID == selection ? "avoid" : "farthest", elapsed,
+           settled[0] / nqueries, settled[1] / nqueries, settled[2] / nqueries, ok ? "ok" : "FAILED");
+
+    alt_free(alt);
+    if (graph_r != graph) {
+        graph_free(graph_r);
+    }
+    graph_search_free(search);
+    graph_search_free(search_r);
+}
+
+/**
+ * Avoid selection must not degenerate into farthest selection: on a
+ * connected undirected graph both must pick different landmarks.
+ */
+static void
+check_alt_selection(graph_t *graph, int nlandmarks)
+{
+    alt_t *avoid = alt_build(graph, graph, nlandmarks, ALT_AVOID, 4);
+    alt_t *farthest = alt_build(graph, graph, nlandmarks, ALT_FARTHEST, 4);
+    bool ok = NULL != avoid && NULL != farthest &&
+        0 != memcmp(avoid->landmarks, farthest->landmarks, nlandmarks * sizeof(int));
+
+    printf("alt %d vertices %d landmarks avoid differs from farthest: %s\n",
+           graph->size, nlandmarks, ok ? "ok" : "FAILED");
+
+    alt_free(avoid);
+    alt_free(farthest);
+}
+
+/**
+ * Checks many-to-many table against bidirectional Dijkstra on every pair,
+ * timing both and the table computed with a single thread.
+ */
+static void
+check_many_to_many(graph_t *graph, int directed_percent, size_t nsources, size_t ntargets)
+{
+    int size = graph->size;
+    graph_t *graph_r = 0 == directed_percent ? graph : graph_reverse(graph);
+    graph_search_t *search = graph_search_new(size);
+    graph_search_t *search_r = graph_search_new(size);
+    int *sources = malloc(nsources * sizeof(int));
+    int *targets = malloc(ntargets * sizeof(int));
+    long *table = malloc((0 != nsources * ntargets ? nsources * ntargets : 1) * sizeof(long));
+    double start = now();
+    ch_t *ch = ch_build(graph, 4);
+    double elapsed[4] = { now() - start, 0, 0, 0 };
+    bool ok = NULL != ch;
+
+    for (size_t i = 0; i < nsources; ++i) {
+        sources[i] = rand() % size;
+    }
+    for (size_t j = 0; j < ntargets; ++j) {
+        targets[j] = rand() % size;
+    }
+
+    start = now();
+    ok = ok && 0 == ch_many_to_many(ch, sources, nsources, targets, ntargets, 1, table);
+    elapsed[1] = now() - start;
+
+    start = now();
+    for (size_t i = 0; ok && i < nsources; ++i) {
+        for (size_t j = 0; ok && j < ntargets; ++j) {
+            long expected = graph_bidirectional_dijkstra_distance(graph, graph_r, search, search_r,
+                                                                  &graph->vertices[sources[i]], &graph->vertices[targets[j]]);
+            ok = table[i * ntargets + j] == (LONG_MAX == expected ? -1 : expected);
+        }
+    }
+    elapsed[2] = now() - start;
+
+    memset(table, 0, nsources * ntargets * sizeof(long));
+    start = now();
+    ok = ok && 0 == ch_many_to_many(ch, sources, nsources, targets, ntargets, 4, table);
+    elapsed[3] = now() - start;
+
+    for (size_t i = 0; ok && i < nsources; ++i) {
+        for (size_t j = 0; ok && j < ntargets; ++j) {
+            ok = table[i * ntargets + j] == ch_distance(ch, search, search_r, sources[i], targets[j]);
+        }
+    }
+
+    printf("many to many %d vertices directed %d%% %zux%zu: preprocessing %.3fs, "
+           "table %.3fs (%.3fs on 4 threads), pairwise dijkstra %.3fs: %s\n",
+           size, directed_percent, nsources, ntargets, elapsed[0],
+           elapsed[1], elapsed[3], elapsed[2], ok ? "ok" : "FAILED");
+
+    ch_free(ch);
+    if (graph_r != graph) {
+        graph_free(graph_r);
+    }
+    graph_search_free(search);
+    graph_search_free(search_r);
+    free(sources);
+    free(targets);
+    free(table);
+}
+
+/**
+ * Weight of the lightest arc u -> v, LONG_MAX if there is none.
+ */
+static long
+arc_weight(graph_t *graph, int u, int v)
+{
+    long weight = LONG_MAX;
+    node_t *node;
+
+    list_foreach(graph->vertices[u].edges, node) {
+        edge_t *edge = node_data(node);
+        if (edge_pair_get(edge, &graph->vertices[u]) == &graph->vertices[v] &&
+            (!edge->directed || edge->endpoint1 == &graph->vertices[u]) && edge->weight < weight) {
+            weight = edge->weight;
+        }
+    }
+    return weight;
+}
+
+/**
+ * Overwrites int at pos of file.
+ */
+static bool
+file_patch_int(const char *filename, long pos, int value)
+{
+    FILE *f = fopen(filename, "r+b");
+    bool ok;
+
+    if (NULL == f) {
+        return false;
+    }
+    ok = 0 == fseek(f, pos, SEEK_SET) && 1 == fwrite(&value, sizeof(int), 1, f);
+    return 0 == fclose(f) && ok;
+}
+
+/**
+ * Checks unpacked paths of a contraction hierarchy run from s to t along
+ * arcs of graph and weigh the distance, then saves and loads it back.
+ */
+static void
+check_ch_path(graph_t *graph, int directed_percent, int nqueries)
+{
+    char filename[] = "/tmp/graph_test.XXXXXX";
+    int size = graph->size;
+    graph_t *graph_r = 0 == directed_percent ? graph : graph_reverse(graph);
+    graph_search_t *search = graph_search_new(size);
+    graph_search_t *search_r = graph_search_new(size);
+    ch_t *ch = ch_build(graph, 4);
+    ch_t *loaded = NULL;
+    int fd = mkstemp(filename);
+    bool ok = NULL != ch;
+
+    close(fd);
+
+    for (int k = 0; ok && k < nqueries; ++k) {
+        int s = rand() % size;
+        int t = rand() % size;
+        long expected = graph_bidirectional_dijkstra_distance(graph, graph_r, search, search_r,
+                                                              &graph->vertices[s], &graph->vertices[t]);
+        array_t *path = array_new(16, sizeof(int));
+        long distance = ch_path(ch, search, search_r, s, t, path);
+        long weight = 0;
+
+        ok = distance == (LONG_MAX == expected ? -1 : expected);
+        if (distance < 0) {
+            ok = ok && 0 == array_size(path);
+            array_free(path);
+            continue;
+        }
+        ok = ok && array_size(path) > 0 && s == *(int *)array_front(path) && t == *(int *)array_back(path);
+        for (size_t i = 1; ok && i < array_size(path); ++i) {
+            long w = arc_weight(graph, *(int *)array_get(path, i - 1), *(int *)array_get(path, i));
+            ok = LONG_MAX != w;
+            weight += w;
+        }
+        ok = ok && weight == distance;
+        array_free(path);
+    }
+
+    ok = ok && 0 == ch_save(ch, filename) && NULL != (loaded = ch_load(filename));
+    for (int k = 0; ok && k < nqueries; ++k) {
+        int s = rand() % size;
+        int t = rand() % size;
+        ok = ch_distance(ch, search, search_r, s, t) == ch_distance(loaded, search, search_r, s, t);
+    }
+
+    /**
+     * Duplicate rank and out of range target are rejected, ranks start
+     * after magic, version and size, first upward target after ranks,
+     * arc count and offsets.
+     */
+    ok = ok && file_patch_int(filename, 3 * sizeof(int) + sizeof(int), ch->rank[0]) &&
+        NULL == ch_load(filename);
+    ok = ok && 0 == ch_save(ch, filename) &&
+        (0 == ch->up->nedges ||
+         (file_patch_int(filename, (3 + size) * sizeof(int) + (size + 2) * sizeof(size_t), size) &&
+          NULL == ch_load(filename)));
+
+    printf("contraction hierarchy path and file %d vertices directed %d%%: %s\n",
+           size, directed_percent, ok ? "ok" : "FAILED");
+
+    unlink(filename);
+    if (NULL != loaded) {
+        ch_free(loaded);
+    }
+    if (NULL != ch) {
+        ch_free(ch);
+    }
+    if (graph_r != graph) {
+        graph_free(graph_r);
+    }
+    graph_search_free(search);
+    graph_search_free(search_r);
+}
+
+static const char *
+order_name(graph_order_t order)
+{
+    switch (order) {
+    case GRAPH_ORDER_RCM:
+        return "rcm";
+    case GRAPH_ORDER_DEGREE:
+        return "degree";
+    default:
+        return "bfs";
+    }
+}
+
+/**
+ * Returns a random permutation of [0, size).
+ */
+static int *
+random_permutation(int size)
+{
+    int *perm = malloc((size ? size : 1) * sizeof(int));
+
+    for (int v = 0; v < size; ++v) {
+        perm[v] = v;
+    }
+    for (int v = size - 1; v > 0; --v) {
+        int w = rand() % (v + 1);
+        int tmp = perm[v];
+        perm[v] = perm[w];
+        perm[w] = tmp;
+    }
+    return perm;
+}
+
+/**
+ * Returns average distance between indices of endpoints of edges.
+ */
+static double
+average_span(graph_t *graph)
+{
+    double span = 0;
+    size_t count = 0;
+
+    for (int u = 0; u < graph->size; ++u) {
+        node_t *node = NULL;
+        list_foreach(graph->vertices[u].edges, node) {
+            int v = edge_pair_get(node_data(node), &graph->vertices[u])->index;
+            span += abs(u - v);
+            count++;
+        }
+    }
+    return count ? span / count : 0;
+}
+
+/**
+ * Checks graph renumbered by every ordering: perm must be a permutation,
+ * adjacency lists sorted, and distances between random pairs unchanged.
+ */
+static void
+check_ordering(graph_t *graph, int nqueries)
+{
+    int size = graph->size;
+    int *perm = malloc((size ? size : 1) * sizeof(int));
+    bool *seen = malloc((size ? size : 1) * sizeof(bool));
+    graph_search_t *search = graph_search_new(size);
+    graph_order_t orders[] = { GRAPH_ORDER_RCM, GRAPH_ORDER_DEGREE, GRAPH_ORDER_BFS };
+
+    for (size_t o = 0; o < countof(orders); ++o) {
+        graph_t *graph_p = NULL;
+        bool ok = 0 == graph_ordering(graph, orders[o], perm);
+
+        memset(seen, 0, size * sizeof(bool));
+        for (int v = 0; ok && v < size; ++v) {
+            ok = perm[v] >= 0 && perm[v] < size && !seen[perm[v]];
+            seen[ok ? perm[v] : 0] = true;
+        }
+        ok = ok && NULL != (graph_p = graph_permute(graph, perm));
+
+        for (int u = 0; ok && u < size; ++u) {
+            node_t *node = NULL;
+            int previous = -1;
+            list_foreach(graph_p->vertices[u].edges, node) {
+                int v = edge_pair_get(node_data(node), &graph_p->vertices[u])->index;
+                ok = ok && previous <= v;
+                previous = v;
+            }
+        }
+
+        for (int q = 0; ok && q < nqueries; ++q) {
+            int s = rand() % size;
+            int t = rand() % size;
+            long expected = graph_dijkstra_distance(graph, search, &graph->vertices[s], &graph->vertices[t]);
+            ok = expected == graph_dijkstra_distance(graph_p, search, &graph_p->vertices[perm[s]], &graph_p->vertices[perm[t]]);
+        }
+
+        printf("ordering %s %d vertices: span %.1f -> %.1f: %s\n", order_name(orders[o]), size,
+               average_span(graph), NULL != graph_p ? average_span(graph_p) : 0, ok ? "ok" : "FAILED");
+        graph_free(graph_p);
+    }
+
+    graph_search_free(search);
+    free(perm);
+    free(seen);
+}
+
+/**
+ * Times traversals of a grid whose vertices are numbered at random, then
+ * of the same grid renumbered by every ordering.
+ */
+static void
+bench_ordering(int width, int height)
+{
+    graph_t *grid = grid_graph(width, height, 0);
+    int *shuffle = random_permutation(grid->size);
+    graph_t *graph = graph_permute(grid, shuffle);
+    int *perm = malloc(graph->size * sizeof(int));
+    graph_search_t *search = graph_search_new(graph->size);
+    graph_order_t orders[] = { GRAPH_ORDER_RCM, GRAPH_ORDER_DEGREE, GRAPH_ORDER_BFS };
+    int s = shuffle[0];
+    int t = shuffle[grid->size - 1];
+    double start = now();
+    double base[2];
+
+    graph_free(grid);
+
+    graph_distance(graph, search, &graph->vertices[s], &graph->vertices[t]);
+    base[0] = now() - start;
+    start = now();
+    graph_dijkstra_distance(graph, search, &graph->vertices[s], &graph->vertices[t]);
+    base[1] = now() - start;
+    printf("random order %d vertices: span %.1f, bfs %.3fs, dijkstra %.3fs\n",
+           graph->size, average_span(graph), base[0], base[1]);
+
+    for (size_t o = 0; o < countof(orders); ++o) {
+        graph_t *graph_p = NULL;
+        double elapsed[3];
+
+        start = now();
+        graph_ordering(graph, orders[o], perm);
+        graph_p = graph_permute(graph, perm);
+        elapsed[0] = now() - start;
+
+        start = now();
+        graph_distance(graph_p, search, &graph_p->vertices[perm[s]], &graph_p->vertices[perm[t]]);
+        elapsed[1] = now() - start;
+        start = now();
+        graph_dijkstra_distance(graph_p, search, &graph_p->vertices[perm[s]], &graph_p->vertices[perm[t]]);
+        elapsed[2] = now() - start;
+
+        printf("%s order %d vertices: reordering %.3fs, span %.1f, bfs %.3fs speedup %.2f, "
+               "dijkstra %.3fs speedup %.2f\n", order_name(orders[o]), graph_p->size, elapsed[0],
+               average_span(graph_p), elapsed[1], base[0] / elapsed[1], elapsed[2], base[1] / elapsed[2]);
+        graph_free(graph_p);
+    }
+
+    graph_search_free(search);
+    graph_free(graph);
+    free(shuffle);
+    free(perm);
+}
+
+int main(int argc, char **argv)
+{
+    int size = argc > 1 ? atoi(argv[1]) : 1 << 20;
+
+    srand(1);
+
+    check_connectivity(2, 10);
+    check_connectivity(10, 100);
+    check_connectivity(30, 2000);
+    check_connectivity(200, 3000);
+
+    check_components(1, 0, 0);
+    check_components(100, 60, 0);
+    check_components(1000, 700, 50);
+    check_components(20000, 30000, 10);
+    check_path(1 << 20);
+
+    check_dijkstra(1, 0, 0, 10);
+    check_dijkstra(100, 300, 0, 200);
+    check_dijkstra(2000, 6000, 50, 500);
+    check_dijkstra(5000, 8000, 100, 500);
+
+    check_msf(1, 0);
+    check_msf(100, 50);
+    check_msf(1000, 3000);
+    check_msf(20000, 100000);
+    check_prim(1, 0);
+    check_prim(100, 50);
+    check_prim(5000, 20000);
+
+    check_parallel_sort(0);
+    check_parallel_sort(5);
+    check_parallel_sort(10000);
+    check_dendrogram(1, 0);
+    check_dendrogram(50, 40);
+    check_dendrogram(300, 600);
+
+    check_dynamic_sssp(1, 1, 0, 1);
+    check_dynamic_sssp(50, 100, 0, 1);
+    check_dynamic_sssp(200, 600, 100, 5);
+    check_dynamic_sssp(500, 1500, 30, 20);
+
+    {
+        int *pairs = NULL;
+        graph_t *graph = random_graph(2000, 3000, 50, &pairs);
+        check_alt(graph, 50, 8, ALT_AVOID, 200);
+        check_alt(graph, 50, 8, ALT_FARTHEST, 200);
+        graph_free(graph);
+        free(pairs);
+        graph = grid_graph(50, 40, 0);
+        check_alt(graph, 0, 1, ALT_FARTHEST, 200);
+        check_alt(graph, 0, 16, ALT_AVOID, 200);
+        check_alt_selection(graph, 8);
+        graph_free(graph);
+        graph = grid_graph(300, 300, 20);
+        check_alt(graph, 20, 16, ALT_FARTHEST, 100);
+        check_alt(graph, 20, 16, ALT_AVOID, 100);
+        graph_free(graph);
+        graph = grid_graph(100, 100, 20);
+        check_many_to_many(graph, 20, 40, 50);
+        check_ch_path(graph, 20, 300);
+        graph_free(graph);
+        graph = grid_graph(1, 1, 0);
+        check_many_to_many(graph, 0, 3, 2);
+        graph_free(graph);
+        graph = random_graph(2000, 3000, 50, &pairs);
+        check_many_to_many(graph, 50, 100, 100);
+        check_many_to_many(graph, 50, 0, 10);
+        check_ch_path(graph, 50, 300);
+        graph_free(graph);
+        free(pairs);
+    }
+
+    {
+        int *pairs = NULL;
+        graph_t *graph = random_graph(3000, 6000, 30, &pairs);
+        check_ordering(graph, 200);
+        graph_free(graph);
+        free(pairs);
+        graph = grid_graph(60, 50, 0);
+        check_ordering(graph, 200);
+        graph_free(graph);
+        graph = graph_new(0);
+        check_ordering(graph, 0);
+        graph_free(graph);
+    }
+
+    bench_connectivity(size, 3 * (size_t)size);
+    bench_components(size, 4 * (size_t)size);
+    bench_msf(size, 4 * (size_t)size);
+    bench_dendrogram(size, 4 * (size_t)size);
+    bench_dynamic_sssp(size, 4 * (size_t)size);
+    bench_ordering((int)sqrt(size), (int)sqrt(size));
+
+    return 0;
+}
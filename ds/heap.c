@@ -9,6 +9,7 @@
 
 struct heap {
     array_t *array;
+    size_t arity;
     heap_cmp_t cmp;
     heap_release_t release;
     heap_update_t update;
@@ -20,14 +21,21 @@ struct heap {
  * One might store pointer to objects or the objects themselves
  * in the heap array.
  *
+ * Children of i-th element are elements d * i + 1 .. d * i + d,
+ * d being heap arity.
  */
 
-#define parent(i) (((i) - 1) >> 1)
-#define left_child(i) (((i) << 1) + 1)
-#define right_child(i) (((i) + 1) << 1)
+#define parent(h, i) (((i) - 1) / (h)->arity)
+#define first_child(h, i) ((h)->arity * (i) + 1)
+
+static inline size_t
+heap_arity(size_t arity)
+{
+    return arity < 2 ? 2 : arity;
+}
 
 heap_t *
-heap_new(size_t capacity, size_t item_size, heap_cmp_t cmp, heap_release_t release, heap_update_t update)
+heap_new(size_t capacity, size_t item_size, size_t arity, heap_cmp_t cmp, heap_release_t release, heap_update_t update)
 {
     heap_t *h = calloc(1, sizeof(heap_t));
 
@@ -40,6 +48,7 @@ heap_new(size_t capacity, size_t item_size, heap_cmp_t cmp, heap_release_t relea
         free(h);
         return NULL;
     }
+    h->arity = heap_arity(arity);
     h->cmp = cmp;
     h->release = release;
     h->update = update;
@@ -52,8 +61,8 @@ heap_free(heap_t *h)
 {
     if (h->array) {
         if (h->release) {
-            void *c, *n;
-            array_foreach_safe(h->array, c, n) { 
+            void *c;
+            array_foreach(h->array, c) {
                 h->release(c);
             }
             h->release = NULL;
@@ -80,36 +89,27 @@ heap_swap(heap_t *h, int i, int j)
 static void
 sift_down(heap_t *heap, size_t i)
 {
-    size_t l;
-    size_t r;
-    size_t winner;
-
-    l = left_child(i);
-    r = right_child(i);
+    size_t n = array_size(heap->array);
+    size_t c = first_child(heap, i);
 
-    while (l < array_size(heap->array)) {
+    while (c < n) {
+        size_t last = c + heap->arity < n ? c + heap->arity : n;
+        size_t winner = c;
 
-        winner = l;
-
-        if (r < array_size(heap->array) && heap->cmp(array_get(heap->array, r), array_get(heap->array, winner))) {
-            winner = r;
-        }
-
-        if (heap->cmp(array_get(heap->array, winner), array_get(heap->array, i))) {
-            heap_swap(heap, winner, i);
-        }
-        else {
-            winner = i;
+        for (++c; c < last; ++c) {
+            if (heap->cmp(array_get(heap->array, c), array_get(heap->array, winner))) {
+                winner = c;
+            }
         }
 
-        if (winner == i) {
+        if (!heap->cmp(array_get(heap->array, winner), array_get(heap->array, i))) {
             break;
         }
 
+        heap_swap(heap, winner, i);
+
         i = winner;
-    
-        l = left_child(i);
-        r = right_child(i);
+        c = first_child(heap, i);
     }
 }
 
@@ -117,7 +117,7 @@ static void
 sift_up(heap_t *heap, size_t i)
 {
     while (i > 0) {
-        size_t p = parent(i);
+        size_t p = parent(heap, i);
         
         if (heap->cmp(array_get(heap->array, i), array_get(heap->array, p))) {
             heap_swap(heap, i, p);
@@ -130,9 +130,10 @@ sift_up(heap_t *heap, size_t i)
 }
 
 heap_t *
-heap_build(void *array, size_t n, size_t item_size, heap_cmp_t cmp, heap_release_t release, heap_update_t update)
+heap_build(void *array, size_t n, size_t item_size, size_t arity, heap_cmp_t cmp, heap_release_t release, heap_update_t update)
 {
     heap_t *h = calloc(1, sizeof(heap_t));
+    size_t i;
 
     if (NULL == h) {
         return NULL;
@@ -143,26 +144,23 @@ heap_build(void *array, size_t n, size_t item_size, heap_cmp_t cmp, heap_release
         free(h);
         return NULL;
     }
+    h->arity = heap_arity(arity);
     h->cmp = cmp;
     h->release = release;
     h->update = update;
 
+    if (h->update) {
+        for (i = 0; i < n; ++i) {
+            h->update(array_get(h->array, i), i);
+        }
+    }
+
     /** 
      * heapify down subtrees from bottom-up starting from level just above leaves
      * (subtrees rooted on leaves already meet heap property).
      */
-    int i;
-    for (i = parent(n-1); i >= 0; --i) {
-        if (h->update) {
-            h->update(array_get(h->array, i),  i);
-            if (right_child(i) < n) {
-                h->update(array_get(h->array, right_child(i)), right_child(i));
-            }
-            if (left_child(i) < n) {
-                h->update(array_get(h->array, left_child(i)), left_child(i));
-            }
-        }
-        sift_down(h, i);
+    for (i = n > 1 ? parent(h, n - 1) + 1 : 0; i > 0; --i) {
+        sift_down(h, i - 1);
     }
 
     return h;
@@ -171,7 +169,7 @@ heap_build(void *array, size_t n, size_t item_size, heap_cmp_t cmp, heap_release
 int
 heap_sort(void *a, size_t n, size_t item_size, heap_cmp_t cmp)
 {
-    heap_t *h = heap_build(a, n, item_size, cmp, NULL, NULL);
+    heap_t *h = heap_build(a, n, item_size, 2, cmp, NULL, NULL);
 
     if (NULL == h) {
         return -1;
@@ -203,7 +201,7 @@ heap_update(heap_t *h, size_t i)
 void *
 heap_top(heap_t *h)
 {
-    return array_top(h->array);
+    return array_front(h->array);
 }
 
 void *
@@ -218,10 +216,10 @@ heap_pop_front(heap_t *h, void *top)
     }
     else {
         array_copy(h->array, top, 0, 1);
-        array_pop_back(h->array, array_top(h->array));
+        array_pop_back(h->array, array_front(h->array));
 
         if (h->update) {
-            h->update(array_top(h->array), 0);
+            h->update(array_front(h->array), 0);
         }
 
         sift_down(h, 0);
@@ -237,7 +235,9 @@ heap_pop_front(heap_t *h, void *top)
 int
 heap_insert(heap_t *h, void *data)
 {
-    array_push_back(h->array, data);
+    if (0 != array_push_back(h->array, data)) {
+        return -1;
+    }
     if (h->update) {
         h->update(array_back(h->array), array_size(h->array) - 1);
     }
@@ -274,6 +274,17 @@ heap_remove(heap_t *h, size_t i)
     }
 }
 
+void
+heap_clear(heap_t *h)
+{
+    while (array_size(h->array) > 0) {
+        if (h->release) {
+            h->release(array_back(h->array));
+        }
+        array_size_dec(h->array);
+    }
+}
+
 size_t
 heap_size(heap_t *h)
 {
@@ -31,8 +31,15 @@ typedef struct heap heap_t;
  * the objects themselves in the heap. Size of the element to be
  * stored should be provided in item_size parameter. 
  *
+ * Heap is d-ary: every element has up to arity children. Higher arity
+ * makes the tree shallower, so insertions and key decreases (sift up)
+ * compare less elements, while removals (sift down) compare more of
+ * them, but children are contiguous in memory. For Dijkstra or Prim
+ * like workloads 4 is usually faster than 2.
+ *
  * @param capacity initial capacity of heap
  * @param item_size size of one element of the array
+ * @param arity number of children of each element (< 2 for binary heap)
  * @param cmp comparison function to sort objects pointed by heap array
  * @param release function used to release objects pointed by array (optional)
  * @param update function to update index of objects in the heap as they
@@ -41,7 +48,7 @@ typedef struct heap heap_t;
  *        will never be used, no need to provide this function.
  */
 heap_t *
-heap_new(size_t capacity, size_t item_size, heap_cmp_t cmp, heap_release_t release, heap_update_t update);
+heap_new(size_t capacity, size_t item_size, size_t arity, heap_cmp_t cmp, heap_release_t release, heap_update_t update);
 
 /**
  * Creates heap object from array of objects.
@@ -51,13 +58,14 @@ heap_new(size_t capacity, size_t item_size, heap_cmp_t cmp, heap_release_t relea
  * @param array array of objects to be sorted
  * @param n size of array
  * @param item_size size of one element of the array
+ * @param arity @see heap_new
  * @param cmp @see heap_new 
  * @param release @see heap_new 
  * @param update @see heap_new 
  * @return heap object or NULL in case of error.
  */
 heap_t *
-heap_build(void *array, size_t n, size_t item_size, heap_cmp_t cmp, heap_release_t release, heap_update_t update);
+heap_build(void *array, size_t n, size_t item_size, size_t arity, heap_cmp_t cmp, heap_release_t release, heap_update_t update);
 
 /**
  * Sorts array of objects using heap sort algorithm.
@@ -148,6 +156,19 @@ heap_insert(heap_t *h, void *data);
 void
 heap_remove(heap_t *h, size_t i);
 
+/**
+ * Removes every element from the heap, keeping its storage.
+ *
+ * if heap's release callback is provided, it's
+ * called for every element removed.
+ *
+ * It's an O(n) time operation.
+ *
+ * @param h heap object
+ */
+void
+heap_clear(heap_t *h);
+
 /**
  * Releases heap object.
  *
@@ -0,0 +1,287 @@
+#ifndef _HEAP_DEFINE__H_
+#define _HEAP_DEFINE__H_
+
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * Type specialized d-ary heap generated at compile time.
+ *
+ * heap_t goes through a heap_cmp_t callback for every comparison and
+ * through array_get/array_swap (multiplication by item_size and memcpy)
+ * for every element access. HEAP_DEFINE instead generates a heap for one
+ * element type: elements live in a plain type array, the comparison is
+ * expanded inline, and sifting moves a hole down (or up) the tree,
+ * copying each element once instead of swapping it with its parent or
+ * child. The element being sifted is only written to its final slot.
+ *
+ * HEAP_DEFINE(name, type, less) defines name_t and the functions below
+ * (same shape as heap.h):
+ *
+ *   name_t *name_new(size_t capacity);
+ *   name_t *name_build(type *array, size_t n);
+ *   void    name_sort(type *array, size_t n);
+ *   void    name_update(name_t *h, size_t i);
+ *   type   *name_top(name_t *h);
+ *   type   *name_pop_front(name_t *h, type *top);
+ *   int     name_insert(name_t *h, const type *data);
+ *   void    name_remove(name_t *h, size_t i);
+ *   void    name_clear(name_t *h);
+ *   void    name_free(name_t *h);
+ *   size_t  name_size(name_t *h);
+ *   size_t  name_capacity(name_t *h);
+ *
+ * less(a, b) is an expression or macro taking two type values, true
+ * if a must be closer to the top than b (a < b for a min-heap).
+ *
+ * HEAP_DEFINE_FULL(name, type, less, arity, moved) also sets heap arity
+ * (HEAP_DEFINE uses HEAP_DEFINE_ARITY) and a moved(type *item, size_t i)
+ * expression, evaluated whenever an element is stored at index i,
+ * which plays the role of heap_update_t for name_update and name_remove.
+ *
+ * Elements are stored by value and there is no release callback: an
+ * element removed by name_remove or name_clear is simply dropped.
+ *
+ * Example:
+ *
+ *   #define entry_less(a, b) ((a).key < (b).key)
+ *   HEAP_DEFINE(entry_heap, entry_t, entry_less)
+ */
+
+#define HEAP_DEFINE_ARITY 4
+
+#define HEAP_MOVED_NONE(item, i) ((void)0)
+
+#define HEAP_DEFINE(name, type, less) \
+    HEAP_DEFINE_FULL(name, type, less, HEAP_DEFINE_ARITY, HEAP_MOVED_NONE)
+
+#define HEAP_DEFINE_FULL(name, type, less, arity, moved)                        \
+                                                                                \
+typedef type name##_item_t;                                                     \
+                                                                                \
+typedef struct name {                                                           \
+    type *items;                                                                \
+    size_t size;                                                                \
+    size_t capacity;                                                            \
+} name##_t;                                                                     \
+                                                                                \
+/**                                                                             \
+ * Moves hole at i down until x can be stored in it.                           \
+ */                                                                             \
+static inline void                                                              \
+name##_sift_down(type *items, size_t n, size_t i, type x, int report)           \
+{                                                                               \
+    size_t c = (arity) * i + 1;                                                 \
+                                                                                \
+    while (c < n) {                                                             \
+        size_t last = c + (arity) < n ? c + (arity) : n;                        \
+        size_t winner = c;                                                      \
+                                                                                \
+        for (++c; c < last; ++c) {                                              \
+            if (less(items[c], items[winner])) {                                \
+                winner = c;                                                     \
+            }                                                                   \
+        }                                                                       \
+        if (!less(items[winner], x)) {                                          \
+            break;                                                              \
+        }                                                                       \
+        items[i] = items[winner];                                               \
+        if (report) {                                                           \
+            moved(&items[i], i);                                                \
+        }                                                                       \
+        i = winner;                                                             \
+        c = (arity) * i + 1;                                                    \
+    }                                                                           \
+    items[i] = x;                                                               \
+    if (report) {                                                               \
+        moved(&items[i], i);                                                    \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+/**                                                                             \
+ * Moves hole at i up until x can be stored in it.                             \
+ */                                                                             \
+static inline void                                                              \
+name##_sift_up(type *items, size_t i, type x)                                   \
+{                                                                               \
+    while (i > 0) {                                                             \
+        size_t p = (i - 1) / (arity);                                           \
+                                                                                \
+        if (!less(x, items[p])) {                                               \
+            break;                                                              \
+        }                                                                       \
+        items[i] = items[p];                                                    \
+        moved(&items[i], i);                                                    \
+        i = p;                                                                  \
+    }                                                                           \
+    items[i] = x;                                                               \
+    moved(&items[i], i);                                                        \
+}                                                                               \
+                                                                                \
+/**                                                                             \
+ * Stores x in the hole at i, moving it up or down as needed.                  \
+ */                                                                             \
+static inline void                                                              \
+name##_place(name##_t *h, size_t i, type x)                                     \
+{                                                                               \
+    if (i > 0 && less(x, h->items[(i - 1) / (arity)])) {                        \
+        name##_sift_up(h->items, i, x);                                         \
+    }                                                                           \
+    else {                                                                      \
+        name##_sift_down(h->items, h->size, i, x, 1);                           \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+static inline name##_t *                                                        \
+name##_new(size_t capacity)                                                     \
+{                                                                               \
+    name##_t *h = calloc(1, sizeof(name##_t));                                  \
+                                                                                \
+    if (NULL == h) {                                                            \
+        return NULL;                                                            \
+    }                                                                           \
+    if (capacity > 0) {                                                         \
+        h->items = malloc(capacity * sizeof(type));                             \
+        if (NULL == h->items) {                                                 \
+            free(h);                                                            \
+            return NULL;                                                        \
+        }                                                                       \
+        h->capacity = capacity;                                                 \
+    }                                                                           \
+    return h;                                                                   \
+}                                                                               \
+                                                                                \
+/**                                                                             \
+ * Heap takes ownership of array, which must have been allocated with           \
+ * malloc. It's an O(n) time operation.                                        \
+ */                                                                             \
+static inline name##_t *                                                        \
+name##_build(type *array, size_t n)                                             \
+{                                                                               \
+    name##_t *h = calloc(1, sizeof(name##_t));                                  \
+    size_t i;                                                                   \
+                                                                                \
+    if (NULL == h) {                                                            \
+        return NULL;                                                            \
+    }                                                                           \
+    h->items = array;                                                           \
+    h->size = n;                                                                \
+    h->capacity = n;                                                            \
+                                                                                \
+    for (i = 0; i < n; ++i) {                                                   \
+        moved(&array[i], i);                                                    \
+    }                                                                           \
+    for (i = n > 1 ? (n - 2) / (arity) + 1 : 0; i > 0; --i) {                   \
+        name##_sift_down(array, n, i - 1, array[i - 1], 1);                     \
+    }                                                                           \
+    return h;                                                                   \
+}                                                                               \
+                                                                                \
+/**                                                                             \
+ * Sorts array in place, top of the heap ending up last (descending order      \
+ * for a min-heap, as heap_sort). moved is not evaluated.                      \
+ */                                                                             \
+static inline void                                                              \
+name##_sort(type *array, size_t n)                                              \
+{                                                                               \
+    size_t i;                                                                   \
+                                                                                \
+    for (i = n > 1 ? (n - 2) / (arity) + 1 : 0; i > 0; --i) {                   \
+        name##_sift_down(array, n, i - 1, array[i - 1], 0);                     \
+    }                                                                           \
+    for (i = n; i > 1; --i) {                                                   \
+        type x = array[i - 1];                                                  \
+        array[i - 1] = array[0];                                                \
+        name##_sift_down(array, i - 1, 0, x, 0);                                \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+static inline void                                                              \
+name##_update(name##_t *h, size_t i)                                            \
+{                                                                               \
+    if (i < h->size) {                                                          \
+        name##_place(h, i, h->items[i]);                                        \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+static inline type *                                                            \
+name##_top(name##_t *h)                                                         \
+{                                                                               \
+    return h->size > 0 ? &h->items[0] : NULL;                                   \
+}                                                                               \
+                                                                                \
+static inline type *                                                            \
+name##_pop_front(name##_t *h, type *top)                                        \
+{                                                                               \
+    if (0 == h->size) {                                                         \
+        return NULL;                                                            \
+    }                                                                           \
+    *top = h->items[0];                                                         \
+    if (--h->size > 0) {                                                        \
+        name##_sift_down(h->items, h->size, 0, h->items[h->size], 1);           \
+    }                                                                           \
+    return top;                                                                 \
+}                                                                               \
+                                                                                \
+static inline int                                                               \
+name##_insert(name##_t *h, const name##_item_t *data)                           \
+{                                                                               \
+    if (h->size == h->capacity) {                                               \
+        size_t capacity = h->capacity + h->capacity / 2;                        \
+        type *items;                                                            \
+                                                                                \
+        if (capacity < 16) {                                                    \
+            capacity = 16;                                                      \
+        }                                                                       \
+        items = realloc(h->items, capacity * sizeof(type));                     \
+                                                                                \
+        if (NULL == items) {                                                    \
+            return -1;                                                          \
+        }                                                                       \
+        h->items = items;                                                       \
+        h->capacity = capacity;                                                 \
+    }                                                                           \
+    name##_sift_up(h->items, h->size++, *data);                                 \
+    return 0;                                                                   \
+}                                                                               \
+                                                                                \
+/**                                                                             \
+ * Last element takes place of removed one to keep the tree complete.          \
+ */                                                                             \
+static inline void                                                              \
+name##_remove(name##_t *h, size_t i)                                            \
+{                                                                               \
+    if (i >= h->size) {                                                         \
+        return;                                                                 \
+    }                                                                           \
+    if (i < --h->size) {                                                        \
+        name##_place(h, i, h->items[h->size]);                                  \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+static inline void                                                              \
+name##_clear(name##_t *h)                                                       \
+{                                                                               \
+    h->size = 0;                                                                \
+}                                                                               \
+                                                                                \
+static inline void                                                              \
+name##_free(name##_t *h)                                                        \
+{                                                                               \
+    free(h->items);                                                             \
+    free(h);                                                                    \
+}                                                                               \
+                                                                                \
+static inline size_t                                                            \
+name##_size(name##_t *h)                                                        \
+{                                                                               \
+    return h->size;                                                             \
+}                                                                               \
+                                                                                \
+static inline size_t                                                            \
+name##_capacity(name##_t *h)                                                    \
+{                                                                               \
+    return h->capacity;                                                         \
+}
+
+#endif /* _HEAP_DEFINE__H_ */
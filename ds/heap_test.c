@@ -0,0 +1,533 @@
+#include "includes.h"
+#include "heap.h"
+#include "heap_define.h"
+#include "pairing_heap.h"
+#include "radix_heap.h"
+
+typedef struct item item_t;
+
+struct item {
+    long key;
+    size_t index;
+    pairing_heap_node_t *node;
+};
+
+static bool
+long_cmp(const void *o1, const void *o2)
+{
+    return *(const long *)o1 <= *(const long *)o2;
+}
+
+static bool
+item_cmp(const void *o1, const void *o2)
+{
+    const item_t *i1 = *(item_t * const *)o1;
+    const item_t *i2 = *(item_t * const *)o2;
+
+    return i1->key <= i2->key;
+}
+
+static void
+item_update(void *o, size_t index)
+{
+    item_t *item = *(item_t **)o;
+    item->index = index;
+}
+
+#define long_less(a, b) ((a) < (b))
+HEAP_DEFINE(long_heap, long, long_less)
+
+#define item_less(a, b) ((a)->key < (b)->key)
+#define item_moved(item, i) ((*(item))->index = (i))
+HEAP_DEFINE_FULL(item_heap, item_t *, item_less, HEAP_DEFINE_ARITY, item_moved)
+
+static double
+now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ * Inserts n random keys, then removes all of them checking order.
+ */
+static double
+bench_sort(size_t arity, size_t n)
+{
+    heap_t *h = heap_new(0, sizeof(long), arity, long_cmp, NULL, NULL);
+    double start = now();
+    long previous = LONG_MIN;
+    long key;
+
+    for (size_t i = 0; i < n; ++i) {
+        key = rand();
+        heap_insert(h, &key);
+    }
+    while (NULL != heap_pop_front(h, &key)) {
+        assert(key >= previous);
+        previous = key;
+    }
+
+    heap_free(h);
+    return now() - start;
+}
+
+/**
+ * Dijkstra like workload: every removal of the minimum is followed by
+ * degree decrease-keys on items still in the heap.
+ */
+static double
+bench_decrease(size_t arity, size_t n, int degree)
+{
+    item_t *items = malloc(n * sizeof(item_t));
+    heap_t *h = heap_new(n, sizeof(item_t *), arity, item_cmp, NULL, item_update);
+    double start;
+    long previous = LONG_MIN;
+    item_t *top;
+
+    for (size_t i = 0; i < n; ++i) {
+        item_t *item = &items[i];
+        item->key = LONG_MAX / 2 + rand();
+        heap_insert(h, &item);
+    }
+
+    start = now();
+
+    while (NULL != heap_pop_front(h, &top)) {
+        assert(top->key >= previous);
+        previous = top->key;
+        top->index = (size_t)-1;
+        for (int j = 0; j < degree; ++j) {
+            item_t *item = &items[rand() % n];
+            long key = top->key + rand() % 1000;
+            if ((size_t)-1 != item->index && key < item->key) {
+                item->key = key;
+                heap_update(h, item->index);
+            }
+        }
+    }
+
+    heap_free(h);
+    free(items);
+    return now() - start;
+}
+
+static double
+bench_typed_sort(size_t n)
+{
+    long_heap_t *h = long_heap_new(0);
+    double start = now();
+    long previous = LONG_MIN;
+    long key;
+
+    for (size_t i = 0; i < n; ++i) {
+        key = rand();
+        long_heap_insert(h, &key);
+    }
+    while (NULL != long_heap_pop_front(h, &key)) {
+        assert(key >= previous);
+        previous = key;
+    }
+
+    long_heap_free(h);
+    return now() - start;
+}
+
+static double
+bench_typed_decrease(size_t n, int degree)
+{
+    item_t *items = malloc(n * sizeof(item_t));
+    item_heap_t *h = item_heap_new(n);
+    double start;
+    long previous = LONG_MIN;
+    item_t *top;
+
+    for (size_t i = 0; i < n; ++i) {
+        item_t *item = &items[i];
+        item->key = LONG_MAX / 2 + rand();
+        item_heap_insert(h, &item);
+    }
+
+    start = now();
+
+    while (NULL != item_heap_pop_front(h, &top)) {
+        assert(top->key >= previous);
+        previous = top->key;
+        top->index = (size_t)-1;
+        for (int j = 0; j < degree; ++j) {
+            item_t *item = &items[rand() % n];
+            long key = top->key + rand() % 1000;
+            if ((size_t)-1 != item->index && key < item->key) {
+                item->key = key;
+                item_heap_update(h, item->index);
+            }
+        }
+    }
+
+    item_heap_free(h);
+    free(items);
+    return now() - start;
+}
+
+static bool
+pairing_item_cmp(const void *o1, const void *o2)
+{
+    const item_t *i1 = o1;
+    const item_t *i2 = o2;
+
+    return i1->key <= i2->key;
+}
+
+static double
+bench_pairing_decrease(size_t n, int degree)
+{
+    item_t *items = malloc(n * sizeof(item_t));
+    pairing_heap_t *h = pairing_heap_new(pairing_item_cmp, n);
+    double start;
+    long previous = LONG_MIN;
+    item_t *top;
+
+    for (size_t i = 0; i < n; ++i) {
+        item_t *item = &items[i];
+        item->key = LONG_MAX / 2 + rand();
+        item->node = pairing_heap_insert(h, item);
+    }
+
+    start = now();
+
+    while (NULL != (top = pairing_heap_pop_front(h))) {
+        assert(top->key >= previous);
+        previous = top->key;
+        top->node = NULL;
+        for (int j = 0; j < degree; ++j) {
+            item_t *item = &items[rand() % n];
+            long key = top->key + rand() % 1000;
+            if (NULL != item->node && key < item->key) {
+                item->key = key;
+                pairing_heap_decrease(h, item->node);
+            }
+        }
+    }
+
+    pairing_heap_free(h);
+    free(items);
+    return now() - start;
+}
+
+/**
+ * Checks build, remove and sort of typed heap against qsort.
+ */
+static int
+long_compare(const void *o1, const void *o2)
+{
+    long l1 = *(const long *)o1;
+    long l2 = *(const long *)o2;
+
+    return l1 < l2 ? 1 : l1 > l2 ? -1 : 0;
+}
+
+static bool
+check_typed(size_t n)
+{
+    long *array = malloc(n * sizeof(long));
+    long *expected = malloc(n * sizeof(long));
+    item_t *items = malloc(n * sizeof(item_t));
+    item_t **pointers = malloc(n * sizeof(item_t *));
+    item_heap_t *h;
+    long previous = LONG_MIN;
+    size_t removed = 0;
+    bool ok = true;
+    item_t *top;
+
+    for (size_t i = 0; i < n; ++i) {
+        array[i] = expected[i] = rand() % 1000;
+        items[i].key = array[i];
+        pointers[i] = &items[i];
+    }
+    long_heap_sort(array, n);
+    qsort(expected, n, sizeof(long), long_compare);
+    ok = 0 == memcmp(array, expected, n * sizeof(long));
+
+    h = item_heap_build(pointers, n);
+    for (size_t i = 0; i < n; i += 3) {
+        item_heap_remove(h, items[i].index);
+        items[i].index = (size_t)-1;
+        removed++;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        ok = ok && ((size_t)-1 == items[i].index || h->items[items[i].index] == &items[i]);
+    }
+    while (NULL != item_heap_pop_front(h, &top)) {
+        ok = ok && top->key >= previous && (size_t)-1 != top->index;
+        previous = top->key;
+        top->index = (size_t)-1;
+        removed++;
+    }
+    ok = ok && n == removed;
+
+    item_heap_free(h);
+    free(array);
+    free(expected);
+    free(items);
+    return ok;
+}
+
+/**
+ * Spreads n items over two pairing heaps, decreases keys in both, melds
+ * them, decreases keys through nodes of the emptied heap and pops
+ * everything, checking order and that every item comes out once.
+ */
+static bool
+check_pairing_meld(size_t n, size_t pool)
+{
+    item_t *items = malloc((n ? n : 1) * sizeof(item_t));
+    pairing_heap_t *h1 = pairing_heap_new(pairing_item_cmp, pool);
+    pairing_heap_t *h2 = pairing_heap_new(pairing_item_cmp, pool);
+    long previous = LONG_MIN;
+    size_t popped = 0;
+    bool ok = NULL != h1 && NULL != h2;
+    item_t *top;
+
+    for (size_t i = 0; ok && i < n; ++i) {
+        items[i].key = rand() % 1000;
+        items[i].node = pairing_heap_insert(i % 3 ? h1 : h2, &items[i]);
+        ok = NULL != items[i].node;
+    }
+    for (size_t i = 0; ok && i < n; i += 2) {
+        items[i].key -= rand() % 500;
+        pairing_heap_decrease(i % 3 ? h1 : h2, items[i].node);
+    }
+
+    ok = ok && 0 == pairing_heap_meld(h1, h2) && n == pairing_heap_size(h1) &&
+        0 == pairing_heap_size(h2) && NULL == pairing_heap_top(h2);
+    ok = ok && 0 == pairing_heap_meld(h1, h2) && n == pairing_heap_size(h1);
+
+    for (size_t i = 0; ok && i < n; i += 3) {
+        items[i].key -= rand() % 500;
+        pairing_heap_decrease(h1, items[i].node);
+    }
+
+    while (ok && NULL != (top = pairing_heap_pop_front(h1))) {
+        ok = top->key >= previous && NULL != top->node;
+        previous = top->key;
+        top->node = NULL;
+        popped++;
+    }
+    ok = ok && n == popped;
+
+    if (NULL != h1) {
+        pairing_heap_free(h1);
+    }
+    if (NULL != h2) {
+        pairing_heap_free(h2);
+    }
+    free(items);
+    return ok;
+}
+
+/**
+ * Element at every index of the plain heap checked by check_plain, as
+ * reported by its update callback.
+ */
+static item_t **plain_slots;
+
+static void
+plain_update(void *o, size_t index)
+{
+    item_t *item = *(item_t **)o;
+    item->index = index;
+    plain_slots[index] = item;
+}
+
+/**
+ * Checks every element of the heap knows its index and no element is
+ * less than its parent.
+ */
+static bool
+plain_valid(heap_t *h, size_t arity)
+{
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < heap_size(h); ++i) {
+        ok = plain_slots[i]->index == i &&
+            (0 == i || plain_slots[(i - 1) / arity]->key <= plain_slots[i]->key);
+    }
+    return ok && (0 == heap_size(h) || plain_slots[0] == *(item_t **)heap_top(h));
+}
+
+/**
+ * Builds a d-ary heap of n items, removes items from the middle,
+ * decreases and increases keys, inserts removed items back and pops
+ * everything, checking indexes given to the update callback and heap
+ * order after every operation.
+ */
+static bool
+check_plain(size_t arity, size_t n)
+{
+    item_t *items = malloc((n ? n : 1) * sizeof(item_t));
+    item_t **pointers = malloc((n ? n : 1) * sizeof(item_t *));
+    long previous = LONG_MIN;
+    size_t popped = 0;
+    heap_t *h;
+    item_t *top;
+    bool ok;
+
+    plain_slots = malloc((n ? n : 1) * sizeof(item_t *));
+    for (size_t i = 0; i < n; ++i) {
+        items[i].key = rand() % 1000;
+        pointers[i] = &items[i];
+    }
+
+    h = heap_build(pointers, n, sizeof(item_t *), arity, item_cmp, NULL, plain_update);
+    ok = NULL != h && n == heap_size(h) && plain_valid(h, arity);
+
+    for (size_t i = 1; ok && i < n; i += 3) {
+        heap_remove(h, items[i].index);
+        items[i].index = (size_t)-1;
+        ok = plain_valid(h, arity);
+    }
+    for (size_t i = 0; ok && i < n; i += 3) {
+        items[i].key += i % 2 ? 500 : -500;
+        heap_update(h, items[i].index);
+        ok = plain_valid(h, arity);
+    }
+    for (size_t i = 1; ok && i < n; i += 6) {
+        item_t *item = &items[i];
+        item->key = rand() % 1000;
+        ok = 0 == heap_insert(h, &item) && plain_valid(h, arity);
+    }
+    for (size_t i = 0; ok && i < n; ++i) {
+        ok = (size_t)-1 == items[i].index || plain_slots[items[i].index] == &items[i];
+    }
+
+    while (ok && NULL != heap_pop_front(h, &top)) {
+        ok = top->key >= previous && (size_t)-1 != top->index && plain_valid(h, arity);
+        previous = top->key;
+        top->index = (size_t)-1;
+        popped++;
+    }
+    ok = ok && n - (n + 1) / 3 + (n + 4) / 6 == popped;
+
+    if (NULL != h) {
+        heap_free(h);
+    }
+    free(items);
+    free(plain_slots);
+    return ok;
+}
+
+static void
+radix_item_update(void *o, size_t handle)
+{
+    item_t *item = o;
+    item->index = handle;
+}
+
+/**
+ * Dijkstra like use of radix heap: keys inserted and decreased are never
+ * less than the last key removed. Checks keys come out sorted, every
+ * item comes out once with its last key, and clear allows any key again.
+ */
+static bool
+check_radix(size_t n)
+{
+    item_t *items = malloc((n ? n : 1) * sizeof(item_t));
+    bool *in = calloc(n ? n : 1, sizeof(bool));
+    radix_heap_t *h = radix_heap_new(radix_item_update);
+    unsigned long last = 0;
+    unsigned long key;
+    size_t removed = 0;
+    bool ok = NULL != h;
+    item_t *top;
+
+    for (size_t i = 0; ok && i < n; i += 2) {
+        items[i].key = rand() % 1000;
+        ok = 0 == radix_heap_insert(h, items[i].key, &items[i]);
+        in[i] = true;
+    }
+
+    while (ok && NULL != (top = radix_heap_pop_front(h, &key))) {
+        ok = key >= last && (unsigned long)top->key == key && in[top - items];
+        in[top - items] = false;
+        last = key;
+        removed++;
+
+        for (int j = 0; ok && j < 4 && 0 != n; ++j) {
+            size_t i = rand() % n;
+            long k = last + rand() % 100;
+            if (!in[i] && removed < n) {
+                items[i].key = k;
+                in[i] = true;
+                ok = 0 == radix_heap_insert(h, k, &items[i]);
+            }
+            else if (in[i] && k < items[i].key) {
+                items[i].key = k;
+                ok = 0 == radix_heap_decrease(h, items[i].index, k);
+            }
+        }
+        ok = ok && (size_t)radix_heap_size(h) <= n;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        ok = ok && !in[i];
+    }
+
+    if (ok && n > 0) {
+        radix_heap_clear(h);
+        ok = 0 == radix_heap_insert(h, 0, &items[0]) && &items[0] == radix_heap_pop_front(h, &key) && 0 == key;
+    }
+
+    radix_heap_free(h);
+    free(items);
+    free(in);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t arities[] = { 2, 3, 4, 8, 16 };
+
+    srand(1);
+
+    for (size_t m = 0; m < 200; ++m) {
+        if (!check_typed(m)) {
+            printf("typed heap of %zu elements: FAILED\n", m);
+        }
+    }
+    printf("typed heap checks: done\n");
+
+    for (int i = 0; i < countof(arities); ++i) {
+        for (size_t m = 0; m < 200; ++m) {
+            if (!check_plain(arities[i], m)) {
+                printf("heap of arity %zu of %zu elements: FAILED\n", arities[i], m);
+            }
+        }
+    }
+    printf("heap checks: done\n");
+
+    for (size_t m = 0; m < 200; m += 7) {
+        if (!check_pairing_meld(m * m, 0) || !check_pairing_meld(m * m, 64)) {
+            printf("pairing heap meld of %zu elements: FAILED\n", m * m);
+        }
+    }
+    printf("pairing heap checks: done\n");
+
+    for (size_t m = 0; m < 200; m += 7) {
+        if (!check_radix(m * m)) {
+            printf("radix heap of %zu elements: FAILED\n", m * m);
+        }
+    }
+    printf("radix heap checks: done\n");
+
+    for (int i = 0; i < countof(arities); ++i) {
+        printf("arity %2zu: insert/remove %zu keys %.3fs, remove/decrease-key %.3fs\n",
+               arities[i], n, bench_sort(arities[i], n), bench_decrease(arities[i], n, 8));
+    }
+    printf("typed   4: insert/remove %zu keys %.3fs, remove/decrease-key %.3fs\n",
+           n, bench_typed_sort(n), bench_typed_decrease(n, 8));
+    printf("pairing heap: remove/decrease-key %.3fs\n", bench_pairing_decrease(n, 8));
+
+    return 0;
+}
@@ -0,0 +1,302 @@
+#include "pairing_heap.h"
+#include <stdlib.h>
+
+/**
+ * Children of a node are a doubly linked list starting at child and
+ * following sibling. prev points to left sibling, or to parent for the
+ * first child, so a node is unlinked from its tree in O(1) time.
+ */
+struct pairing_heap_node {
+    void *data;
+    pairing_heap_node_t *child;
+    pairing_heap_node_t *sibling;
+    pairing_heap_node_t *prev;
+};
+
+typedef struct pairing_heap_block pairing_heap_block_t;
+
+struct pairing_heap_block {
+    pairing_heap_block_t *next;
+    pairing_heap_node_t nodes[];
+};
+
+struct pairing_heap {
+    pairing_heap_node_t *root;
+    size_t size;
+    pairing_heap_cmp_t cmp;
+    size_t pool;                   /**< nodes per block, 0 if not pooled */
+    pairing_heap_block_t *blocks;
+    pairing_heap_block_t *last;    /**< last block of the list */
+    pairing_heap_node_t *free;     /**< released nodes, linked by sibling */
+};
+
+pairing_heap_t *
+pairing_heap_new(pairing_heap_cmp_t cmp, size_t pool)
+{
+    pairing_heap_t *h = calloc(1, sizeof(pairing_heap_t));
+
+    if (NULL != h) {
+        h->cmp = cmp;
+        h->pool = pool;
+    }
+    return h;
+}
+
+static pairing_heap_node_t *
+pairing_heap_node_alloc(pairing_heap_t *h)
+{
+    pairing_heap_node_t *node;
+
+    if (0 == h->pool) {
+        return malloc(sizeof(pairing_heap_node_t));
+    }
+
+    if (NULL == h->free) {
+        pairing_heap_block_t *block = malloc(sizeof(pairing_heap_block_t) + h->pool * sizeof(pairing_heap_node_t));
+
+        if (NULL == block) {
+            return NULL;
+        }
+        block->next = NULL;
+        if (NULL == h->last) {
+            h->blocks = block;
+        }
+        else {
+            h->last->next = block;
+        }
+        h->last = block;
+
+        for (size_t i = h->pool; i > 0; --i) {
+            block->nodes[i - 1].sibling = h->free;
+            h->free = &block->nodes[i - 1];
+        }
+    }
+
+    node = h->free;
+    h->free = node->sibling;
+    return node;
+}
+
+static void
+pairing_heap_node_release(pairing_heap_t *h, pairing_heap_node_t *node)
+{
+    if (0 == h->pool) {
+        free(node);
+    }
+    else {
+        node->sibling = h->free;
+        h->free = node;
+    }
+}
+
+/**
+ * Links two roots: the one with larger key becomes first child of the
+ * other one, which is returned.
+ */
+static pairing_heap_node_t *
+pairing_heap_link(pairing_heap_t *h, pairing_heap_node_t *a, pairing_heap_node_t *b)
+{
+    pairing_heap_node_t *t;
+
+    if (!h->cmp(a->data, b->data)) {
+        t = a;
+        a = b;
+        b = t;
+    }
+
+    b->sibling = a->child;
+    if (NULL != a->child) {
+        a->child->prev = b;
+    }
+    b->prev = a;
+    a->child = b;
+
+    return a;
+}
+
+pairing_heap_node_t *
+pairing_heap_insert(pairing_heap_t *h, void *data)
+{
+    pairing_heap_node_t *node = pairing_heap_node_alloc(h);
+
+    if (NULL == node) {
+        return NULL;
+    }
+
+    node->data = data;
+    node->child = NULL;
+    node->sibling = NULL;
+    node->prev = NULL;
+
+    h->root = NULL == h->root ? node : pairing_heap_link(h, h->root, node);
+    h->size++;
+
+    return node;
+}
+
+void
+pairing_heap_decrease(pairing_heap_t *h, pairing_heap_node_t *node)
+{
+    if (node == h->root) {
+        return;
+    }
+
+    if (node->prev->child == node) {
+        node->prev->child = node->sibling;
+    }
+    else {
+        node->prev->sibling = node->sibling;
+    }
+    if (NULL != node->sibling) {
+        node->sibling->prev = node->prev;
+    }
+    node->sibling = NULL;
+    node->prev = NULL;
+
+    h->root = pairing_heap_link(h, h->root, node);
+}
+
+int
+pairing_heap_meld(pairing_heap_t *h1, pairing_heap_t *h2)
+{
+    if (h1->cmp != h2->cmp || (0 == h1->pool) != (0 == h2->pool)) {
+        return -1;
+    }
+
+    if (NULL != h2->root) {
+        h1->root = NULL == h1->root ? h2->root : pairing_heap_link(h1, h1->root, h2->root);
+        h1->size += h2->size;
+    }
+
+    /**
+     * Blocks holding nodes of h2 must live as long as h1 does. Free
+     * nodes of h2 are left behind: they're released with their block.
+     */
+    if (NULL != h2->blocks) {
+        if (NULL == h1->last) {
+            h1->blocks = h2->blocks;
+        }
+        else {
+            h1->last->next = h2->blocks;
+        }
+        h1->last = h2->last;
+    }
+
+    h2->root = NULL;
+    h2->size = 0;
+    h2->blocks = NULL;
+    h2->last = NULL;
+    h2->free = NULL;
+
+    return 0;
+}
+
+void *
+pairing_heap_top(pairing_heap_t *h)
+{
+    return NULL == h->root ? NULL : h->root->data;
+}
+
+void *
+pairing_heap_pop_front(pairing_heap_t *h)
+{
+    pairing_heap_node_t *root = h->root;
+    pairing_heap_node_t *pairs = NULL;
+    pairing_heap_node_t *node;
+    void *data;
+
+    if (NULL == root) {
+        return NULL;
+    }
+
+    /**
+     * First pass links children in pairs left to right, stacking
+     * results (last pair on top). Second pass links them right to left.
+     */
+    node = root->child;
+    while (NULL != node) {
+        pairing_heap_node_t *a = node;
+        pairing_heap_node_t *b = a->sibling;
+
+        if (NULL == b) {
+            node = NULL;
+        }
+        else {
+            node = b->sibling;
+            b->sibling = NULL;
+            b->prev = NULL;
+            a = pairing_heap_link(h, a, b);
+        }
+        a->prev = NULL;
+        a->sibling = pairs;
+        pairs = a;
+    }
+
+    h->root = pairs;
+    if (NULL != pairs) {
+        node = pairs->sibling;
+        h->root->sibling = NULL;
+        while (NULL != node) {
+            pairing_heap_node_t *next = node->sibling;
+            node->sibling = NULL;
+            h->root = pairing_heap_link(h, h->root, node);
+            node = next;
+        }
+    }
+
+    data = root->data;
+    pairing_heap_node_release(h, root);
+    h->size--;
+
+    return data;
+}
+
+void
+pairing_heap_clear(pairing_heap_t *h)
+{
+    pairing_heap_node_t *node = h->root;
+
+    /**
+     * First child is rotated up in place of its parent, so that every
+     * node is released once its children are all reachable by sibling.
+     */
+    while (NULL != node) {
+        pairing_heap_node_t *child = node->child;
+
+        if (NULL != child) {
+            node->child = child->sibling;
+            child->sibling = node;
+            node = child;
+        }
+        else {
+            pairing_heap_node_t *next = node->sibling;
+            pairing_heap_node_release(h, node);
+            node = next;
+        }
+    }
+
+    h->root = NULL;
+    h->size = 0;
+}
+
+void
+pairing_heap_free(pairing_heap_t *h)
+{
+    pairing_heap_block_t *block = h->blocks;
+
+    if (0 == h->pool) {
+        pairing_heap_clear(h);
+    }
+    while (NULL != block) {
+        pairing_heap_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(h);
+}
+
+size_t
+pairing_heap_size(pairing_heap_t *h)
+{
+    return h->size;
+}
@@ -0,0 +1,133 @@
+#ifndef _PAIRING_HEAP__H_
+#define _PAIRING_HEAP__H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Pairing heap: heap ordered multiway tree of nodes.
+ *
+ * Insertion, meld and decrease-key link two trees, making the root with
+ * larger key first child of the other one, in O(1) time. Removing the
+ * minimum pairs up subtrees of the root left to right, then links the
+ * pairs right to left, in O(log(n)) amortized time. Decrease-key is
+ * o(log(n)) amortized (O(1) in practice), unlike heap_update which sifts
+ * the element and calls update callback for every element moved.
+ *
+ * Every object lives in a node, which never moves while the object is
+ * in the heap: the node returned by pairing_heap_insert is a stable
+ * handle for pairing_heap_decrease.
+ *
+ * Nodes might be allocated one by one or taken from a pool: blocks of
+ * nodes whose released nodes are kept in a free list for reuse, which
+ * saves one malloc/free pair per insertion.
+ */
+
+/**
+ * Returns true if first object is considered less than or equal (min-heap) or
+ * greater than or equal (max-heap) second object.
+ */
+typedef bool (*pairing_heap_cmp_t)(const void *, const void *);
+
+typedef struct pairing_heap pairing_heap_t;
+
+typedef struct pairing_heap_node pairing_heap_node_t;
+
+/**
+ * Allocates new pairing heap object.
+ *
+ * @param cmp comparison function to sort objects
+ * @param pool number of nodes allocated at once by the pool, 0 to
+ *        allocate (and release) nodes one by one
+ * @return pairing heap object or NULL in case of error.
+ */
+pairing_heap_t *
+pairing_heap_new(pairing_heap_cmp_t cmp, size_t pool);
+
+/**
+ * Inserts object in the heap.
+ *
+ * It's an O(1) time operation.
+ *
+ * @param h pairing heap object
+ * @param data object to be inserted
+ * @return node holding the object until it's removed, NULL in case of error
+ */
+pairing_heap_node_t *
+pairing_heap_insert(pairing_heap_t *h, void *data);
+
+/**
+ * Notifies heap that key of object in node was just decreased
+ * (increased for max-heap).
+ *
+ * It's an O(1) time operation, o(log(n)) amortized.
+ *
+ * @param h pairing heap object
+ * @param node node returned by pairing_heap_insert for the object
+ */
+void
+pairing_heap_decrease(pairing_heap_t *h, pairing_heap_node_t *node);
+
+/**
+ * Moves every object of h2 into h1, leaving h2 empty.
+ *
+ * It's an O(1) time operation. Nodes keep being valid handles, now in
+ * h1. Both heaps must have the same comparison function and either both
+ * or none use a pool.
+ *
+ * @param h1 pairing heap object receiving objects
+ * @param h2 pairing heap object emptied
+ * @return 0 on success, -1 otherwise
+ */
+int
+pairing_heap_meld(pairing_heap_t *h1, pairing_heap_t *h2);
+
+/**
+ * Returns object on the top of the heap (maximum/minimum object).
+ *
+ * It's an O(1) time operation.
+ *
+ * @param h pairing heap object
+ * @return object on the top of the heap, NULL if heap is empty
+ */
+void *
+pairing_heap_top(pairing_heap_t *h);
+
+/**
+ * Removes object on the top of the heap (maximum/minimum object).
+ *
+ * It's an O(log(n)) amortized time operation.
+ *
+ * @param h pairing heap object
+ * @return object removed, NULL if heap is empty
+ */
+void *
+pairing_heap_pop_front(pairing_heap_t *h);
+
+/**
+ * Removes every object from the heap, keeping pooled nodes for reuse.
+ *
+ * It's an O(n) time operation.
+ *
+ * @param h pairing heap object
+ */
+void
+pairing_heap_clear(pairing_heap_t *h);
+
+/**
+ * Releases pairing heap object.
+ *
+ * @param h pairing heap object
+ */
+void
+pairing_heap_free(pairing_heap_t *h);
+
+/**
+ * Returns current number of objects in the heap.
+ *
+ * @param h pairing heap object
+ */
+size_t
+pairing_heap_size(pairing_heap_t *h);
+
+#endif /* _PAIRING_HEAP__H_ */
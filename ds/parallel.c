@@ -0,0 +1,221 @@
+#include "parallel.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct parallel_task parallel_task_t;
+
+struct parallel_task {
+    parallel_fn_t fn;
+    void *arg;
+    int id;
+    atomic_int *nthreads; /**< zero until every thread was created */
+};
+
+int
+parallel_threads(int nthreads)
+{
+    if (nthreads <= 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = n > 0 ? (int)n : 1;
+    }
+    return nthreads;
+}
+
+static void *
+parallel_task_run(void *o)
+{
+    parallel_task_t *task = o;
+    int nthreads;
+
+    while (0 == (nthreads = atomic_load(task->nthreads))) {
+        sched_yield();
+    }
+
+    task->fn(task->arg, task->id, nthreads);
+
+    return NULL;
+}
+
+int
+parallel_run(int nthreads, parallel_fn_t fn, void *arg)
+{
+    pthread_t *threads = NULL;
+    parallel_task_t *tasks = NULL;
+    atomic_int started;
+    int i;
+
+    nthreads = parallel_threads(nthreads);
+
+    if (nthreads > 1) {
+        threads = malloc(nthreads * sizeof(pthread_t));
+        tasks = malloc(nthreads * sizeof(parallel_task_t));
+    }
+
+    if (NULL == threads || NULL == tasks) {
+        free(threads);
+        free(tasks);
+        fn(arg, 0, 1);
+        return 1;
+    }
+
+    atomic_init(&started, 0);
+
+    for (i = 0; i < nthreads; ++i) {
+        tasks[i].fn = fn;
+        tasks[i].arg = arg;
+        tasks[i].id = i;
+        tasks[i].nthreads = &started;
+    }
+
+    /**
+     * Threads created wait for the final count before running fn, so
+     * that region runs on those created up to the first failure.
+     */
+    for (i = 1; i < nthreads; ++i) {
+        if (0 != pthread_create(&threads[i], NULL, parallel_task_run, &tasks[i])) {
+            break;
+        }
+    }
+    nthreads = i;
+    atomic_store(&started, nthreads);
+
+    parallel_task_run(&tasks[0]);
+
+    for (i = 1; i < nthreads; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(threads);
+    free(tasks);
+
+    return nthreads;
+}
+
+void
+parallel_barrier_init(parallel_barrier_t *barrier)
+{
+    atomic_init(&barrier->waiting, 0);
+    atomic_init(&barrier->generation, 0);
+}
+
+int
+parallel_barrier_wait(parallel_barrier_t *barrier, int nthreads)
+{
+    unsigned generation = atomic_load(&barrier->generation);
+
+    if (atomic_fetch_add(&barrier->waiting, 1) + 1 == nthreads) {
+        atomic_store(&barrier->waiting, 0);
+        atomic_fetch_add(&barrier->generation, 1);
+        return 1;
+    }
+
+    while (atomic_load(&barrier->generation) == generation) {
+        sched_yield();
+    }
+
+    return 0;
+}
+
+typedef struct parallel_sort_task parallel_sort_task_t;
+
+struct parallel_sort_task {
+    char *base;
+    char *buffer;
+    size_t n;
+    size_t size;
+    int (*cmp)(const void *, const void *);
+    parallel_barrier_t barrier;
+};
+
+/**
+ * Merges sorted [a, a + na) and [b, b + nb) into dst.
+ */
+static void
+parallel_sort_merge(const parallel_sort_task_t *task, const char *a, size_t na, const char *b, size_t nb, char *dst)
+{
+    const char *a_end = a + na * task->size;
+    const char *b_end = b + nb * task->size;
+
+    while (a < a_end && b < b_end) {
+        if (task->cmp(b, a) < 0) {
+            memcpy(dst, b, task->size);
+            b += task->size;
+        }
+        else {
+            memcpy(dst, a, task->size);
+            a += task->size;
+        }
+        dst += task->size;
+    }
+    memcpy(dst, a, a_end - a);
+    memcpy(dst + (a_end - a), b, b_end - b);
+}
+
+static void
+parallel_sort_worker(void *arg, int id, int nthreads)
+{
+    parallel_sort_task_t *task = arg;
+    char *src = task->base;
+    char *dst = task->buffer;
+    size_t begin, end;
+
+    parallel_range(task->n, id, nthreads, &begin, &end);
+    qsort(src + begin * task->size, end - begin, task->size, task->cmp);
+
+    /**
+     * Every pass merges runs of width blocks: pair j, made of blocks
+     * [2 j width, 2 (j + 1) width), is merged by thread j % nthreads.
+     */
+    for (int width = 1; width < nthreads; width *= 2) {
+        char *t;
+
+        parallel_barrier_wait(&task->barrier, nthreads);
+
+        for (int j = id; 2 * j * width < nthreads; j += nthreads) {
+            int first = 2 * j * width;
+            int middle = first + width < nthreads ? first + width : nthreads;
+            int last = first + 2 * width < nthreads ? first + 2 * width : nthreads;
+            size_t a, b, c, unused;
+
+            parallel_range(task->n, first, nthreads, &a, &unused);
+            parallel_range(task->n, middle - 1, nthreads, &unused, &b);
+            parallel_range(task->n, last - 1, nthreads, &unused, &c);
+            parallel_sort_merge(task, src + a * task->size, b - a, src + b * task->size, c - b, dst + a * task->size);
+        }
+
+        t = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != task->base) {
+        parallel_barrier_wait(&task->barrier, nthreads);
+        memcpy(task->base + begin * task->size, src + begin * task->size, (end - begin) * task->size);
+    }
+}
+
+int
+parallel_sort(void *base, size_t n, size_t size, int (*cmp)(const void *, const void *), int nthreads)
+{
+    parallel_sort_task_t task = { base, NULL, n, size, cmp };
+
+    nthreads = parallel_threads(nthreads);
+    if (nthreads < 2 || n < 2) {
+        qsort(base, n, size, cmp);
+        return 0;
+    }
+
+    task.buffer = malloc(n * size);
+    if (NULL == task.buffer) {
+        return -1;
+    }
+    parallel_barrier_init(&task.barrier);
+
+    parallel_run(nthreads, parallel_sort_worker, &task);
+
+    free(task.buffer);
+    return 0;
+}
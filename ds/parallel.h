@@ -0,0 +1,93 @@
+#ifndef _PARALLEL__H_
+#define _PARALLEL__H_
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+/**
+ * Minimal fork/join helper on top of POSIX threads.
+ *
+ * A parallel region runs fn on nthreads threads, each one receiving its
+ * own id in range [0, nthreads). Caller thread runs id 0 and parallel_run
+ * only returns after every thread finished.
+ */
+typedef void (*parallel_fn_t)(void *arg, int id, int nthreads);
+
+/**
+ * Returns number of threads to be used when nthreads threads are
+ * requested: any value <= 0 means number of online processors.
+ */
+int
+parallel_threads(int nthreads);
+
+/**
+ * Runs fn(arg, id, nthreads) on nthreads threads.
+ *
+ * Falls back to a single thread if bookkeeping for the threads cannot be
+ * allocated, and to the threads already created if creating one fails:
+ * fn should rely on the nthreads value it receives, not on the one
+ * requested.
+ *
+ * @return number of threads fn actually ran on.
+ */
+int
+parallel_run(int nthreads, parallel_fn_t fn, void *arg);
+
+typedef struct parallel_barrier parallel_barrier_t;
+
+/**
+ * Barrier for threads of a parallel region.
+ *
+ * Number of threads is given on every wait, so the same barrier works
+ * whatever nthreads parallel_run ended up with. Waiting threads spin,
+ * yielding the processor, which suits the short phases of parallel graph
+ * algorithms better than sleeping on a condition variable.
+ */
+struct parallel_barrier {
+    atomic_int waiting;
+    atomic_uint generation;
+};
+
+void
+parallel_barrier_init(parallel_barrier_t *barrier);
+
+/**
+ * Blocks until nthreads threads are waiting on barrier.
+ *
+ * Memory writes made by every thread before the barrier are visible to
+ * all of them after it.
+ *
+ * @return 1 for exactly one of the threads (last to arrive), 0 for the
+ *         others, so that some serial work can follow the barrier.
+ */
+int
+parallel_barrier_wait(parallel_barrier_t *barrier, int nthreads);
+
+/**
+ * Splits range [0, n) in nthreads contiguous blocks and returns
+ * the block of thread id in [*begin, *end).
+ */
+static inline void
+parallel_range(size_t n, int id, int nthreads, size_t *begin, size_t *end)
+{
+    size_t chunk = n / nthreads;
+    size_t extra = n % nthreads;
+
+    *begin = id * chunk + ((size_t)id < extra ? (size_t)id : extra);
+    *end = *begin + chunk + ((size_t)id < extra ? 1 : 0);
+}
+
+/**
+ * Same as qsort, on nthreads threads (<= 0 for number of online
+ * processors): every thread sorts a block of the array, then sorted
+ * blocks are merged pairwise, pairs of each pass in parallel.
+ *
+ * Not stable.
+ *
+ * @return 0 on success, -1 on allocation failure (array is left
+ *         unchanged).
+ */
+int
+parallel_sort(void *base, size_t n, size_t size, int (*cmp)(const void *, const void *), int nthreads);
+
+#endif /* _PARALLEL__H_ */
@@ -0,0 +1,216 @@
+#include "radix_heap.h"
+#include <stdlib.h>
+#include <limits.h>
+
+#define RADIX_HEAP_BUCKETS (sizeof(unsigned long) * CHAR_BIT + 1)
+
+/**
+ * Handles encode bucket in the low bits and position in the bucket
+ * in the remaining ones.
+ */
+#define RADIX_HEAP_BUCKET_BITS 7
+#define radix_heap_handle(b, i) (((i) << RADIX_HEAP_BUCKET_BITS) | (b))
+#define radix_heap_handle_bucket(handle) ((handle) & ((1 << RADIX_HEAP_BUCKET_BITS) - 1))
+#define radix_heap_handle_index(handle) ((handle) >> RADIX_HEAP_BUCKET_BITS)
+
+typedef struct radix_heap_entry radix_heap_entry_t;
+
+struct radix_heap_entry {
+    unsigned long key;
+    void *data;
+};
+
+typedef struct radix_heap_bucket radix_heap_bucket_t;
+
+struct radix_heap_bucket {
+    radix_heap_entry_t *entries;
+    size_t size;
+    size_t capacity;
+};
+
+struct radix_heap {
+    radix_heap_bucket_t buckets[RADIX_HEAP_BUCKETS];
+    unsigned long last;  /**< last key removed */
+    size_t size;
+    radix_heap_update_t update;
+};
+
+static inline size_t
+radix_heap_bucket_of(radix_heap_t *h, unsigned long key)
+{
+    return key == h->last ? 0 : RADIX_HEAP_BUCKETS - 1 - __builtin_clzl(key ^ h->last);
+}
+
+static int
+radix_heap_bucket_reserve(radix_heap_bucket_t *bucket, size_t n)
+{
+    if (bucket->size + n > bucket->capacity) {
+        size_t capacity = bucket->capacity ? bucket->capacity : 16;
+        radix_heap_entry_t *entries = NULL;
+
+        while (capacity < bucket->size + n) {
+            capacity *= 2;
+        }
+        entries = realloc(bucket->entries, capacity * sizeof(radix_heap_entry_t));
+        if (NULL == entries) {
+            return -1;
+        }
+        bucket->entries = entries;
+        bucket->capacity = capacity;
+    }
+    return 0;
+}
+
+/**
+ * Appends entry to bucket b, which must have room for it.
+ */
+static inline void
+radix_heap_bucket_push(radix_heap_t *h, size_t b, unsigned long key, void *data)
+{
+    radix_heap_bucket_t *bucket = &h->buckets[b];
+
+    bucket->entries[bucket->size].key = key;
+    bucket->entries[bucket->size].data = data;
+    if (h->update) {
+        h->update(data, radix_heap_handle(b, bucket->size));
+    }
+    bucket->size++;
+}
+
+radix_heap_t *
+radix_heap_new(radix_heap_update_t update)
+{
+    radix_heap_t *h = calloc(1, sizeof(radix_heap_t));
+
+    if (NULL != h) {
+        h->update = update;
+    }
+    return h;
+}
+
+int
+radix_heap_insert(radix_heap_t *h, unsigned long key, void *data)
+{
+    size_t b = radix_heap_bucket_of(h, key);
+
+    if (radix_heap_bucket_reserve(&h->buckets[b], 1) < 0) {
+        return -1;
+    }
+    radix_heap_bucket_push(h, b, key, data);
+    h->size++;
+
+    return 0;
+}
+
+int
+radix_heap_decrease(radix_heap_t *h, size_t handle, unsigned long key)
+{
+    size_t b = radix_heap_handle_bucket(handle);
+    size_t i = radix_heap_handle_index(handle);
+    radix_heap_bucket_t *bucket = &h->buckets[b];
+    size_t nb = radix_heap_bucket_of(h, key);
+    void *data = bucket->entries[i].data;
+
+    if (nb == b) {
+        bucket->entries[i].key = key;
+        return 0;
+    }
+    if (radix_heap_bucket_reserve(&h->buckets[nb], 1) < 0) {
+        return -1;
+    }
+
+    bucket->entries[i] = bucket->entries[--bucket->size];
+    if (i < bucket->size && h->update) {
+        h->update(bucket->entries[i].data, radix_heap_handle(b, i));
+    }
+
+    radix_heap_bucket_push(h, nb, key, data);
+
+    return 0;
+}
+
+void *
+radix_heap_pop_front(radix_heap_t *h, unsigned long *key)
+{
+    radix_heap_bucket_t *bucket = &h->buckets[0];
+    void *data;
+
+    if (0 == h->size) {
+        return NULL;
+    }
+
+    if (0 == bucket->size) {
+        size_t count[RADIX_HEAP_BUCKETS] = { 0 };
+        unsigned long last = h->last;
+        size_t b = 1;
+        size_t i;
+        size_t n;
+
+        while (0 == h->buckets[b].size) {
+            ++b;
+        }
+        bucket = &h->buckets[b];
+
+        h->last = bucket->entries[0].key;
+        for (i = 1; i < bucket->size; ++i) {
+            if (bucket->entries[i].key < h->last) {
+                h->last = bucket->entries[i].key;
+            }
+        }
+
+        /**
+         * Every entry goes to a lower bucket: room is made for all of
+         * them first, so that nothing is left half moved.
+         */
+        for (i = 0; i < bucket->size; ++i) {
+            count[radix_heap_bucket_of(h, bucket->entries[i].key)]++;
+        }
+        for (i = 0; i < b; ++i) {
+            if (radix_heap_bucket_reserve(&h->buckets[i], count[i]) < 0) {
+                h->last = last;
+                return NULL;
+            }
+        }
+
+        n = bucket->size;
+        bucket->size = 0;
+        for (i = 0; i < n; ++i) {
+            radix_heap_entry_t *e = &bucket->entries[i];
+            radix_heap_bucket_push(h, radix_heap_bucket_of(h, e->key), e->key, e->data);
+        }
+        bucket = &h->buckets[0];
+    }
+
+    data = bucket->entries[--bucket->size].data;
+    if (NULL != key) {
+        *key = h->last;
+    }
+    h->size--;
+
+    return data;
+}
+
+void
+radix_heap_clear(radix_heap_t *h)
+{
+    for (size_t b = 0; b < RADIX_HEAP_BUCKETS; ++b) {
+        h->buckets[b].size = 0;
+    }
+    h->size = 0;
+    h->last = 0;
+}
+
+void
+radix_heap_free(radix_heap_t *h)
+{
+    for (size_t b = 0; b < RADIX_HEAP_BUCKETS; ++b) {
+        free(h->buckets[b].entries);
+    }
+    free(h);
+}
+
+size_t
+radix_heap_size(radix_heap_t *h)
+{
+    return h->size;
+}
@@ -0,0 +1,110 @@
+#ifndef _RADIX_HEAP__H_
+#define _RADIX_HEAP__H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Monotone priority queue on unsigned integer keys (radix heap).
+ *
+ * Keys inserted must never be less than the last key removed from the
+ * heap, which holds for Dijkstra with non-negative integer weights.
+ *
+ * Elements live in 65 buckets: bucket 0 holds keys equal to the last key
+ * removed (last), bucket i > 0 keys whose most significant bit differing
+ * from last is bit i - 1. Removing the minimum from an empty bucket 0
+ * takes the first non empty bucket, makes its minimum the new last and
+ * redistributes its elements into lower buckets. An element only moves
+ * down, so it's moved at most log(C) times, C being the largest
+ * difference between keys, and every move is a sequential bucket scan
+ * without any comparison callback.
+ */
+
+/**
+ * Called whenever respective object moves through the heap.
+ *
+ * Second parameter provides new handle of this object, to be given
+ * to radix_heap_decrease.
+ */
+typedef void (*radix_heap_update_t)(void *, size_t);
+
+typedef struct radix_heap radix_heap_t;
+
+/**
+ * Allocates new radix heap object.
+ *
+ * @param update function to update handle of objects as they are moved
+ *        through the heap. If radix_heap_decrease will never be used,
+ *        no need to provide this function.
+ * @return radix heap object or NULL in case of error.
+ */
+radix_heap_t *
+radix_heap_new(radix_heap_update_t update);
+
+/**
+ * Inserts object with key in the heap.
+ *
+ * It's an O(1) amortized time operation.
+ *
+ * @param h radix heap object
+ * @param key key of the object, not less than the last key removed
+ * @param data object to be inserted
+ * @return 0 on success, -1 otherwise
+ */
+int
+radix_heap_insert(radix_heap_t *h, unsigned long key, void *data);
+
+/**
+ * Decreases key of an object in the heap.
+ *
+ * It's an O(1) amortized time operation.
+ *
+ * @param h radix heap object
+ * @param handle last handle given to update callback for the object
+ * @param key new key, not greater than the current one and not less
+ *        than the last key removed
+ * @return 0 on success, -1 otherwise (key is left unchanged)
+ */
+int
+radix_heap_decrease(radix_heap_t *h, size_t handle, unsigned long key);
+
+/**
+ * Removes object with minimum key from the heap.
+ *
+ * It's an O(log(C)) amortized time operation.
+ *
+ * @param h radix heap object
+ * @param key pointer to a buffer in which store key of object removed
+ *        (optional)
+ * @return object removed, NULL if heap is empty or on allocation failure
+ *         (heap is left unchanged).
+ */
+void *
+radix_heap_pop_front(radix_heap_t *h, unsigned long *key);
+
+/**
+ * Removes every object from the heap, keeping its storage, and allows
+ * any key to be inserted again.
+ *
+ * @param h radix heap object
+ */
+void
+radix_heap_clear(radix_heap_t *h);
+
+/**
+ * Releases radix heap object.
+ *
+ * @param h radix heap object
+ */
+void
+radix_heap_free(radix_heap_t *h);
+
+/**
+ * Returns current number of objects in the heap.
+ *
+ * @param h radix heap object
+ */
+size_t
+radix_heap_size(radix_heap_t *h);
+
+#endif /* _RADIX_HEAP__H_ */
@@ -0,0 +1,138 @@
+#include "rollback_disjoint_sets.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+ * parent[i] >= 0 is parent of i, parent[i] < 0 makes i a root of a set
+ * of -parent[i] elements (see disjoint_sets.c). Every log entry is a
+ * root that was linked below another one, along with its set size.
+ */
+typedef struct rollback_entry rollback_entry_t;
+
+struct rollback_entry {
+    int32_t child;
+    int32_t size;
+};
+
+struct rollback_disjoint_sets {
+    int n;
+    int components;
+    int32_t *parent;
+    rollback_entry_t *log;
+    size_t nlog;
+    size_t log_capacity;
+};
+
+rollback_disjoint_sets_t *
+rollback_disjoint_sets_new(int n)
+{
+    rollback_disjoint_sets_t *ds = calloc(1, sizeof(rollback_disjoint_sets_t));
+    if (NULL != ds) {
+        ds->parent = malloc((n > 0 ? n : 1) * sizeof(int32_t));
+        if (NULL == ds->parent) {
+            goto error;
+        }
+        for (int i = 0; i < n; ++i) {
+            ds->parent[i] = -1;
+        }
+        ds->n = n;
+        ds->components = n;
+    }
+    return ds;
+
+error:
+    rollback_disjoint_sets_free(ds);
+    return NULL;
+}
+
+void
+rollback_disjoint_sets_free(rollback_disjoint_sets_t *ds)
+{
+    if (NULL != ds) {
+        free(ds->parent);
+        free(ds->log);
+        ds->parent = NULL;
+        ds->log = NULL;
+        free(ds);
+    }
+}
+
+int
+rollback_disjoint_sets_find(rollback_disjoint_sets_t *ds, int i)
+{
+    while (ds->parent[i] >= 0) {
+        i = ds->parent[i];
+    }
+    return i;
+}
+
+int
+rollback_disjoint_sets_union(rollback_disjoint_sets_t *ds, int i, int j)
+{
+    int parent = rollback_disjoint_sets_find(ds, i);
+    int child = rollback_disjoint_sets_find(ds, j);
+
+    if (parent == child) {
+        return 0;
+    }
+
+    if (ds->nlog == ds->log_capacity) {
+        size_t capacity = ds->log_capacity ? 2 * ds->log_capacity : 16;
+        rollback_entry_t *log = realloc(ds->log, capacity * sizeof(rollback_entry_t));
+        if (NULL == log) {
+            return -1;
+        }
+        ds->log = log;
+        ds->log_capacity = capacity;
+    }
+
+    /**
+     * Sizes are negative: larger set has smaller value.
+     */
+    if (ds->parent[parent] > ds->parent[child]) {
+        int t = parent;
+        parent = child;
+        child = t;
+    }
+
+    ds->log[ds->nlog].child = child;
+    ds->log[ds->nlog].size = ds->parent[child];
+    ds->nlog++;
+
+    ds->parent[parent] += ds->parent[child];
+    ds->parent[child] = parent;
+    ds->components--;
+
+    return 1;
+}
+
+bool
+rollback_disjoint_sets_same_set(rollback_disjoint_sets_t *ds, int i, int j)
+{
+    return rollback_disjoint_sets_find(ds, i) == rollback_disjoint_sets_find(ds, j);
+}
+
+int
+rollback_disjoint_sets_components(rollback_disjoint_sets_t *ds)
+{
+    return ds->components;
+}
+
+size_t
+rollback_disjoint_sets_checkpoint(rollback_disjoint_sets_t *ds)
+{
+    return ds->nlog;
+}
+
+void
+rollback_disjoint_sets_rollback(rollback_disjoint_sets_t *ds, size_t checkpoint)
+{
+    while (ds->nlog > checkpoint) {
+        rollback_entry_t *e = &ds->log[--ds->nlog];
+        int parent = ds->parent[e->child];
+
+        ds->parent[parent] -= e->size;
+        ds->parent[e->child] = e->size;
+        ds->components++;
+    }
+}
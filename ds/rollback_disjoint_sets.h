@@ -0,0 +1,62 @@
+#ifndef _ROLLBACK_DISJOINT_SETS__H_
+#define _ROLLBACK_DISJOINT_SETS__H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Disjoint sets whose unions can be undone in reverse order.
+ *
+ * Union by size without path compression: a union only changes the
+ * parent of one root and the size of another one, which is recorded in
+ * a log. Rolling back to a checkpoint pops log entries restoring both.
+ * Without compression trees stay O(log(n)) high, so find is O(log(n)).
+ */
+
+typedef struct rollback_disjoint_sets rollback_disjoint_sets_t;
+
+/**
+ * Allocates disjoint sets of n elements, every one in a set of its own.
+ */
+rollback_disjoint_sets_t *
+rollback_disjoint_sets_new(int n);
+
+void
+rollback_disjoint_sets_free(rollback_disjoint_sets_t *ds);
+
+int
+rollback_disjoint_sets_find(rollback_disjoint_sets_t *ds, int i);
+
+/**
+ * Merges sets of i and j.
+ *
+ * @return 1 if sets were merged, 0 if already the same set,
+ *         -1 on allocation failure (sets are left unchanged).
+ */
+int
+rollback_disjoint_sets_union(rollback_disjoint_sets_t *ds, int i, int j);
+
+bool
+rollback_disjoint_sets_same_set(rollback_disjoint_sets_t *ds, int i, int j);
+
+/**
+ * Returns current number of sets.
+ */
+int
+rollback_disjoint_sets_components(rollback_disjoint_sets_t *ds);
+
+/**
+ * Returns a checkpoint to give to rollback_disjoint_sets_rollback.
+ */
+size_t
+rollback_disjoint_sets_checkpoint(rollback_disjoint_sets_t *ds);
+
+/**
+ * Undoes every union that merged two sets since checkpoint was taken.
+ *
+ * It's an O(k) time operation, k being number of such unions.
+ */
+void
+rollback_disjoint_sets_rollback(rollback_disjoint_sets_t *ds, size_t checkpoint);
+
+#endif /* _ROLLBACK_DISJOINT_SETS__H_ */